@@ -152,6 +152,10 @@ SOURCE=..\..\src\video\SDL_blit_N.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\video\SDL_blit_auto.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\video\SDL_bmp.c
 # End Source File
 # Begin Source File
@@ -172,6 +176,14 @@ SOURCE=..\..\src\video\SDL_cursor_c.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\video\SDL_damage.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\video\SDL_damage_c.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\audio\windib\SDL_dibaudio.c
 # End Source File
 # Begin Source File
@@ -272,6 +284,10 @@ SOURCE=..\..\src\SDL_fatal.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\timer\SDL_framepace.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\video\SDL_gamma.c
 # End Source File
 # Begin Source File
@@ -356,6 +372,14 @@ SOURCE=..\..\src\video\SDL_pixels_c.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\video\SDL_present.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\video\SDL_present_c.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\stdlib\SDL_qsort.c
 # End Source File
 # Begin Source File
@@ -400,6 +424,14 @@ SOURCE=..\..\src\video\SDL_surface.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\video\SDL_surfacepool.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\video\SDL_surfacepool_c.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\audio\SDL_sysaudio.h
 # End Source File
 # Begin Source File
@@ -496,6 +528,14 @@ SOURCE=..\..\src\timer\SDL_timer_c.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\video\SDL_timing.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\video\SDL_timing_c.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\video\SDL_video.c
 # End Source File
 # Begin Source File
@@ -57,9 +57,45 @@ extern DECLSPEC SDL_bool SDLCALL SDL_HasSSE(void);
 /** This function returns true if the CPU has SSE2 features */
 extern DECLSPEC SDL_bool SDLCALL SDL_HasSSE2(void);
 
+/** This function returns true if the CPU (and OS) support AVX2 features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasAVX2(void);
+
 /** This function returns true if the CPU has AltiVec features */
 extern DECLSPEC SDL_bool SDLCALL SDL_HasAltiVec(void);
 
+/** This function returns true if the CPU has ARMv6 SIMD (media) features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasARMSIMD(void);
+
+/** This function returns true if the CPU has VFPv3 features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasVFPv3(void);
+
+/** This function returns true if the CPU has VFPv4 features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasVFPv4(void);
+
+/** This function returns true if the CPU has NEON (AArch64 ASIMD) features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasNEON(void);
+
+/**
+ *  @name CPU feature override
+ *  If the SDL_CPU_FEATURE_MASK environment variable is set, it is parsed
+ *  as an integer (decimal, or hex with a 0x prefix) and ANDed with the
+ *  detected features before any of the functions above report them, so
+ *  SIMD code paths can be switched off for testing and benchmarking:
+ *	- 0x0001 RDTSC
+ *	- 0x0002 MMX
+ *	- 0x0004 MMX Ext.
+ *	- 0x0010 3DNow
+ *	- 0x0020 3DNow Ext.
+ *	- 0x0040 SSE
+ *	- 0x0080 SSE2
+ *	- 0x0100 AltiVec
+ *	- 0x0200 ARMv6 SIMD
+ *	- 0x0400 VFPv3
+ *	- 0x0800 VFPv4
+ *	- 0x1000 NEON
+ *	- 0x2000 AVX2
+ */
+
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
 }
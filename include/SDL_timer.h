@@ -116,6 +116,57 @@ extern DECLSPEC SDL_bool SDLCALL SDL_RemoveTimer(SDL_TimerID t);
 
 /*@}*/
 
+/** @name Frame pacing
+ *  Waiting for the start of each frame of a fixed frame rate
+ */
+/*@{*/
+
+/** Frame pacing counters, see SDL_GetFrameStats() */
+typedef struct SDL_FrameStats {
+	Uint32 frames;		/**< Calls to SDL_WaitFrame() */
+	Uint32 missed;		/**< Frames that began after their deadline */
+	Uint32 jitter_avg;	/**< Average time from a deadline to the
+				     return of SDL_WaitFrame(), in nanoseconds */
+	Uint32 jitter_max;	/**< Largest time from a deadline to the
+				     return of SDL_WaitFrame(), in nanoseconds */
+	Uint32 spin;		/**< How long before a deadline SDL_WaitFrame()
+				     now wakes up to spin, in nanoseconds */
+} SDL_FrameStats;
+
+/** SDL_Flip() calls SDL_WaitFrame() before showing the frame */
+#define SDL_FRAME_FLIP		0x00000001
+
+/**
+ * Set the length of a frame for SDL_WaitFrame(), in nanoseconds, for
+ * example 16638935 for 60.0988 Hz.  A period of 0 turns pacing off.
+ * 'flags' can be SDL_FRAME_FLIP.  The next SDL_WaitFrame() returns right
+ * away and starts counting frames from there.
+ *
+ * This function returns 0 if successful, or -1 if there was an error.
+ */
+extern DECLSPEC int SDLCALL SDL_SetFramePeriod(Uint32 period_ns, Uint32 flags);
+
+/**
+ * Wait for the start of the next frame.  The deadlines are kept on a
+ * nanosecond timeline, so they don't drift.  SDL_WaitFrame() sleeps until
+ * shortly before the deadline and spins for the rest, for a precision
+ * SDL_Delay() can't give; the SDL_FRAME_SPIN_MAX environment variable
+ * limits the spin, in microseconds (default 2000).  A frame more than one
+ * period late isn't caught up on, the timeline starts over instead, and
+ * so it does when the clock goes backwards and the next deadline ends up
+ * more than a period away.
+ */
+extern DECLSPEC void SDLCALL SDL_WaitFrame(void);
+
+/**
+ * Fills 'stats' with counters of the frames SDL_WaitFrame() has waited
+ * for, since the first call or the last reset.
+ * The counters are zeroed after reading if 'reset' is non-zero.
+ */
+extern DECLSPEC void SDLCALL SDL_GetFrameStats(SDL_FrameStats *stats, int reset);
+
+/*@}*/
+
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
 }
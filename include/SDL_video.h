@@ -133,6 +133,11 @@ typedef struct SDL_Surface {
 #define SDL_ASYNCBLIT	0x00000004	/**< Use asynchronous blits if possible */
 /*@}*/
 
+/** Available for SDL_CreateRGBSurface() */
+/*@{*/
+#define SDL_SIMDALIGNED	0x00000040	/**< Pixels and pitch are cache line aligned */
+/*@}*/
+
 /** Available for SDL_SetVideoMode() */
 /*@{*/
 #define SDL_ANYFORMAT	0x10000000	/**< Allow any video depth/pixel-format */
@@ -187,6 +192,68 @@ typedef struct SDL_VideoInfo {
 	int    current_h;	/**< Value: The current video mode height */
 } SDL_VideoInfo;
 
+/** Screen update counters, see SDL_GetUpdateStats() */
+typedef struct SDL_UpdateStats {
+	Uint32 updates;		/**< Calls to SDL_UpdateRects() */
+	Uint32 rects_in;	/**< Rectangles passed to SDL_UpdateRects() */
+	Uint32 rects_out;	/**< Rectangles passed on to the video driver */
+	Uint32 pixels_in;	/**< Pixels in the rectangles passed in */
+	Uint32 pixels_out;	/**< Pixels in the rectangles passed on */
+	Uint32 tiles_checked;	/**< Tiles compared for SDL_VIDEO_FRAME_DIFF */
+	Uint32 tiles_changed;	/**< Compared tiles that had changed */
+	Uint32 frames_queued;	/**< Flips handed to SDL_VIDEO_PRESENT_THREAD */
+	Uint32 frames_dropped;	/**< Queued frames replaced before they were
+				     shown, with SDL_VIDEO_PRESENT_THREAD=drop */
+	Uint32 frames_waited;	/**< Flips that waited for the present thread */
+} SDL_UpdateStats;
+
+/** Blit mapping cache counters, see SDL_GetBlitCacheStats() */
+typedef struct SDL_BlitCacheStats {
+	Uint32 blit_hits;	/**< Blit functions found in the cache */
+	Uint32 blit_misses;	/**< Blit functions chosen from scratch */
+	Uint32 table_hits;	/**< Color translation tables reused */
+	Uint32 table_misses;	/**< Color translation tables built */
+	Uint32 rle_encoded;	/**< Surfaces RLE encoded for blitting */
+	Uint32 rle_skipped;	/**< Colorkey surfaces given a SIMD blitter
+				     instead of RLE, see SDL_VIDEO_RLE_MIN_PIXELS */
+	Uint32 rle_unchanged;	/**< Unlocks that kept the RLE encoding, see
+				     SDL_PREPARE_KEEPRAW */
+} SDL_BlitCacheStats;
+
+/** Surface pool counters, see SDL_GetSurfacePoolStats() */
+typedef struct SDL_SurfacePoolStats {
+	Uint32 hits;		/**< Surfaces created from the pool */
+	Uint32 misses;		/**< Pooled sizes created from scratch */
+	Uint32 recycled;	/**< Freed surfaces kept in the pool */
+	Uint32 dropped;		/**< Freed surfaces the pool had no room for */
+	Uint32 surfaces;	/**< Surfaces in the pool now */
+	Uint32 bytes;		/**< Bytes of pixels in the pool now */
+} SDL_SurfacePoolStats;
+
+/** Timed parts of the screen update path, see SDL_GetVideoTiming() */
+typedef enum {
+	SDL_TIMING_FLIP,		/**< SDL_Flip() */
+	SDL_TIMING_UPDATERECTS,		/**< SDL_UpdateRects() */
+	SDL_TIMING_CONVERT,		/**< Blits from the shadow surface to
+					     the screen */
+	SDL_TIMING_CURSOR,		/**< Drawing and erasing the software
+					     cursor for an update */
+	SDL_TIMING_DRIVER_UPDATE,	/**< The video driver's UpdateRects */
+	SDL_TIMING_DRIVER_FLIP,		/**< The video driver's page flip,
+					     including any wait for vsync */
+	SDL_TIMING_BLIT,		/**< SDL_LowerBlit() */
+	SDL_NUM_TIMINGS
+} SDL_TimingPoint;
+
+/** Call times, see SDL_GetVideoTiming() */
+typedef struct SDL_TimingStats {
+	Uint32 count;	/**< Calls timed since the last reset */
+	Uint32 p50;	/**< Median of the last 1024 calls, in nanoseconds */
+	Uint32 p95;	/**< 95th percentile of the last 1024 calls */
+	Uint32 p99;	/**< 99th percentile of the last 1024 calls */
+	Uint32 max;	/**< Longest call since the last reset */
+} SDL_TimingStats;
+
 
 /** @name Overlay Formats
  *  The most common video overlay formats.
@@ -399,6 +466,25 @@ extern DECLSPEC void SDLCALL SDL_UpdateRects
  */
 extern DECLSPEC void SDLCALL SDL_UpdateRect
 		(SDL_Surface *screen, Sint32 x, Sint32 y, Uint32 w, Uint32 h);
+/**
+ * Fills in counters of the rectangles passed to SDL_UpdateRects() and
+ * the rectangles actually passed on to the video driver since video
+ * initialization or the last reset.  The two differ when the
+ * SDL_VIDEO_COALESCE_RECTS environment variable is set, which makes SDL
+ * merge overlapping and nearby rectangles before updating the screen, or
+ * when SDL_VIDEO_FRAME_DIFF is set, which makes SDL skip the parts of
+ * the screen that haven't changed since they were last updated.
+ * The frame counters are for the SDL_VIDEO_PRESENT_THREAD environment
+ * variable, which makes SDL_Flip() of a shadow surface return once the
+ * frame is copied and leaves the conversion and the driver update to a
+ * separate thread.  It can be set to "block" or to "drop", which decides
+ * what SDL_Flip() does when that thread is two frames behind.  Only the
+ * fbcon, dispmanx and dummy drivers, which can update the screen from
+ * any thread, use it.
+ * The counters are zeroed after reading if 'reset' is non-zero.
+ */
+extern DECLSPEC void SDLCALL SDL_GetUpdateStats
+		(SDL_UpdateStats *stats, int reset);
 /*@}*/
 
 /**
@@ -549,6 +635,13 @@ extern DECLSPEC void SDLCALL SDL_GetRGBA(Uint32 pixel,
  * will be set in the flags member of the returned surface.  If for some
  * reason the surface could not be placed in video memory, it will not have
  * the SDL_HWSURFACE flag set, and will be created in system memory instead.
+ * SDL_SIMDALIGNED asks for a system memory surface whose pitch is a multiple
+ * of 64 bytes and whose pixels start on a 64 byte boundary, where the C
+ * library can allocate aligned memory.  Whole rows of such a surface never
+ * straddle a cache line, and the SIMD blitters use aligned loads and stores
+ * on them.  The flag is kept in the flags member of the returned surface,
+ * and SDL_DisplayFormat() passes it on.  Shadow surfaces made by
+ * SDL_SetVideoMode() are always aligned this way.
  */
 extern DECLSPEC SDL_Surface * SDLCALL SDL_CreateRGBSurface
 			(Uint32 flags, int width, int height, int depth, 
@@ -755,6 +848,78 @@ extern DECLSPEC int SDLCALL SDL_LowerBlit
 			(SDL_Surface *src, SDL_Rect *srcrect,
 			 SDL_Surface *dst, SDL_Rect *dstrect);
 
+/** @name SDL_PrepareSurface() flags */
+/*@{*/
+#define SDL_PREPARE_ASYNC	0x00000001	/**< Encode on a background thread */
+#define SDL_PREPARE_KEEPRAW	0x00000002	/**< Keep raw pixels with the encoding */
+/*@}*/
+
+/**
+ * Does the work SDL would otherwise do on the first blit of 'src' to
+ * 'dst', such as RLE encoding a surface with SDL_RLEACCEL, so it doesn't
+ * hold up a later frame.  The flags stay with 'src' and also apply when
+ * it's encoded again after a lock or a colorkey or alpha change:
+ *
+ * SDL_PREPARE_ASYNC encodes on a background thread and returns at once.
+ * Until the encoding is ready 'src' is blitted from its raw pixels, and
+ * it must be locked to change them.  Large surfaces are encoded by the
+ * SDL_BLIT_THREADS workers when this isn't set.
+ *
+ * SDL_PREPARE_KEEPRAW keeps the raw pixels along with the encoding, so
+ * locking 'src' doesn't have to decode it, and unlocking it only encodes
+ * it again if the pixels changed.  This costs the memory of both.
+ *
+ * Returns 0, or -1 if 'src' can't be blitted to 'dst'.
+ */
+extern DECLSPEC int SDLCALL SDL_PrepareSurface
+			(SDL_Surface *src, SDL_Surface *dst, Uint32 flags);
+
+/**
+ * Returns the name of the internal blit function SDL uses to blit 'src'
+ * to the surface it was last blitted to, or NULL (and sets the error)
+ * if 'src' hasn't been blitted yet.  This is meant for benchmarks and
+ * debugging; the names change between SDL versions and CPUs.
+ */
+extern DECLSPEC const char * SDLCALL SDL_GetBlitterName(SDL_Surface *src);
+
+/**
+ * Fills 'stats' with the hit and miss counts of the process wide caches
+ * SDL uses when a surface is remapped for blitting, after a palette,
+ * colorkey or alpha change or when blitting to a new destination, and
+ * with how often RLE acceleration was used or passed over.
+ * The counters are zeroed after reading if 'reset' is non-zero.
+ */
+extern DECLSPEC void SDLCALL SDL_GetBlitCacheStats
+		(SDL_BlitCacheStats *stats, int reset);
+
+/**
+ * Fills 'stats' with how often SDL_CreateRGBSurface() reused a software
+ * surface freed earlier instead of allocating a new one, and with what
+ * the pool holds right now.  The pool is off unless SDL_VIDEO_SURFACE_POOL
+ * sets how many bytes it may keep; then surfaces of up to 256K of pixels
+ * are pooled while video is initialized, with their pixels rounded up to
+ * a power of two.
+ * The hits, misses, recycled and dropped counters are zeroed after
+ * reading if 'reset' is non-zero.
+ */
+extern DECLSPEC void SDLCALL SDL_GetSurfacePoolStats
+		(SDL_SurfacePoolStats *stats, int reset);
+
+/**
+ * Fills 'stats' with how long one part of putting frames on the screen
+ * has taken, so the conversion from the shadow surface, the software
+ * cursor and the driver, including its wait for vsync, can be told apart.
+ * Timing is off unless the SDL_VIDEO_TIMING environment variable is set
+ * to 1 before video is initialized, or to "dump" to also have the times
+ * printed to stderr when video is shut down.
+ * The counters for 'point' are cleared after reading if 'reset' is
+ * non-zero.
+ *
+ * This function returns 0 if successful, or -1 if timing is off.
+ */
+extern DECLSPEC int SDLCALL SDL_GetVideoTiming
+		(SDL_TimingPoint point, SDL_TimingStats *stats, int reset);
+
 /**
  * This function performs a fast fill of the given rectangle with 'color'
  * The given rectangle is clipped to the destination surface clip area
@@ -941,6 +1106,52 @@ extern DECLSPEC SDL_GrabMode SDLCALL SDL_WM_GrabInput(SDL_GrabMode mode);
 /** @internal Not in public API at the moment - do not use! */
 extern DECLSPEC int SDLCALL SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
                                     SDL_Surface *dst, SDL_Rect *dstrect);
+
+/**
+ * Scales the source rectangle up by an integer factor by replicating
+ * pixels and rows, which is much faster than a general stretch.  Both
+ * surfaces must have the same pixel format.  Only the x and y of dstrect
+ * are used; on return its w and h are set to the scaled size.  The
+ * destination may be the video surface, followed by SDL_UpdateRect().
+ *
+ * SDL_SoftStretch() switches to the same code automatically when the
+ * destination size is an exact multiple of the source size.  For factors
+ * that aren't powers of two, such as 3x or 5x, that changes its output
+ * from earlier versions: every pixel is now replicated exactly, where the
+ * general stretch made some pixels a row or column wider than others.
+ *
+ * @return 0 on success, or -1 on error
+ */
+extern DECLSPEC int SDLCALL SDL_SoftScaleInteger(SDL_Surface *src, SDL_Rect *srcrect,
+                                    SDL_Surface *dst, SDL_Rect *dstrect,
+                                    int factor);
+
+/** Filters for SDL_SoftStretchFilter() */
+typedef enum {
+	SDL_STRETCH_NEAREST,		/**< Nearest neighbour */
+	SDL_STRETCH_BILINEAR,		/**< Bilinear interpolation */
+	SDL_STRETCH_SHARP_BILINEAR	/**< Integer prescale, then bilinear */
+} SDL_StretchFilter;
+
+/**
+ * Performs a scaled software blit from the source rectangle to the
+ * destination rectangle, converting between pixel formats as it goes.
+ * NULL rectangles stand for the whole surface.  Neither rectangle is
+ * clipped, and the source colorkey and alpha are ignored.
+ *
+ * SDL_STRETCH_SHARP_BILINEAR replicates pixels by the largest integer
+ * factor that fits and only interpolates across the remaining fraction,
+ * which keeps upscaled pixel art crisp without uneven pixel sizes.
+ *
+ * Filtered stretches into 8-bit surfaces are not supported.  Unlike
+ * SDL_SoftStretch() this function is safe to call from multiple threads
+ * on different destination surfaces.
+ *
+ * @return 0 on success, or -1 on error
+ */
+extern DECLSPEC int SDLCALL SDL_SoftStretchFilter(SDL_Surface *src, SDL_Rect *srcrect,
+                                    SDL_Surface *dst, SDL_Rect *dstrect,
+                                    SDL_StretchFilter filter);
                     
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
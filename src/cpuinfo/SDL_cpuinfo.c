@@ -33,6 +33,14 @@
 #include <setjmp.h>
 #endif
 
+#if defined(__linux__) && (defined(__arm__) || defined(__aarch64__))
+#define CPU_LINUX_ARM
+#if HAVE_GETAUXVAL && HAVE_SYS_AUXV_H
+#include <sys/auxv.h>	/* For ARM HWCAP check */
+#endif
+#include <stdio.h>
+#endif
+
 #define CPU_HAS_RDTSC	0x00000001
 #define CPU_HAS_MMX	0x00000002
 #define CPU_HAS_MMXEXT	0x00000004
@@ -41,6 +49,11 @@
 #define CPU_HAS_SSE	0x00000040
 #define CPU_HAS_SSE2	0x00000080
 #define CPU_HAS_ALTIVEC	0x00000100
+#define CPU_HAS_ARMSIMD	0x00000200
+#define CPU_HAS_VFPV3	0x00000400
+#define CPU_HAS_VFPV4	0x00000800
+#define CPU_HAS_NEON	0x00001000
+#define CPU_HAS_AVX2	0x00002000
 
 #if SDL_ALTIVEC_BLITTERS && HAVE_SETJMP && !__MACOSX__
 /* This is the brute force way of detecting instruction sets...
@@ -356,6 +369,64 @@ static __inline__ int CPU_haveSSE2(void)
 	return 0;
 }
 
+/* %ebx may be the PIC register on i386, so save it by hand.  All of %rbx
+   has to be saved on x86_64, writing %ebx clears the upper half. */
+#if defined(__GNUC__) && defined(__x86_64__)
+#define CPUID_SAVE_BX	"        movq    %%rbx,%%rsi                                           \n"
+#define CPUID_LOAD_BX	"        xchgq   %%rbx,%%rsi                                           \n"
+#else
+#define CPUID_SAVE_BX	"        movl    %%ebx,%%esi                                           \n"
+#define CPUID_LOAD_BX	"        xchgl   %%ebx,%%esi                                           \n"
+#endif
+
+static __inline__ int CPU_haveAVX2(void)
+{
+	int avx2 = 0;
+#if defined(__GNUC__) && (defined(i386) || defined(__x86_64__))
+	/* AVX2 needs CPU support for the instructions, and OS support
+	   (OSXSAVE, with the YMM state enabled in XCR0) for the registers */
+	if ( CPU_haveCPUID() ) {
+		unsigned long b;
+		unsigned int a, c, d;
+		__asm__ (
+CPUID_SAVE_BX
+"        cpuid                                                         \n"
+CPUID_LOAD_BX
+		: "=a" (a), "=S" (b), "=c" (c), "=d" (d)
+		: "a" (0), "c" (0)
+		);
+		if ( a >= 7 ) {
+			__asm__ (
+CPUID_SAVE_BX
+"        cpuid                                                         \n"
+CPUID_LOAD_BX
+			: "=a" (a), "=S" (b), "=c" (c), "=d" (d)
+			: "a" (1), "c" (0)
+			);
+			if ( (c & 0x18000000) == 0x18000000 ) {
+				/* xgetbv, spelled out for older assemblers */
+				__asm__ (
+"        .byte   0x0f, 0x01, 0xd0                                      \n"
+				: "=a" (a), "=d" (d)
+				: "c" (0)
+				);
+				if ( (a & 0x6) == 0x6 ) {
+					__asm__ (
+CPUID_SAVE_BX
+"        cpuid                                                         \n"
+CPUID_LOAD_BX
+					: "=a" (a), "=S" (b), "=c" (c), "=d" (d)
+					: "a" (7), "c" (0)
+					);
+					avx2 = (int)(b & 0x00000020);
+				}
+			}
+		}
+	}
+#endif
+	return avx2;
+}
+
 static __inline__ int CPU_haveAltiVec(void)
 {
 	volatile int altivec = 0;
@@ -381,6 +452,161 @@ static __inline__ int CPU_haveAltiVec(void)
 	return altivec; 
 }
 
+#ifdef CPU_LINUX_ARM
+/* These match the kernel's <asm/hwcap.h>, which isn't always installed */
+#define ARM_AT_PLATFORM		15
+#define ARM_AT_HWCAP		16
+#if defined(__aarch64__)
+#define ARM_HWCAP_FP		(1 << 0)
+#define ARM_HWCAP_ASIMD		(1 << 1)
+#else
+#define ARM_HWCAP_NEON		(1 << 12)
+#define ARM_HWCAP_VFPv3		(1 << 13)
+#define ARM_HWCAP_VFPv4		(1 << 16)
+#endif
+
+static unsigned long CPU_getAuxVal(unsigned long type)
+{
+	unsigned long value = 0;
+#if HAVE_GETAUXVAL && HAVE_SYS_AUXV_H
+	value = getauxval(type);
+#else
+	unsigned long entry[2];
+	FILE *fp = fopen("/proc/self/auxv", "rb");
+	if ( fp ) {
+		while ( fread(entry, sizeof(entry), 1, fp) == 1 && entry[0] ) {
+			if ( entry[0] == type ) {
+				value = entry[1];
+				break;
+			}
+		}
+		fclose(fp);
+	}
+#endif
+	return value;
+}
+
+/* Fallback for kernels (or sandboxes) that don't give us the aux vector */
+static int CPU_parseProcCPUInfo(void)
+{
+	int features = 0;
+	char line[1024];
+	FILE *fp = fopen("/proc/cpuinfo", "r");
+	if ( !fp ) {
+		return 0;
+	}
+	while ( fgets(line, sizeof(line), fp) ) {
+		if ( SDL_strncmp(line, "Features", 8) == 0 ) {
+			/* Pad with spaces so we only match whole words */
+			char words[1024+2];
+			char *colon = SDL_strchr(line, ':');
+			char *eol;
+			if ( !colon ) {
+				continue;
+			}
+			SDL_snprintf(words, sizeof(words), "%s ", colon);
+			eol = SDL_strchr(words, '\n');
+			if ( eol ) {
+				*eol = ' ';
+			}
+			*words = ' ';
+			if ( SDL_strstr(words, " neon ") || SDL_strstr(words, " asimd ") ) {
+				features |= CPU_HAS_NEON;
+			}
+			if ( SDL_strstr(words, " vfpv3 ") || SDL_strstr(words, " fp ") ) {
+				features |= CPU_HAS_VFPV3;
+			}
+			if ( SDL_strstr(words, " vfpv4 ") || SDL_strstr(words, " fp ") ) {
+				features |= CPU_HAS_VFPV4;
+			}
+		} else if ( SDL_strncmp(line, "CPU architecture", 16) == 0 ) {
+			char *value = SDL_strchr(line, ':');
+			if ( value && SDL_atoi(value+1) >= 6 ) {
+				features |= CPU_HAS_ARMSIMD;
+			}
+		}
+	}
+	fclose(fp);
+#if defined(__aarch64__)
+	/* The ARMv6 media instructions are AArch32 only */
+	features &= ~CPU_HAS_ARMSIMD;
+#endif
+	return features;
+}
+#endif /* CPU_LINUX_ARM */
+
+static int CPU_getARMFeatures(void)
+{
+	static int features = -1;
+	if ( features != -1 ) {
+		return features;
+	}
+	features = 0;
+#if defined(CPU_LINUX_ARM)
+	{
+		unsigned long hwcap = CPU_getAuxVal(ARM_AT_HWCAP);
+		if ( hwcap ) {
+#if defined(__aarch64__)
+			/* AArch64 FP is a superset of VFPv4, ASIMD of NEON */
+			if ( hwcap & ARM_HWCAP_FP ) {
+				features |= (CPU_HAS_VFPV3 | CPU_HAS_VFPV4);
+			}
+			if ( hwcap & ARM_HWCAP_ASIMD ) {
+				features |= CPU_HAS_NEON;
+			}
+#else
+			const char *platform;
+
+			if ( hwcap & ARM_HWCAP_VFPv3 ) {
+				features |= CPU_HAS_VFPV3;
+			}
+			if ( hwcap & ARM_HWCAP_VFPv4 ) {
+				features |= CPU_HAS_VFPV4;
+			}
+			if ( hwcap & ARM_HWCAP_NEON ) {
+				features |= CPU_HAS_NEON;
+			}
+			/* AT_PLATFORM is "v6l", "v7l", "v8l", ... */
+			platform = (const char *)CPU_getAuxVal(ARM_AT_PLATFORM);
+			if ( platform && platform[0] == 'v' &&
+			     SDL_atoi(platform+1) >= 6 ) {
+				features |= CPU_HAS_ARMSIMD;
+			}
+#endif
+		} else {
+			features = CPU_parseProcCPUInfo();
+		}
+	}
+#elif defined(__aarch64__) || defined(__ARM_NEON__) || defined(__ARM_NEON)
+	/* We can't ask the OS, but the compiler already assumes NEON */
+	features |= (CPU_HAS_VFPV3 | CPU_HAS_NEON);
+#if defined(__ARM_ARCH) && (__ARM_ARCH >= 6) && !defined(__aarch64__)
+	features |= CPU_HAS_ARMSIMD;
+#endif
+#endif
+	return features;
+}
+
+static __inline__ int CPU_haveARMSIMD(void)
+{
+	return (CPU_getARMFeatures() & CPU_HAS_ARMSIMD);
+}
+
+static __inline__ int CPU_haveVFPv3(void)
+{
+	return (CPU_getARMFeatures() & CPU_HAS_VFPV3);
+}
+
+static __inline__ int CPU_haveVFPv4(void)
+{
+	return (CPU_getARMFeatures() & CPU_HAS_VFPV4);
+}
+
+static __inline__ int CPU_haveNEON(void)
+{
+	return (CPU_getARMFeatures() & CPU_HAS_NEON);
+}
+
 static Uint32 SDL_CPUFeatures = 0xFFFFFFFF;
 
 static Uint32 SDL_GetCPUFeatures(void)
@@ -408,9 +634,31 @@ static Uint32 SDL_GetCPUFeatures(void)
 		if ( CPU_haveSSE2() ) {
 			SDL_CPUFeatures |= CPU_HAS_SSE2;
 		}
+		if ( CPU_haveAVX2() ) {
+			SDL_CPUFeatures |= CPU_HAS_AVX2;
+		}
 		if ( CPU_haveAltiVec() ) {
 			SDL_CPUFeatures |= CPU_HAS_ALTIVEC;
 		}
+		if ( CPU_haveARMSIMD() ) {
+			SDL_CPUFeatures |= CPU_HAS_ARMSIMD;
+		}
+		if ( CPU_haveVFPv3() ) {
+			SDL_CPUFeatures |= CPU_HAS_VFPV3;
+		}
+		if ( CPU_haveVFPv4() ) {
+			SDL_CPUFeatures |= CPU_HAS_VFPV4;
+		}
+		if ( CPU_haveNEON() ) {
+			SDL_CPUFeatures |= CPU_HAS_NEON;
+		}
+		/* Provide an override for testing scalar vs. SIMD code paths */
+		{
+			const char *mask = SDL_getenv("SDL_CPU_FEATURE_MASK");
+			if ( mask ) {
+				SDL_CPUFeatures &= (Uint32)SDL_strtoul(mask, NULL, 0);
+			}
+		}
 	}
 	return SDL_CPUFeatures;
 }
@@ -471,6 +719,14 @@ SDL_bool SDL_HasSSE2(void)
 	return SDL_FALSE;
 }
 
+SDL_bool SDL_HasAVX2(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_AVX2 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
 SDL_bool SDL_HasAltiVec(void)
 {
 	if ( SDL_GetCPUFeatures() & CPU_HAS_ALTIVEC ) {
@@ -479,6 +735,38 @@ SDL_bool SDL_HasAltiVec(void)
 	return SDL_FALSE;
 }
 
+SDL_bool SDL_HasARMSIMD(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_ARMSIMD ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasVFPv3(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_VFPV3 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasVFPv4(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_VFPV4 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasNEON(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_NEON ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
 #ifdef TEST_MAIN
 
 #include <stdio.h>
@@ -492,7 +780,12 @@ int main()
 	printf("3DNowExt: %d\n", SDL_Has3DNowExt());
 	printf("SSE: %d\n", SDL_HasSSE());
 	printf("SSE2: %d\n", SDL_HasSSE2());
+	printf("AVX2: %d\n", SDL_HasAVX2());
 	printf("AltiVec: %d\n", SDL_HasAltiVec());
+	printf("ARMSIMD: %d\n", SDL_HasARMSIMD());
+	printf("VFPv3: %d\n", SDL_HasVFPv3());
+	printf("VFPv4: %d\n", SDL_HasVFPv4());
+	printf("NEON: %d\n", SDL_HasNEON());
 	return 0;
 }
 
@@ -25,6 +25,7 @@
 
 #include "SDL_events.h"
 #include "SDL_events_c.h"
+#include "../video/SDL_damage_c.h"
 
 
 /* This is global for SDL_eventloop.c */
@@ -33,6 +34,9 @@ int SDL_PrivateExpose(void)
 	int posted;
 	SDL_Event events[32];
 
+	/* The window contents are gone, so update everything next time */
+	SDL_DamageReset();
+
 	/* Pull out all old refresh events */
 	SDL_PeepEvents(events, sizeof(events)/sizeof(events[0]),
 	                    SDL_GETEVENT, SDL_VIDEOEXPOSEMASK);
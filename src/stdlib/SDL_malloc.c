@@ -615,6 +615,7 @@ DEFAULT_MMAP_THRESHOLD       default: 256K
 #define calloc	SDL_calloc
 #define realloc	SDL_realloc
 #define free	SDL_free
+#define memalign	SDL_memalign
 
 /*
   mallopt tuning options.  SVID/XPG defines four standard parameter
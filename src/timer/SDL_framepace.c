@@ -0,0 +1,209 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Frame pacing for SDL_WaitFrame()
+
+   Frame deadlines are kept on an absolute nanosecond timeline, so a
+   period like 60.0988 Hz doesn't drift the way SDL_Delay() loops rounded
+   to milliseconds do.  SDL_WaitFrame() sleeps until a little before the
+   deadline and spins the rest of the way.  How early it wakes up follows
+   how late the sleeps have been coming back, up to:
+
+	SDL_FRAME_SPIN_MAX    longest spin in microseconds (default 2000,
+	                      0 never spins)
+*/
+
+#include "SDL_timer.h"
+#include "SDL_timer_c.h"
+#include "SDL_systimer.h"
+
+#ifdef SDL_HAS_64BIT_TYPE
+
+#define DEFAULT_SPIN_NS		200000
+#define DEFAULT_SPIN_MAX_NS	2000000
+
+static Uint32 frame_period = 0;
+static Uint32 frame_flags = 0;
+static Uint64 frame_next = 0;
+static int frame_started = 0;
+static Uint32 spin_ns = DEFAULT_SPIN_NS;
+static Uint32 spin_max_ns = DEFAULT_SPIN_MAX_NS;
+
+static SDL_FrameStats stats;
+static Uint64 jitter_sum = 0;
+static Uint32 jitter_frames = 0;
+
+#if !SDL_TIMER_UNIX
+/* Millisecond precision for the backends without a nanosecond clock */
+Uint64 SDL_SYS_GetTicksNS(void)
+{
+	return((Uint64)SDL_GetTicks() * 1000000);
+}
+
+void SDL_SYS_SleepUntilNS(Uint64 when)
+{
+	Uint64 now = SDL_SYS_GetTicksNS();
+
+	if ( when > now ) {
+		SDL_Delay((Uint32)((when - now) / 1000000));
+	}
+}
+#endif /* !SDL_TIMER_UNIX */
+
+/* A deadline more than a period away means the clock went backwards, a
+   wall clock step without a monotonic clock or SDL_GetTicks() wrapping,
+   and waiting for it would freeze the application for the whole step.
+ */
+static int ClockSteppedBack(Uint64 now, Uint64 deadline)
+{
+	return(now < deadline && deadline - now > frame_period);
+}
+
+/* Follow the worst recent oversleep quickly, and back off slowly */
+static void CalibrateSpin(Uint32 oversleep)
+{
+	if ( oversleep > spin_ns ) {
+		spin_ns = oversleep + oversleep / 4;
+	} else {
+		spin_ns -= (spin_ns - oversleep) / 32;
+	}
+	if ( spin_ns > spin_max_ns ) {
+		spin_ns = spin_max_ns;
+	}
+}
+
+int SDL_SetFramePeriod(Uint32 period_ns, Uint32 flags)
+{
+	const char *env = SDL_getenv("SDL_FRAME_SPIN_MAX");
+
+	spin_max_ns = env ? (Uint32)SDL_atoi(env) * 1000 : DEFAULT_SPIN_MAX_NS;
+	spin_ns = SDL_min(DEFAULT_SPIN_NS, spin_max_ns);
+
+	frame_period = period_ns;
+	frame_flags = period_ns ? flags : 0;
+	frame_started = 0;
+	return(0);
+}
+
+void SDL_WaitFrame(void)
+{
+	Uint64 now, deadline, target;
+
+	if ( !frame_period ) {
+		return;
+	}
+	now = SDL_SYS_GetTicksNS();
+	if ( !frame_started ) {
+		/* The first frame starts the timeline */
+		frame_started = 1;
+		frame_next = now + frame_period;
+		++stats.frames;
+		return;
+	}
+
+	deadline = frame_next;
+	++stats.frames;
+	if ( now >= deadline ) {
+		++stats.missed;
+		if ( now - deadline >= frame_period ) {
+			/* More than a frame behind, start over from here */
+			frame_next = now + frame_period;
+		} else {
+			frame_next = deadline + frame_period;
+		}
+		return;
+	}
+	if ( ClockSteppedBack(now, deadline) ) {
+		/* Start over from here, as for the first frame */
+		frame_next = now + frame_period;
+		return;
+	}
+	frame_next = deadline + frame_period;
+
+	if ( deadline - now > spin_ns ) {
+		target = deadline - spin_ns;
+		SDL_SYS_SleepUntilNS(target);
+		now = SDL_SYS_GetTicksNS();
+		if ( now > target ) {
+			CalibrateSpin((Uint32)SDL_min(now - target, 0xFFFFFFFF));
+		}
+	}
+	while ( now < deadline ) {
+		if ( ClockSteppedBack(now, deadline) ) {
+			frame_next = now + frame_period;
+			return;
+		}
+		now = SDL_SYS_GetTicksNS();
+	}
+
+	jitter_sum += now - deadline;
+	++jitter_frames;
+	if ( now - deadline > stats.jitter_max ) {
+		stats.jitter_max = (Uint32)SDL_min(now - deadline, 0xFFFFFFFF);
+	}
+}
+
+void SDL_GetFrameStats(SDL_FrameStats *out, int reset)
+{
+	if ( out ) {
+		*out = stats;
+		out->jitter_avg = jitter_frames ?
+		                  (Uint32)(jitter_sum / jitter_frames) : 0;
+		out->spin = spin_ns;
+	}
+	if ( reset ) {
+		SDL_memset(&stats, 0, sizeof(stats));
+		jitter_sum = 0;
+		jitter_frames = 0;
+	}
+}
+
+void SDL_WaitFlipFrame(void)
+{
+	if ( frame_flags & SDL_FRAME_FLIP ) {
+		SDL_WaitFrame();
+	}
+}
+
+#else
+int SDL_SetFramePeriod(Uint32 period_ns, Uint32 flags)
+{
+	SDL_SetError("Frame pacing needs 64-bit integers");
+	return(-1);
+}
+
+void SDL_WaitFrame(void)
+{
+}
+
+void SDL_GetFrameStats(SDL_FrameStats *out, int reset)
+{
+	if ( out ) {
+		SDL_memset(out, 0, sizeof(*out));
+	}
+}
+
+void SDL_WaitFlipFrame(void)
+{
+}
+#endif /* SDL_HAS_64BIT_TYPE */
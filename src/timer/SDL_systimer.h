@@ -38,3 +38,14 @@ extern int SDL_SYS_StartTimer(void);
 
 /* Stop a previously started timer */
 extern void SDL_SYS_StopTimer(void);
+
+#ifdef SDL_HAS_64BIT_TYPE
+/* Get the number of nanoseconds since SDL_StartTicks(), for frame pacing.
+   Backends without a finer clock get SDL_GetTicks() precision from
+   SDL_framepace.c.
+ */
+extern Uint64 SDL_SYS_GetTicksNS(void);
+
+/* Sleep until SDL_SYS_GetTicksNS() reaches 'when', or a little after */
+extern void SDL_SYS_SleepUntilNS(Uint64 when);
+#endif
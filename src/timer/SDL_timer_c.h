@@ -44,3 +44,6 @@ extern void SDL_TimerQuit(void);
 
 /* This function is called from the SDL event thread if it is available */
 extern void SDL_ThreadedTimerCheck(void);
+
+/* Called by SDL_Flip(), waits for the next frame with SDL_FRAME_FLIP */
+extern void SDL_WaitFlipFrame(void);
@@ -32,13 +32,14 @@
 
 #include "SDL_timer.h"
 #include "../SDL_timer_c.h"
+#include "../SDL_systimer.h"
 
 /* The clock_gettime provides monotonous time, so we should use it if
    it's available. The clock_gettime function is behind ifdef
    for __USE_POSIX199309
    Tommi Kyntola (tommi.kyntola@ray.fi) 27/09/2005
 */
-#if HAVE_NANOSLEEP || HAVE_CLOCK_GETTIME
+#if HAVE_NANOSLEEP || HAVE_CLOCK_GETTIME || HAVE_CLOCK_MONOTONIC
 #include <time.h>
 #endif
 
@@ -57,6 +58,12 @@ static struct timespec start;
 static struct timeval start;
 #endif /* HAVE_CLOCK_GETTIME */
 
+/* The nanosecond clock is monotonic whenever the platform has one, even
+   if SDL_GetTicks() is left on gettimeofday() */
+#if HAVE_CLOCK_MONOTONIC
+static struct timespec start_ns;
+#endif
+
 
 void SDL_StartTicks(void)
 {
@@ -66,6 +73,9 @@ void SDL_StartTicks(void)
 #else
 	gettimeofday(&start, NULL);
 #endif
+#if HAVE_CLOCK_MONOTONIC
+	clock_gettime(CLOCK_MONOTONIC,&start_ns);
+#endif
 }
 
 Uint32 SDL_GetTicks (void)
@@ -85,6 +95,56 @@ Uint32 SDL_GetTicks (void)
 #endif
 }
 
+#ifdef SDL_HAS_64BIT_TYPE
+Uint64 SDL_SYS_GetTicksNS(void)
+{
+#if HAVE_CLOCK_MONOTONIC
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return((Uint64)(now.tv_sec-start_ns.tv_sec)*1000000000 +
+	       (Sint64)(now.tv_nsec-start_ns.tv_nsec));
+#else
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	return((Uint64)(now.tv_sec-start.tv_sec)*1000000000 +
+	       (Sint64)(now.tv_usec-start.tv_usec)*1000);
+#endif
+}
+
+void SDL_SYS_SleepUntilNS(Uint64 when)
+{
+#if HAVE_CLOCK_NANOSLEEP && HAVE_CLOCK_MONOTONIC
+	/* An absolute deadline doesn't drift when interrupted */
+	struct timespec tv;
+	Uint64 nsec = start_ns.tv_nsec + (when % 1000000000);
+
+	tv.tv_sec = start_ns.tv_sec + (time_t)(when / 1000000000) +
+	            (time_t)(nsec / 1000000000);
+	tv.tv_nsec = (long)(nsec % 1000000000);
+	while ( clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &tv, NULL) == EINTR ) {
+		/* keep sleeping */ ;
+	}
+#elif HAVE_NANOSLEEP
+	struct timespec tv;
+	Uint64 now;
+
+	while ( (now = SDL_SYS_GetTicksNS()) < when ) {
+		tv.tv_sec = (time_t)((when - now) / 1000000000);
+		tv.tv_nsec = (long)((when - now) % 1000000000);
+		if ( nanosleep(&tv, NULL) == 0 ) {
+			break;
+		}
+	}
+#else
+	Uint64 now = SDL_SYS_GetTicksNS();
+
+	if ( when > now ) {
+		SDL_Delay((Uint32)((when - now) / 1000000));
+	}
+#endif
+}
+#endif /* SDL_HAS_64BIT_TYPE */
+
 void SDL_Delay (Uint32 ms)
 {
 #if SDL_THREAD_PTH
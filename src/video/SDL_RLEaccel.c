@@ -89,7 +89,9 @@
 #include "SDL_video.h"
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
+#include "SDL_pixels_c.h"
 #include "SDL_RLEaccel_c.h"
+#include "SDL_thread.h"
 
 /* Force MMX to 0; this blows up on almost every major compiler now. --ryan. */
 #if 0 && defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && SDL_ASSEMBLY_ROUTINES
@@ -1396,20 +1398,96 @@ static int uncopy_32(Uint32 *dst, void *src, int n,
 #define ISTRANSL(pixel, fmt)	\
     ((unsigned)((((pixel) & fmt->Amask) >> fmt->Ashift) - 1U) < 254U)
 
-/* convert surface to be quickly alpha-blittable onto dest, if possible */
-static int RLEAlphaSurface(SDL_Surface *surface)
-{
-    SDL_Surface *dest;
-    SDL_PixelFormat *df;
-    int maxsize = 0;
-    int max_opaque_run;
-    int max_transl_run = 65535;
-    unsigned masksum;
-    Uint8 *rlebuf, *dst;
+/*
+ * The encoders work on a copy of what they need from the surface, so the
+ * encoding can run on another thread while the surface is being blitted.
+ * Large surfaces are encoded in row bands on the blit worker threads and
+ * the bands joined afterwards.  Each band is encoded exactly as it would
+ * be in one pass; lines of the alpha encoding always end 32-bit aligned,
+ * so the bands can simply be concatenated.
+ */
+typedef struct {
+    Uint8 *buf;			/* the encoded rows, NULL if out of memory */
+    Uint8 *end;			/* end of the encoded rows */
+    Uint8 *lastline;		/* end of the last row that isn't blank */
+} RLEBand;
+
+typedef struct {
+    Uint8 *pixels;
+    int w, h, pitch;
+    SDL_PixelFormat sf;		/* source format */
+    SDL_PixelFormat df;		/* destination format, for pixel alpha */
+    int alpha;			/* pixel alpha rather than colorkey */
+    int keep;			/* keep the raw pixels with the encoding */
     int (*copy_opaque)(void *, Uint32 *, int,
 		       SDL_PixelFormat *, SDL_PixelFormat *);
     int (*copy_transl)(void *, Uint32 *, int,
 		       SDL_PixelFormat *, SDL_PixelFormat *);
+    int bands;
+    RLEBand band[SDL_BLIT_MAX_THREADS];
+    Uint8 *rle;			/* the joined encoding */
+    Uint32 hash[8];		/* hash of the pixels, if kept */
+} RLEEncoder;
+
+/*
+ * The raw pixels kept for SDL_PREPARE_KEEPRAW are hashed, so unlocking
+ * the surface only encodes it again if they changed.  The 32-bit words
+ * of each row are dealt out to four lanes, and each lane mixes its words
+ * into its state with a xor, a multiply and a xorshift.  For a given word
+ * each step can be undone, so lanes that see different words in just one
+ * place never end up in the same state, and more changes only go
+ * unnoticed by chance, about once in 2^64.  Sums won't do here: edits
+ * that cancel out in a sum are easy to make.
+ */
+#ifdef SDL_HAS_64BIT_TYPE
+typedef Uint64 RLEHashLane;
+#define RLE_HASH_MULTIPLIER	(((Uint64)0x9E3779B9 << 32) | 0x7F4A7C15)
+#define RLE_HASH_SHIFT		29
+#else
+typedef Uint32 RLEHashLane;
+#define RLE_HASH_MULTIPLIER	0x9E3779B1
+#define RLE_HASH_SHIFT		15
+#endif
+
+#define RLE_HASH_WORD(h, w)				\
+    do {						\
+	(h) = ((h) ^ (w)) * RLE_HASH_MULTIPLIER;	\
+	(h) ^= (h) >> RLE_HASH_SHIFT;			\
+    } while(0)
+
+static void RLEHashPixels(const Uint8 *p, int len, int rows, int pitch,
+			  Uint32 hash[8])
+{
+    RLEHashLane lane[4];
+    Uint32 w[4];
+    int i;
+
+    lane[0] = 1;
+    lane[1] = 2;
+    lane[2] = 3;
+    lane[3] = 4;
+    while(rows--) {
+	for(i = 0; i < len; i += 16) {
+	    if(len - i < 16)
+		SDL_memset(w, 0, sizeof(w));
+	    SDL_memcpy(w, p + i, MIN(16, len - i));
+	    RLE_HASH_WORD(lane[0], w[0]);
+	    RLE_HASH_WORD(lane[1], w[1]);
+	    RLE_HASH_WORD(lane[2], w[2]);
+	    RLE_HASH_WORD(lane[3], w[3]);
+	}
+	p += pitch;
+    }
+    SDL_memset(hash, 0, 8 * sizeof(Uint32));
+    SDL_memcpy(hash, lane, sizeof(lane));
+}
+
+/* find out whether the destination is one we support for pixel alpha */
+static int RLEAlphaSetup(RLEEncoder *enc, SDL_Surface *surface)
+{
+    SDL_Surface *dest;
+    SDL_PixelFormat *df;
+    unsigned masksum;
 
     dest = surface->map->dst;
     if(!dest)
@@ -1418,8 +1496,6 @@ static int RLEAlphaSurface(SDL_Surface *surface)
     if(surface->format->BitsPerPixel != 32)
 	return -1;		/* only 32bpp source supported */
 
-    /* find out whether the destination is one we support,
-       and determine the max size of the encoded result */
     masksum = df->Rmask | df->Gmask | df->Bmask;
     switch(df->BytesPerPixel) {
     case 2:
@@ -1428,75 +1504,64 @@ static int RLEAlphaSurface(SDL_Surface *surface)
 	case 0xffff:
 	    if(df->Gmask == 0x07e0
 	       || df->Rmask == 0x07e0 || df->Bmask == 0x07e0) {
-		copy_opaque = copy_opaque_16;
-		copy_transl = copy_transl_565;
+		enc->copy_opaque = copy_opaque_16;
+		enc->copy_transl = copy_transl_565;
 	    } else
 		return -1;
 	    break;
 	case 0x7fff:
 	    if(df->Gmask == 0x03e0
 	       || df->Rmask == 0x03e0 || df->Bmask == 0x03e0) {
-		copy_opaque = copy_opaque_16;
-		copy_transl = copy_transl_555;
+		enc->copy_opaque = copy_opaque_16;
+		enc->copy_transl = copy_transl_555;
 	    } else
 		return -1;
 	    break;
 	default:
 	    return -1;
 	}
-	max_opaque_run = 255;	/* runs stored as bytes */
-
-	/* worst case is alternating opaque and translucent pixels,
-	   with room for alignment padding between lines */
-	maxsize = surface->h * (2 + (4 + 2) * (surface->w + 1)) + 2;
 	break;
     case 4:
 	if(masksum != 0x00ffffff)
 	    return -1;		/* requires unused high byte */
-	copy_opaque = copy_32;
-	copy_transl = copy_32;
-	max_opaque_run = 255;	/* runs stored as short ints */
-
-	/* worst case is alternating opaque and translucent pixels */
-	maxsize = surface->h * 2 * 4 * (surface->w + 1) + 4;
+	enc->copy_opaque = copy_32;
+	enc->copy_transl = copy_32;
 	break;
     default:
 	return -1;		/* anything else unsupported right now */
     }
+    enc->df = *df;
+    enc->alpha = 1;
+    return 0;
+}
 
-    maxsize += sizeof(RLEDestFormat);
-    rlebuf = (Uint8 *)SDL_malloc(maxsize);
-    if(!rlebuf) {
-	SDL_OutOfMemory();
-	return -1;
-    }
-    {
-	/* save the destination format so we can undo the encoding later */
-	RLEDestFormat *r = (RLEDestFormat *)rlebuf;
-	r->BytesPerPixel = df->BytesPerPixel;
-	r->Rloss = df->Rloss;
-	r->Gloss = df->Gloss;
-	r->Bloss = df->Bloss;
-	r->Rshift = df->Rshift;
-	r->Gshift = df->Gshift;
-	r->Bshift = df->Bshift;
-	r->Ashift = df->Ashift;
-	r->Rmask = df->Rmask;
-	r->Gmask = df->Gmask;
-	r->Bmask = df->Bmask;
-	r->Amask = df->Amask;
+/* the max size of 'rows' encoded rows with pixel alpha */
+static int RLEAlphaMaxSize(RLEEncoder *enc, int rows)
+{
+    if(enc->df.BytesPerPixel == 2) {
+	/* worst case is alternating opaque and translucent pixels,
+	   with room for alignment padding between lines */
+	return rows * (2 + (4 + 2) * (enc->w + 1));
+    } else {
+	/* worst case is alternating opaque and translucent pixels */
+	return rows * 2 * 4 * (enc->w + 1);
     }
-    dst = rlebuf + sizeof(RLEDestFormat);
+}
 
-    /* Do the actual encoding */
-    {
-	int x, y;
-	int h = surface->h, w = surface->w;
-	SDL_PixelFormat *sf = surface->format;
-	Uint32 *src = (Uint32 *)surface->pixels;
-	Uint8 *lastline = dst;	/* end of last non-blank line */
+/* encode rows y0 to y1-1 of a surface with pixel alpha into dst */
+static Uint8 *RLEAlphaRows(RLEEncoder *enc, int y0, int y1, Uint8 *dst,
+			   Uint8 **lastlinep)
+{
+    int max_opaque_run = 255;	/* runs stored as bytes or short ints */
+    int max_transl_run = 65535;
+    int x, y;
+    int w = enc->w;
+    SDL_PixelFormat *sf = &enc->sf;
+    SDL_PixelFormat *df = &enc->df;
+    Uint32 *src = (Uint32 *)(enc->pixels + y0 * enc->pitch);
+    Uint8 *lastline = dst;	/* end of last non-blank line */
 
-	/* opaque counts are 8 or 16 bits, depending on target depth */
+    /* opaque counts are 8 or 16 bits, depending on target depth */
 #define ADD_OPAQUE_COUNTS(n, m)			\
 	if(df->BytesPerPixel == 4) {		\
 	    ((Uint16 *)dst)[0] = n;		\
@@ -1508,106 +1573,89 @@ static int RLEAlphaSurface(SDL_Surface *surface)
 	    dst += 2;				\
 	}
 
-	/* translucent counts are always 16 bit */
+    /* translucent counts are always 16 bit */
 #define ADD_TRANSL_COUNTS(n, m)		\
 	(((Uint16 *)dst)[0] = n, ((Uint16 *)dst)[1] = m, dst += 4)
 
-	for(y = 0; y < h; y++) {
-	    int runstart, skipstart;
-	    int blankline = 0;
-	    /* First encode all opaque pixels of a scan line */
-	    x = 0;
-	    do {
-		int run, skip, len;
-		skipstart = x;
-		while(x < w && !ISOPAQUE(src[x], sf))
-		    x++;
-		runstart = x;
-		while(x < w && ISOPAQUE(src[x], sf))
-		    x++;
-		skip = runstart - skipstart;
-		if(skip == w)
-		    blankline = 1;
-		run = x - runstart;
-		while(skip > max_opaque_run) {
-		    ADD_OPAQUE_COUNTS(max_opaque_run, 0);
-		    skip -= max_opaque_run;
-		}
+    for(y = y0; y < y1; y++) {
+	int runstart, skipstart;
+	int blankline = 0;
+	/* First encode all opaque pixels of a scan line */
+	x = 0;
+	do {
+	    int run, skip, len;
+	    skipstart = x;
+	    while(x < w && !ISOPAQUE(src[x], sf))
+		x++;
+	    runstart = x;
+	    while(x < w && ISOPAQUE(src[x], sf))
+		x++;
+	    skip = runstart - skipstart;
+	    if(skip == w)
+		blankline = 1;
+	    run = x - runstart;
+	    while(skip > max_opaque_run) {
+		ADD_OPAQUE_COUNTS(max_opaque_run, 0);
+		skip -= max_opaque_run;
+	    }
+	    len = MIN(run, max_opaque_run);
+	    ADD_OPAQUE_COUNTS(skip, len);
+	    dst += enc->copy_opaque(dst, src + runstart, len, sf, df);
+	    runstart += len;
+	    run -= len;
+	    while(run) {
 		len = MIN(run, max_opaque_run);
-		ADD_OPAQUE_COUNTS(skip, len);
-		dst += copy_opaque(dst, src + runstart, len, sf, df);
+		ADD_OPAQUE_COUNTS(0, len);
+		dst += enc->copy_opaque(dst, src + runstart, len, sf, df);
 		runstart += len;
 		run -= len;
-		while(run) {
-		    len = MIN(run, max_opaque_run);
-		    ADD_OPAQUE_COUNTS(0, len);
-		    dst += copy_opaque(dst, src + runstart, len, sf, df);
-		    runstart += len;
-		    run -= len;
-		}
-	    } while(x < w);
+	    }
+	} while(x < w);
 
-	    /* Make sure the next output address is 32-bit aligned */
-	    dst += (uintptr_t)dst & 2;
+	/* Make sure the next output address is 32-bit aligned */
+	dst += (uintptr_t)dst & 2;
 
-	    /* Next, encode all translucent pixels of the same scan line */
-	    x = 0;
-	    do {
-		int run, skip, len;
-		skipstart = x;
-		while(x < w && !ISTRANSL(src[x], sf))
-		    x++;
-		runstart = x;
-		while(x < w && ISTRANSL(src[x], sf))
-		    x++;
-		skip = runstart - skipstart;
-		blankline &= (skip == w);
-		run = x - runstart;
-		while(skip > max_transl_run) {
-		    ADD_TRANSL_COUNTS(max_transl_run, 0);
-		    skip -= max_transl_run;
-		}
+	/* Next, encode all translucent pixels of the same scan line */
+	x = 0;
+	do {
+	    int run, skip, len;
+	    skipstart = x;
+	    while(x < w && !ISTRANSL(src[x], sf))
+		x++;
+	    runstart = x;
+	    while(x < w && ISTRANSL(src[x], sf))
+		x++;
+	    skip = runstart - skipstart;
+	    blankline &= (skip == w);
+	    run = x - runstart;
+	    while(skip > max_transl_run) {
+		ADD_TRANSL_COUNTS(max_transl_run, 0);
+		skip -= max_transl_run;
+	    }
+	    len = MIN(run, max_transl_run);
+	    ADD_TRANSL_COUNTS(skip, len);
+	    dst += enc->copy_transl(dst, src + runstart, len, sf, df);
+	    runstart += len;
+	    run -= len;
+	    while(run) {
 		len = MIN(run, max_transl_run);
-		ADD_TRANSL_COUNTS(skip, len);
-		dst += copy_transl(dst, src + runstart, len, sf, df);
+		ADD_TRANSL_COUNTS(0, len);
+		dst += enc->copy_transl(dst, src + runstart, len, sf, df);
 		runstart += len;
 		run -= len;
-		while(run) {
-		    len = MIN(run, max_transl_run);
-		    ADD_TRANSL_COUNTS(0, len);
-		    dst += copy_transl(dst, src + runstart, len, sf, df);
-		    runstart += len;
-		    run -= len;
-		}
-		if(!blankline)
-		    lastline = dst;
-	    } while(x < w);
+	    }
+	    if(!blankline)
+		lastline = dst;
+	} while(x < w);
 
-	    src += surface->pitch >> 2;
-	}
-	dst = lastline;		/* back up past trailing blank lines */
-	ADD_OPAQUE_COUNTS(0, 0);
+	src += enc->pitch >> 2;
     }
 
 #undef ADD_OPAQUE_COUNTS
 #undef ADD_TRANSL_COUNTS
 
-    /* Now that we have it encoded, release the original pixels */
-    if((surface->flags & SDL_PREALLOC) != SDL_PREALLOC
-       && (surface->flags & SDL_HWSURFACE) != SDL_HWSURFACE) {
-	SDL_free( surface->pixels );
-	surface->pixels = NULL;
-    }
-
-    /* realloc the buffer to release unused memory */
-    {
-	Uint8 *p = SDL_realloc(rlebuf, dst - rlebuf);
-	if(!p)
-	    p = rlebuf;
-	surface->map->sw_data->aux_data = p;
-    }
-
-    return 0;
+    *lastlinep = lastline;
+    return dst;
 }
 
 static Uint32 getpix_8(Uint8 *srcbuf)
@@ -1640,54 +1688,46 @@ static getpix_func getpixes[4] = {
     getpix_8, getpix_16, getpix_24, getpix_32
 };
 
-static int RLEColorkeySurface(SDL_Surface *surface)
+/* the max size of 'rows' encoded rows with a colorkey */
+static int RLEColorkeyMaxSize(RLEEncoder *enc, int rows)
 {
-        Uint8 *rlebuf, *dst;
-	int maxn;
-	int y;
-	Uint8 *srcbuf, *lastline;
-	int maxsize = 0;
-	int bpp = surface->format->BytesPerPixel;
-	getpix_func getpix;
-	Uint32 ckey, rgbmask;
-	int w, h;
+	int w = enc->w;
 
-	/* calculate the worst case size for the compressed surface */
-	switch(bpp) {
+	switch(enc->sf.BytesPerPixel) {
 	case 1:
 	    /* worst case is alternating opaque and transparent pixels,
 	       starting with an opaque pixel */
-	    maxsize = surface->h * 3 * (surface->w / 2 + 1) + 2;
-	    break;
+	    return rows * 3 * (w / 2 + 1);
 	case 2:
 	case 3:
 	    /* worst case is solid runs, at most 255 pixels wide */
-	    maxsize = surface->h * (2 * (surface->w / 255 + 1)
-				    + surface->w * bpp) + 2;
-	    break;
-	case 4:
+	    return rows * (2 * (w / 255 + 1) + w * enc->sf.BytesPerPixel);
+	default:
 	    /* worst case is solid runs, at most 65535 pixels wide */
-	    maxsize = surface->h * (4 * (surface->w / 65535 + 1)
-				    + surface->w * 4) + 4;
-	    break;
+	    return rows * (4 * (w / 65535 + 1) + w * 4);
 	}
+}
 
-	rlebuf = (Uint8 *)SDL_malloc(maxsize);
-	if ( rlebuf == NULL ) {
-		SDL_OutOfMemory();
-		return(-1);
-	}
+/* encode rows y0 to y1-1 of a surface with a colorkey into dst */
+static Uint8 *RLEColorkeyRows(RLEEncoder *enc, int y0, int y1, Uint8 *dst,
+			      Uint8 **lastlinep)
+{
+	int maxn;
+	int y;
+	Uint8 *srcbuf, *lastline;
+	int bpp = enc->sf.BytesPerPixel;
+	getpix_func getpix;
+	Uint32 ckey, rgbmask;
+	int w;
 
 	/* Set up the conversion */
-	srcbuf = (Uint8 *)surface->pixels;
+	srcbuf = enc->pixels + y0 * enc->pitch;
 	maxn = bpp == 4 ? 65535 : 255;
-	dst = rlebuf;
-	rgbmask = ~surface->format->Amask;
-	ckey = surface->format->colorkey & rgbmask;
+	rgbmask = ~enc->sf.Amask;
+	ckey = enc->sf.colorkey & rgbmask;
 	lastline = dst;
 	getpix = getpixes[bpp - 1];
-	w = surface->w;
-	h = surface->h;
+	w = enc->w;
 
 #define ADD_COUNTS(n, m)			\
 	if(bpp == 4) {				\
@@ -1700,7 +1740,7 @@ static int RLEColorkeySurface(SDL_Surface *surface)
 	    dst += 2;				\
 	}
 
-	for(y = 0; y < h; y++) {
+	for(y = y0; y < y1; y++) {
 	    int x = 0;
 	    int blankline = 0;
 	    do {
@@ -1742,37 +1782,223 @@ static int RLEColorkeySurface(SDL_Surface *surface)
 		    lastline = dst;
 	    } while(x < w);
 
-	    srcbuf += surface->pitch;
+	    srcbuf += enc->pitch;
 	}
-	dst = lastline;		/* back up bast trailing blank lines */
-	ADD_COUNTS(0, 0);
 
 #undef ADD_COUNTS
 
-	/* Now that we have it encoded, release the original pixels */
-	if((surface->flags & SDL_PREALLOC) != SDL_PREALLOC
-	   && (surface->flags & SDL_HWSURFACE) != SDL_HWSURFACE) {
-	    SDL_free( surface->pixels );
-	    surface->pixels = NULL;
+	*lastlinep = lastline;
+	return dst;
+}
+
+/* fill in an encoder for the surface, or return -1 if it can't be done */
+static int RLESetup(RLEEncoder *enc, SDL_Surface *surface)
+{
+	const char *env;
+
+	SDL_memset(enc, 0, sizeof(*enc));
+	if((surface->flags & SDL_SRCCOLORKEY) != SDL_SRCCOLORKEY) {
+	    if((surface->flags & SDL_SRCALPHA) != SDL_SRCALPHA
+	       || surface->format->Amask == 0)
+		return -1;	/* no RLE for per-surface alpha sans ckey */
+	    if(RLEAlphaSetup(enc, surface) < 0)
+		return -1;
+	}
+	enc->pixels = (Uint8 *)surface->pixels;
+	enc->w = surface->w;
+	enc->h = surface->h;
+	enc->pitch = surface->pitch;
+	enc->sf = *surface->format;
+
+	/* hardware surfaces keep their pixels anyway, but aren't re-encoded */
+	env = SDL_getenv("SDL_VIDEO_RLE_KEEP_PIXELS");
+	if((surface->flags & SDL_HWSURFACE) != SDL_HWSURFACE) {
+	    enc->keep = (surface->map->prepare_flags & SDL_PREPARE_KEEPRAW)
+			|| (env && SDL_atoi(env));
+	}
+	return 0;
+}
+
+/* the size of the header and end marker around the encoded lines */
+#define RLE_HEADER_SIZE(enc)	((enc)->alpha ? sizeof(RLEDestFormat) : 0)
+#define RLE_END_SIZE(enc)						\
+	(((enc)->alpha ? (enc)->df.BytesPerPixel : (enc)->sf.BytesPerPixel) \
+	 == 4 ? 4 : 2)
+
+/* encode one band of rows; the first band leaves room for the header */
+static void RLEEncodeBand(void *data, int i)
+{
+	RLEEncoder *enc = (RLEEncoder *)data;
+	RLEBand *band = &enc->band[i];
+	int y0 = enc->h * i / enc->bands;
+	int y1 = enc->h * (i + 1) / enc->bands;
+	int maxsize, offset = 0;
+
+	if(enc->alpha)
+	    maxsize = RLEAlphaMaxSize(enc, y1 - y0);
+	else
+	    maxsize = RLEColorkeyMaxSize(enc, y1 - y0);
+	if(i == 0) {
+	    offset = RLE_HEADER_SIZE(enc);
+	    maxsize += offset + RLE_END_SIZE(enc);
+	}
+	band->buf = (Uint8 *)SDL_malloc(maxsize);
+	if(!band->buf)
+	    return;
+	if(enc->alpha)
+	    band->end = RLEAlphaRows(enc, y0, y1, band->buf + offset,
+				     &band->lastline);
+	else
+	    band->end = RLEColorkeyRows(enc, y0, y1, band->buf + offset,
+					&band->lastline);
+}
+
+static void RLEFreeBands(RLEEncoder *enc)
+{
+	int i;
+
+	for(i = 0; i < enc->bands; i++) {
+	    if(enc->band[i].buf) {
+		SDL_free(enc->band[i].buf);
+		enc->band[i].buf = NULL;
+	    }
+	}
+}
+
+/* join the bands into one encoding, without the trailing blank lines */
+static int RLEJoin(RLEEncoder *enc)
+{
+	int endsize = RLE_END_SIZE(enc);
+	int i, last, len, size;
+	Uint8 *rle, *dst;
+
+	for(i = 0; i < enc->bands; i++) {
+	    if(!enc->band[i].buf) {
+		RLEFreeBands(enc);
+		SDL_OutOfMemory();
+		return -1;
+	    }
+	}
+
+	/* find the last band with a non-blank line */
+	last = 0;
+	for(i = 1; i < enc->bands; i++) {
+	    if(enc->band[i].lastline != enc->band[i].buf)
+		last = i;
+	}
+
+	/* the first band's buffer grows to hold the others */
+	rle = enc->band[0].buf;
+	if(last == 0) {
+	    len = enc->band[0].lastline - rle;
+	} else {
+	    len = enc->band[0].end - rle;
+	    size = len + endsize;
+	    for(i = 1; i <= last; i++) {
+		RLEBand *band = &enc->band[i];
+		size += (i < last ? band->end : band->lastline) - band->buf;
+	    }
+	    rle = (Uint8 *)SDL_realloc(rle, size);
+	    if(!rle) {
+		RLEFreeBands(enc);
+		SDL_OutOfMemory();
+		return -1;
+	    }
+	    for(i = 1; i <= last; i++) {
+		RLEBand *band = &enc->band[i];
+		int n = (i < last ? band->end : band->lastline) - band->buf;
+		SDL_memcpy(rle + len, band->buf, n);
+		len += n;
+	    }
+	}
+	enc->band[0].buf = NULL;
+	RLEFreeBands(enc);
+
+	/* back up past trailing blank lines and end the encoding */
+	dst = rle + len;
+	if(endsize == 4) {
+	    ((Uint16 *)dst)[0] = 0;
+	    ((Uint16 *)dst)[1] = 0;
+	} else {
+	    dst[0] = 0;
+	    dst[1] = 0;
+	}
+	len += endsize;
+
+	if(enc->alpha) {
+	    /* save the destination format so we can undo the encoding later */
+	    RLEDestFormat *r = (RLEDestFormat *)rle;
+	    SDL_PixelFormat *df = &enc->df;
+	    r->BytesPerPixel = df->BytesPerPixel;
+	    r->Rloss = df->Rloss;
+	    r->Gloss = df->Gloss;
+	    r->Bloss = df->Bloss;
+	    r->Rshift = df->Rshift;
+	    r->Gshift = df->Gshift;
+	    r->Bshift = df->Bshift;
+	    r->Ashift = df->Ashift;
+	    r->Rmask = df->Rmask;
+	    r->Gmask = df->Gmask;
+	    r->Bmask = df->Bmask;
+	    r->Amask = df->Amask;
 	}
 
 	/* realloc the buffer to release unused memory */
 	{
 	    /* If realloc returns NULL, the original block is left intact */
-	    Uint8 *p = SDL_realloc(rlebuf, dst - rlebuf);
+	    Uint8 *p = SDL_realloc(rle, len);
 	    if(!p)
-		p = rlebuf;
-	    surface->map->sw_data->aux_data = p;
+		p = rle;
+	    enc->rle = p;
 	}
+	return 0;
+}
 
-	return(0);
+/* encode the surface, in bands on the blit threads if 'threaded' is set */
+static int RLEEncode(RLEEncoder *enc, int threaded)
+{
+	enc->bands = 1;
+	if(threaded)
+	    enc->bands = SDL_BlitBands(enc->w * enc->h, enc->h);
+	SDL_RunBands(RLEEncodeBand, enc, enc->bands);
+	if(RLEJoin(enc) < 0)
+	    return -1;
+	if(enc->keep)
+	    RLEHashPixels(enc->pixels, enc->w * enc->sf.BytesPerPixel,
+			  enc->h, enc->pitch, enc->hash);
+	return 0;
+}
+
+/* give the surface its new encoding */
+static void RLEInstall(SDL_Surface *surface, RLEEncoder *enc)
+{
+	SDL_BlitMap *map = surface->map;
+
+	/* Now that we have it encoded, release the original pixels */
+	if(!enc->keep
+	   && (surface->flags & SDL_PREALLOC) != SDL_PREALLOC
+	   && (surface->flags & SDL_HWSURFACE) != SDL_HWSURFACE) {
+	    SDL_free( surface->pixels );
+	    surface->pixels = NULL;
+	}
+	map->sw_data->aux_data = enc->rle;
+	map->rle_kept = enc->keep;
+	if(enc->keep)
+	    SDL_memcpy(map->rle_hash, enc->hash, sizeof(map->rle_hash));
+
+	/* The surface is now accelerated */
+	surface->flags |= SDL_RLEACCEL;
 }
 
 int SDL_RLESurface(SDL_Surface *surface)
 {
+	RLEEncoder enc;
 	int retcode;
 
 	/* Clear any previous RLE conversion */
+	if ( surface->map->rle_job ) {
+		SDL_RLECancel(surface->map);
+	}
 	if ( (surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
 		SDL_UnRLESurface(surface, 1);
 	}
@@ -1790,14 +2016,9 @@ int SDL_RLESurface(SDL_Surface *surface)
 	}
 
 	/* Encode */
-	if((surface->flags & SDL_SRCCOLORKEY) == SDL_SRCCOLORKEY) {
-	    retcode = RLEColorkeySurface(surface);
-	} else {
-	    if((surface->flags & SDL_SRCALPHA) == SDL_SRCALPHA
-	       && surface->format->Amask != 0)
-		retcode = RLEAlphaSurface(surface);
-	    else
-		retcode = -1;	/* no RLE for per-surface alpha sans ckey */
+	retcode = RLESetup(&enc, surface);
+	if ( retcode == 0 ) {
+		retcode = RLEEncode(&enc, 1);
 	}
 
 	/* Unlock the surface if it's in hardware */
@@ -1808,12 +2029,236 @@ int SDL_RLESurface(SDL_Surface *surface)
 	if(retcode < 0)
 	    return -1;
 
-	/* The surface is now accelerated */
-	surface->flags |= SDL_RLEACCEL;
+	RLEInstall(surface, &enc);
+	return(0);
+}
+
+int SDL_RLEUnchanged(SDL_Surface *surface)
+{
+	SDL_BlitMap *map = surface->map;
+	Uint32 hash[8];
+
+	if ( !map->rle_kept ) {
+		return(0);
+	}
+	RLEHashPixels((Uint8 *)surface->pixels,
+	              surface->w * surface->format->BytesPerPixel,
+	              surface->h, surface->pitch, hash);
+	if ( SDL_memcmp(hash, map->rle_hash, sizeof(hash)) == 0 ) {
+		SDL_LockMapCache();
+		++SDL_blit_cache_stats.rle_unchanged;
+		SDL_UnlockMapCache();
+		return(1);
+	}
+	/* The encoding is stale, but the pixels are all there */
+	SDL_UnRLESurface(surface, 0);
+	return(0);
+}
+
+#if !SDL_THREADS_DISABLED
+/*
+ * Background encoding for SDL_PREPARE_ASYNC
+ *
+ * Jobs are queued for one encoder thread, started when it's first needed
+ * and stopped with the video subsystem.  A job belongs to the blit map of
+ * its surface, which is blitted from its raw pixels until SDL_RLEFinish()
+ * finds the job done and installs the encoding.  Locking the surface
+ * waits for the job, and remapping or freeing it cancels the job.
+ */
+enum {
+	RLE_JOB_QUEUED,
+	RLE_JOB_RUNNING,
+	RLE_JOB_DONE
+};
 
+struct SDL_RLEJob {
+	RLEEncoder enc;
+	int status;
+	int state;
+	struct SDL_RLEJob *next;
+};
+
+static SDL_Thread *rle_thread = NULL;
+static SDL_mutex *rle_lock = NULL;
+static SDL_cond *rle_cond = NULL;
+static struct SDL_RLEJob *rle_queue = NULL;
+static int rle_quit = 0;
+
+static int SDLCALL RLEEncoderThread(void *unused)
+{
+	struct SDL_RLEJob *job;
+
+	SDL_mutexP(rle_lock);
+	for ( ; ; ) {
+		while ( !rle_queue && !rle_quit ) {
+			SDL_CondWait(rle_cond, rle_lock);
+		}
+		/* Finish the queued jobs before quitting */
+		job = rle_queue;
+		if ( !job ) {
+			break;
+		}
+		rle_queue = job->next;
+		job->state = RLE_JOB_RUNNING;
+		SDL_mutexV(rle_lock);
+
+		/* The blit threads are left to the application's blits */
+		job->status = RLEEncode(&job->enc, 0);
+
+		SDL_mutexP(rle_lock);
+		job->state = RLE_JOB_DONE;
+		SDL_CondBroadcast(rle_cond);
+	}
+	SDL_mutexV(rle_lock);
+	return(0);
+}
+
+static int RLEStartThread(void)
+{
+	rle_quit = 0;
+	rle_lock = SDL_CreateMutex();
+	rle_cond = SDL_CreateCond();
+	if ( rle_lock && rle_cond ) {
+		rle_thread = SDL_CreateThread(RLEEncoderThread, NULL);
+	}
+	if ( !rle_thread ) {
+		SDL_RLEQuit();
+		return(-1);
+	}
+	return(0);
+}
+
+int SDL_RLESurfaceAsync(SDL_Surface *surface)
+{
+	struct SDL_RLEJob *job, **tail;
+
+	/* Encode right away unless asked to and able to do it later */
+	if ( !(surface->map->prepare_flags & SDL_PREPARE_ASYNC) ||
+	     !current_video || surface->locked || SDL_MUSTLOCK(surface) ||
+	     surface->format->BitsPerPixel < 8 ) {
+		return(-1);
+	}
+	if ( surface->map->rle_job ) {
+		SDL_RLECancel(surface->map);
+	}
+	job = (struct SDL_RLEJob *)SDL_malloc(sizeof(*job));
+	if ( !job ) {
+		return(-1);
+	}
+	if ( RLESetup(&job->enc, surface) < 0 ||
+	     (!rle_thread && RLEStartThread() < 0) ) {
+		SDL_free(job);
+		return(-1);
+	}
+
+	SDL_mutexP(rle_lock);
+	job->state = RLE_JOB_QUEUED;
+	job->next = NULL;
+	for ( tail = &rle_queue; *tail; tail = &(*tail)->next ) {
+		/* find the end of the queue */ ;
+	}
+	*tail = job;
+	SDL_CondBroadcast(rle_cond);
+	SDL_mutexV(rle_lock);
+
+	surface->map->rle_job = job;
 	return(0);
 }
 
+void SDL_RLEFinish(SDL_Surface *surface, int wait)
+{
+	SDL_BlitMap *map = surface->map;
+	struct SDL_RLEJob *job = map->rle_job;
+	int done = 1;	/* all jobs are done once the thread is gone */
+
+	if ( rle_lock ) {
+		SDL_mutexP(rle_lock);
+		while ( wait && job->state != RLE_JOB_DONE ) {
+			SDL_CondWait(rle_cond, rle_lock);
+		}
+		done = (job->state == RLE_JOB_DONE);
+		SDL_mutexV(rle_lock);
+	}
+	if ( !done ) {
+		return;
+	}
+	map->rle_job = NULL;
+	if ( job->status == 0 ) {
+		RLEInstall(surface, &job->enc);
+		map->sw_blit = job->enc.alpha ? SDL_RLEAlphaBlit : SDL_RLEBlit;
+		SDL_LockMapCache();
+		++SDL_blit_cache_stats.rle_encoded;
+		SDL_UnlockMapCache();
+	}
+	SDL_free(job);
+}
+
+void SDL_RLECancel(SDL_BlitMap *map)
+{
+	struct SDL_RLEJob *job = map->rle_job;
+	struct SDL_RLEJob **prev;
+	int queued = 0;
+
+	map->rle_job = NULL;
+	if ( rle_lock ) {
+		SDL_mutexP(rle_lock);
+		if ( job->state == RLE_JOB_QUEUED ) {
+			/* It hasn't started, take it out of the queue */
+			for ( prev = &rle_queue; *prev != job; prev = &(*prev)->next ) {
+				/* find the job in the queue */ ;
+			}
+			*prev = job->next;
+			queued = 1;
+		}
+		while ( !queued && job->state != RLE_JOB_DONE ) {
+			SDL_CondWait(rle_cond, rle_lock);
+		}
+		SDL_mutexV(rle_lock);
+	}
+	if ( !queued && job->status == 0 ) {
+		SDL_free(job->enc.rle);
+	}
+	SDL_free(job);
+}
+
+void SDL_RLEQuit(void)
+{
+	if ( rle_thread ) {
+		SDL_mutexP(rle_lock);
+		rle_quit = 1;
+		SDL_CondBroadcast(rle_cond);
+		SDL_mutexV(rle_lock);
+		SDL_WaitThread(rle_thread, NULL);
+		rle_thread = NULL;
+	}
+	if ( rle_cond ) {
+		SDL_DestroyCond(rle_cond);
+		rle_cond = NULL;
+	}
+	if ( rle_lock ) {
+		SDL_DestroyMutex(rle_lock);
+		rle_lock = NULL;
+	}
+}
+#else
+int SDL_RLESurfaceAsync(SDL_Surface *surface)
+{
+	return(-1);
+}
+
+void SDL_RLEFinish(SDL_Surface *surface, int wait)
+{
+}
+
+void SDL_RLECancel(SDL_BlitMap *map)
+{
+}
+
+void SDL_RLEQuit(void)
+{
+}
+#endif /* !SDL_THREADS_DISABLED */
+
 /*
  * Un-RLE a surface with pixel alpha
  * This may not give back exactly the image before RLE-encoding; all
@@ -1840,7 +2285,8 @@ static SDL_bool UnRLEAlpha(SDL_Surface *surface)
 	uncopy_opaque = uncopy_transl = uncopy_32;
     }
 
-    surface->pixels = SDL_malloc(surface->h * surface->pitch);
+    surface->pixels = SDL_AllocPixels(surface,
+				      (size_t)surface->h * surface->pitch);
     if ( !surface->pixels ) {
         return(SDL_FALSE);
     }
@@ -1897,14 +2343,16 @@ void SDL_UnRLESurface(SDL_Surface *surface, int recode)
     if ( (surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
 	surface->flags &= ~SDL_RLEACCEL;
 
-	if(recode && (surface->flags & SDL_PREALLOC) != SDL_PREALLOC
+	if(recode && !surface->map->rle_kept
+	   && (surface->flags & SDL_PREALLOC) != SDL_PREALLOC
 	   && (surface->flags & SDL_HWSURFACE) != SDL_HWSURFACE) {
 	    if((surface->flags & SDL_SRCCOLORKEY) == SDL_SRCCOLORKEY) {
 		SDL_Rect full;
 		unsigned alpha_flag;
 
 		/* re-create the original surface */
-		surface->pixels = SDL_malloc(surface->h * surface->pitch);
+		surface->pixels = SDL_AllocPixels(surface,
+					(size_t)surface->h * surface->pitch);
 		if ( !surface->pixels ) {
 			/* Oh crap... */
 			surface->flags |= SDL_RLEACCEL;
@@ -1934,6 +2382,7 @@ void SDL_UnRLESurface(SDL_Surface *surface, int recode)
 	if ( surface->map && surface->map->sw_data->aux_data ) {
 	    SDL_free(surface->map->sw_data->aux_data);
 	    surface->map->sw_data->aux_data = NULL;
+	    surface->map->rle_kept = 0;
 	}
     }
 }
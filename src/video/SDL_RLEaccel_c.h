@@ -29,3 +29,17 @@ extern int SDL_RLEBlit(SDL_Surface *src, SDL_Rect *srcrect,
 extern int SDL_RLEAlphaBlit(SDL_Surface *src, SDL_Rect *srcrect,
 			    SDL_Surface *dst, SDL_Rect *dstrect);
 extern void SDL_UnRLESurface(SDL_Surface *surface, int recode);
+
+/* Returns 1 if the surface kept its raw pixels with the encoding and they
+   haven't changed, otherwise drops an encoding that is out of date */
+extern int SDL_RLEUnchanged(SDL_Surface *surface);
+
+/* Background encoding for SDL_PREPARE_ASYNC.  SDL_RLESurfaceAsync()
+   returns 0 if it queued the encoding, which SDL_RLEFinish() installs
+   when it's done (waiting for it if 'wait' is set), or -1 if the surface
+   should be encoded right away.  SDL_RLECancel() drops the job of a map.
+ */
+extern int SDL_RLESurfaceAsync(SDL_Surface *surface);
+extern void SDL_RLEFinish(SDL_Surface *surface, int wait);
+extern void SDL_RLECancel(SDL_BlitMap *map);
+extern void SDL_RLEQuit(void);
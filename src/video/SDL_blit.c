@@ -26,6 +26,19 @@
 #include "SDL_blit.h"
 #include "SDL_RLEaccel_c.h"
 #include "SDL_pixels_c.h"
+#include "SDL_thread.h"
+#include "SDL_timer.h"
+#include "SDL_cpuinfo.h"
+
+#if SDL_SSE2_BLITTERS
+#include <emmintrin.h>
+#endif
+#if SDL_AVX2_BLITTERS
+#include <immintrin.h>
+#endif
+#if SDL_ARM_NEON_BLITTERS
+#include <arm_neon.h>
+#endif
 
 #if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && SDL_ASSEMBLY_ROUTINES
 #define MMX_ASMBLIT
@@ -35,10 +48,215 @@
 #endif
 
 #if defined(MMX_ASMBLIT)
-#include "SDL_cpuinfo.h"
 #include "mmx.h"
 #endif
 
+#if !SDL_THREADS_DISABLED
+/*
+ * Large software blits can be split into horizontal bands and run on a
+ * pool of worker threads.  This is off unless SDL_BLIT_THREADS is set to
+ * the number of threads to use (including the calling thread); blits
+ * smaller than SDL_BLIT_THREAD_THRESHOLD pixels stay on one thread.
+ */
+#define SDL_BLIT_DEFAULT_THRESHOLD	(320*240)
+
+typedef struct {
+	SDL_Thread *thread;
+	SDL_sem *start;
+	SDL_BandFunc func;
+	void *data;
+	int band;
+} SDL_BlitWorker;
+
+static SDL_BlitWorker blit_workers[SDL_BLIT_MAX_THREADS-1];
+static int blit_threads = 1;
+static int blit_threshold = SDL_BLIT_DEFAULT_THRESHOLD;
+static SDL_sem *blit_done = NULL;
+static SDL_mutex *blit_lock = NULL;
+static volatile int blit_quit = 0;
+
+static int SDLCALL SDL_BlitWorkerThread(void *data)
+{
+	SDL_BlitWorker *worker = (SDL_BlitWorker *)data;
+
+	for ( ; ; ) {
+		SDL_SemWait(worker->start);
+		if ( blit_quit ) {
+			break;
+		}
+		worker->func(worker->data, worker->band);
+		SDL_SemPost(blit_done);
+	}
+	return(0);
+}
+
+void SDL_BlitThreadsInit(void)
+{
+	const char *env;
+	int threads, i;
+
+	if ( blit_threads > 1 ) {
+		return;
+	}
+	env = SDL_getenv("SDL_BLIT_THREADS");
+	threads = env ? SDL_atoi(env) : 0;
+	if ( threads > SDL_BLIT_MAX_THREADS ) {
+		threads = SDL_BLIT_MAX_THREADS;
+	}
+	if ( threads <= 1 ) {
+		return;
+	}
+	env = SDL_getenv("SDL_BLIT_THREAD_THRESHOLD");
+	if ( env ) {
+		blit_threshold = SDL_atoi(env);
+	}
+
+	blit_quit = 0;
+	blit_lock = SDL_CreateMutex();
+	blit_done = SDL_CreateSemaphore(0);
+	if ( !blit_lock || !blit_done ) {
+		SDL_BlitThreadsQuit();
+		return;
+	}
+	for ( i = 0; i < threads-1; ++i ) {
+		SDL_BlitWorker *worker = &blit_workers[i];
+		worker->start = SDL_CreateSemaphore(0);
+		if ( worker->start ) {
+			worker->thread = SDL_CreateThread(SDL_BlitWorkerThread, worker);
+		}
+		if ( !worker->thread ) {
+			break;
+		}
+	}
+	/* Use however many workers we managed to start */
+	blit_threads = i + 1;
+}
+
+void SDL_BlitThreadsQuit(void)
+{
+	int i;
+
+	blit_quit = 1;
+	for ( i = 0; i < SDL_BLIT_MAX_THREADS-1; ++i ) {
+		SDL_BlitWorker *worker = &blit_workers[i];
+		if ( worker->thread ) {
+			SDL_SemPost(worker->start);
+			SDL_WaitThread(worker->thread, NULL);
+			worker->thread = NULL;
+		}
+		if ( worker->start ) {
+			SDL_DestroySemaphore(worker->start);
+			worker->start = NULL;
+		}
+	}
+	if ( blit_done ) {
+		SDL_DestroySemaphore(blit_done);
+		blit_done = NULL;
+	}
+	if ( blit_lock ) {
+		SDL_DestroyMutex(blit_lock);
+		blit_lock = NULL;
+	}
+	blit_threads = 1;
+	blit_threshold = SDL_BLIT_DEFAULT_THRESHOLD;
+}
+
+int SDL_BlitBands(int pixels, int rows)
+{
+	if ( blit_threads <= 1 || pixels < blit_threshold || rows <= 1 ) {
+		return(1);
+	}
+	return(SDL_min(blit_threads, rows));
+}
+
+void SDL_RunBands(SDL_BandFunc func, void *data, int bands)
+{
+	int i;
+
+	if ( bands <= 1 ) {
+		func(data, 0);
+		return;
+	}
+	SDL_mutexP(blit_lock);
+	for ( i = 0; i < bands-1; ++i ) {
+		blit_workers[i].func = func;
+		blit_workers[i].data = data;
+		blit_workers[i].band = i;
+		SDL_SemPost(blit_workers[i].start);
+	}
+	/* The last band runs here while the workers do the rest */
+	func(data, bands-1);
+	for ( i = 0; i < bands-1; ++i ) {
+		SDL_SemWait(blit_done);
+	}
+	SDL_mutexV(blit_lock);
+}
+
+typedef struct {
+	SDL_loblit blit;
+	SDL_BlitInfo bands[SDL_BLIT_MAX_THREADS];
+} SDL_BlitBandJob;
+
+static void SDL_BlitBand(void *data, int band)
+{
+	SDL_BlitBandJob *job = (SDL_BlitBandJob *)data;
+
+	job->blit(&job->bands[band]);
+}
+
+/* Run a blit as horizontal bands on the worker threads.
+   Returns 0 if the blit should run on the calling thread instead. */
+static int SDL_ThreadedBlit(SDL_loblit blit, SDL_BlitInfo *info,
+                            int srcpitch, int dstpitch)
+{
+	SDL_BlitBandJob job;
+	SDL_BlitInfo *band;
+	int bands, rows, y, i;
+
+	bands = SDL_BlitBands(info->d_width * info->d_height, info->d_height);
+	if ( bands <= 1 ) {
+		return(0);
+	}
+
+	job.blit = blit;
+	y = 0;
+	for ( i = 0; i < bands; ++i ) {
+		band = &job.bands[i];
+		*band = *info;
+		rows = (info->d_height - y) / (bands - i);
+		band->s_pixels += y * srcpitch;
+		band->d_pixels += y * dstpitch;
+		band->s_height = band->d_height = rows;
+		band->d_y = info->d_y + y;
+		y += rows;
+	}
+	SDL_RunBands(SDL_BlitBand, &job, bands);
+	return(1);
+}
+#else
+void SDL_BlitThreadsInit(void)
+{
+}
+
+void SDL_BlitThreadsQuit(void)
+{
+}
+
+int SDL_BlitBands(int pixels, int rows)
+{
+	return(1);
+}
+
+void SDL_RunBands(SDL_BandFunc func, void *data, int bands)
+{
+	int i;
+
+	for ( i = 0; i < bands; ++i ) {
+		func(data, i);
+	}
+}
+#endif /* !SDL_THREADS_DISABLED */
+
 /* The general purpose software blit routine */
 static int SDL_SoftBlit(SDL_Surface *src, SDL_Rect *srcrect,
 			SDL_Surface *dst, SDL_Rect *dstrect)
@@ -87,13 +305,21 @@ static int SDL_SoftBlit(SDL_Surface *src, SDL_Rect *srcrect,
 		info.d_width = dstrect->w;
 		info.d_height = dstrect->h;
 		info.d_skip=dst->pitch-info.d_width*dst->format->BytesPerPixel;
+		info.d_x = dstrect->x;
+		info.d_y = dstrect->y;
 		info.aux_data = src->map->sw_data->aux_data;
 		info.src = src->format;
 		info.table = src->map->table;
+		info.pair_table = src->map->pair_table;
 		info.dst = dst->format;
 		RunBlit = src->map->sw_data->blit;
 
 		/* Run the actual software blit */
+#if !SDL_THREADS_DISABLED
+		/* Overlapping blits on one surface depend on the row order */
+		if ( src == dst ||
+		     !SDL_ThreadedBlit(RunBlit, &info, src->pitch, dst->pitch) )
+#endif
 		RunBlit(&info);
 	}
 
@@ -152,6 +378,339 @@ static __inline__ void SDL_memcpySSE(Uint8 *to, const Uint8 *from, int len)
 #endif
 #endif
 
+/*
+ * Row copy engine for identity blits.  The copy and move routines are
+ * picked once for the CPU by SDL_InitCopyFuncs().  Copies that total at
+ * least SDL_COPY_STREAM_THRESHOLD bytes (default 16MB, 0 disables) use
+ * non-temporal stores, so a big transfer doesn't flush the whole cache.
+ * The move routines are safe for overlapping rows in either direction.
+ */
+#define SDL_COPY_STREAM_BYTES	(16*1024*1024)
+
+typedef void (*SDL_CopyRowFunc)(Uint8 *dst, const Uint8 *src, int len,
+                                int stream);
+typedef void (*SDL_MoveRowFunc)(Uint8 *dst, const Uint8 *src, int len);
+
+static SDL_CopyRowFunc SDL_CopyRow = NULL;
+static SDL_MoveRowFunc SDL_MoveRow = NULL;
+static int copy_stream_threshold = 0;
+static int copy_funcs_ready = 0;
+
+#if SDL_SSE2_BLITTERS
+/* The body of the row copy from the first aligned store on, with aligned
+   loads too if the source is at the same offset in its 16 bytes, as it is
+   for whole rows of SDL_SIMDALIGNED surfaces.  Returns how many bytes it
+   copied, which leaves less than 16 before end. */
+static __inline__ int SDL_CopyRowBodySSE2(Uint8 *p, const Uint8 *src,
+                                          Uint8 *end, int aligned)
+{
+	Uint8 *start = p;
+
+	/* 16 byte streaming stores measured slower than cached ones, so
+	   only the AVX2 copy honours the stream flag */
+	for ( ; p+64 <= end; p += 64, src += 64 ) {
+		__m128i a, b, c, d;
+		a = SDL_LOAD_SSE2(aligned, src);
+		b = SDL_LOAD_SSE2(aligned, src+16);
+		c = SDL_LOAD_SSE2(aligned, src+32);
+		d = SDL_LOAD_SSE2(aligned, src+48);
+		_mm_store_si128((__m128i *)p, a);
+		_mm_store_si128((__m128i *)(p+16), b);
+		_mm_store_si128((__m128i *)(p+32), c);
+		_mm_store_si128((__m128i *)(p+48), d);
+	}
+	for ( ; p+16 <= end; p += 16, src += 16 ) {
+		_mm_store_si128((__m128i *)p, SDL_LOAD_SSE2(aligned, src));
+	}
+	return(p - start);
+}
+
+static void SDL_CopyRowSSE2(Uint8 *dst, const Uint8 *src, int len, int stream)
+{
+	Uint8 *end = dst + len;
+	Uint8 *p;
+	int done;
+
+	if ( len < 16 ) {
+		SDL_memcpy(dst, src, len);
+		return;
+	}
+
+	/* Unaligned head, then aligned stores from the next 16 byte boundary */
+	_mm_storeu_si128((__m128i *)dst, _mm_loadu_si128((const __m128i *)src));
+	p = (Uint8 *)(((uintptr_t)dst + 16) & ~(uintptr_t)15);
+	src += (p - dst);
+	if ( ((uintptr_t)src & 15) == 0 ) {
+		done = SDL_CopyRowBodySSE2(p, src, end, 1);
+	} else {
+		done = SDL_CopyRowBodySSE2(p, src, end, 0);
+	}
+	p += done;
+	src += done;
+	if ( p < end ) {
+		src -= (p - (end-16));
+		_mm_storeu_si128((__m128i *)(end-16),
+		                 _mm_loadu_si128((const __m128i *)src));
+	}
+}
+
+static void SDL_MoveRowSSE2(Uint8 *dst, const Uint8 *src, int len)
+{
+	__m128i edge, a, b;
+	int i;
+
+	if ( len < 32 ) {
+		SDL_memmove(dst, src, len);
+		return;
+	}
+
+	/* Every chunk is loaded before it is stored, walking away from the
+	   overlap, and the ragged edge is saved up front and written last. */
+	if ( dst <= src ) {
+		edge = _mm_loadu_si128((const __m128i *)(src+len-16));
+		for ( i = 0; i+32 <= len; i += 32 ) {
+			a = _mm_loadu_si128((const __m128i *)(src+i));
+			b = _mm_loadu_si128((const __m128i *)(src+i+16));
+			_mm_storeu_si128((__m128i *)(dst+i), a);
+			_mm_storeu_si128((__m128i *)(dst+i+16), b);
+		}
+		if ( i+16 <= len ) {
+			a = _mm_loadu_si128((const __m128i *)(src+i));
+			_mm_storeu_si128((__m128i *)(dst+i), a);
+		}
+		_mm_storeu_si128((__m128i *)(dst+len-16), edge);
+	} else {
+		edge = _mm_loadu_si128((const __m128i *)src);
+		for ( i = len; i-32 >= 0; i -= 32 ) {
+			a = _mm_loadu_si128((const __m128i *)(src+i-16));
+			b = _mm_loadu_si128((const __m128i *)(src+i-32));
+			_mm_storeu_si128((__m128i *)(dst+i-16), a);
+			_mm_storeu_si128((__m128i *)(dst+i-32), b);
+		}
+		if ( i-16 >= 0 ) {
+			a = _mm_loadu_si128((const __m128i *)(src+i-16));
+			_mm_storeu_si128((__m128i *)(dst+i-16), a);
+		}
+		_mm_storeu_si128((__m128i *)dst, edge);
+	}
+}
+#endif /* SDL_SSE2_BLITTERS */
+
+#if SDL_AVX2_BLITTERS
+/* As SDL_CopyRowBodySSE2(), 32 bytes at a time */
+static SDL_TARGET_AVX2 __inline__ int SDL_CopyRowBodyAVX2(Uint8 *p,
+                        const Uint8 *src, Uint8 *end, int stream, int aligned)
+{
+	Uint8 *start = p;
+
+	if ( stream ) {
+		for ( ; p+128 <= end; p += 128, src += 128 ) {
+			__m256i a, b, c, d;
+			_mm_prefetch((const char *)src + 512, _MM_HINT_NTA);
+			_mm_prefetch((const char *)src + 576, _MM_HINT_NTA);
+			a = SDL_LOAD_AVX2(aligned, src);
+			b = SDL_LOAD_AVX2(aligned, src+32);
+			c = SDL_LOAD_AVX2(aligned, src+64);
+			d = SDL_LOAD_AVX2(aligned, src+96);
+			_mm256_stream_si256((__m256i *)p, a);
+			_mm256_stream_si256((__m256i *)(p+32), b);
+			_mm256_stream_si256((__m256i *)(p+64), c);
+			_mm256_stream_si256((__m256i *)(p+96), d);
+		}
+	} else {
+		for ( ; p+128 <= end; p += 128, src += 128 ) {
+			__m256i a, b, c, d;
+			a = SDL_LOAD_AVX2(aligned, src);
+			b = SDL_LOAD_AVX2(aligned, src+32);
+			c = SDL_LOAD_AVX2(aligned, src+64);
+			d = SDL_LOAD_AVX2(aligned, src+96);
+			_mm256_store_si256((__m256i *)p, a);
+			_mm256_store_si256((__m256i *)(p+32), b);
+			_mm256_store_si256((__m256i *)(p+64), c);
+			_mm256_store_si256((__m256i *)(p+96), d);
+		}
+	}
+	for ( ; p+32 <= end; p += 32, src += 32 ) {
+		_mm256_store_si256((__m256i *)p, SDL_LOAD_AVX2(aligned, src));
+	}
+	return(p - start);
+}
+
+static SDL_TARGET_AVX2 void SDL_CopyRowAVX2(Uint8 *dst, const Uint8 *src,
+                                            int len, int stream)
+{
+	Uint8 *end = dst + len;
+	Uint8 *p;
+	int done;
+
+	if ( len < 32 ) {
+		SDL_memcpy(dst, src, len);
+		return;
+	}
+
+	_mm256_storeu_si256((__m256i *)dst,
+	                    _mm256_loadu_si256((const __m256i *)src));
+	p = (Uint8 *)(((uintptr_t)dst + 32) & ~(uintptr_t)31);
+	src += (p - dst);
+	if ( ((uintptr_t)src & 31) == 0 ) {
+		done = SDL_CopyRowBodyAVX2(p, src, end, stream, 1);
+	} else {
+		done = SDL_CopyRowBodyAVX2(p, src, end, stream, 0);
+	}
+	p += done;
+	src += done;
+	if ( p < end ) {
+		src -= (p - (end-32));
+		_mm256_storeu_si256((__m256i *)(end-32),
+		                    _mm256_loadu_si256((const __m256i *)src));
+	}
+}
+
+static SDL_TARGET_AVX2 void SDL_MoveRowAVX2(Uint8 *dst, const Uint8 *src,
+                                            int len)
+{
+	__m256i edge, a, b;
+	int i;
+
+	if ( len < 64 ) {
+		SDL_memmove(dst, src, len);
+		return;
+	}
+
+	if ( dst <= src ) {
+		edge = _mm256_loadu_si256((const __m256i *)(src+len-32));
+		for ( i = 0; i+64 <= len; i += 64 ) {
+			a = _mm256_loadu_si256((const __m256i *)(src+i));
+			b = _mm256_loadu_si256((const __m256i *)(src+i+32));
+			_mm256_storeu_si256((__m256i *)(dst+i), a);
+			_mm256_storeu_si256((__m256i *)(dst+i+32), b);
+		}
+		if ( i+32 <= len ) {
+			a = _mm256_loadu_si256((const __m256i *)(src+i));
+			_mm256_storeu_si256((__m256i *)(dst+i), a);
+		}
+		_mm256_storeu_si256((__m256i *)(dst+len-32), edge);
+	} else {
+		edge = _mm256_loadu_si256((const __m256i *)src);
+		for ( i = len; i-64 >= 0; i -= 64 ) {
+			a = _mm256_loadu_si256((const __m256i *)(src+i-32));
+			b = _mm256_loadu_si256((const __m256i *)(src+i-64));
+			_mm256_storeu_si256((__m256i *)(dst+i-32), a);
+			_mm256_storeu_si256((__m256i *)(dst+i-64), b);
+		}
+		if ( i-32 >= 0 ) {
+			a = _mm256_loadu_si256((const __m256i *)(src+i-32));
+			_mm256_storeu_si256((__m256i *)(dst+i-32), a);
+		}
+		_mm256_storeu_si256((__m256i *)dst, edge);
+	}
+}
+#endif /* SDL_AVX2_BLITTERS */
+
+#if SDL_ARM_NEON_BLITTERS
+static void SDL_CopyRowNEON(Uint8 *dst, const Uint8 *src, int len, int stream)
+{
+	int i;
+
+	if ( len < 16 ) {
+		SDL_memcpy(dst, src, len);
+		return;
+	}
+
+	/* NEON has no streaming stores, the flag only turns on prefetching */
+	for ( i = 0; i+64 <= len; i += 64 ) {
+		uint8x16_t a, b, c, d;
+		if ( stream ) {
+			__builtin_prefetch(src+i+512, 0, 0);
+		}
+		a = vld1q_u8(src+i);
+		b = vld1q_u8(src+i+16);
+		c = vld1q_u8(src+i+32);
+		d = vld1q_u8(src+i+48);
+		vst1q_u8(dst+i, a);
+		vst1q_u8(dst+i+16, b);
+		vst1q_u8(dst+i+32, c);
+		vst1q_u8(dst+i+48, d);
+	}
+	for ( ; i+16 <= len; i += 16 ) {
+		vst1q_u8(dst+i, vld1q_u8(src+i));
+	}
+	if ( i < len ) {
+		vst1q_u8(dst+len-16, vld1q_u8(src+len-16));
+	}
+}
+
+static void SDL_MoveRowNEON(Uint8 *dst, const Uint8 *src, int len)
+{
+	uint8x16_t edge, a, b;
+	int i;
+
+	if ( len < 32 ) {
+		SDL_memmove(dst, src, len);
+		return;
+	}
+
+	if ( dst <= src ) {
+		edge = vld1q_u8(src+len-16);
+		for ( i = 0; i+32 <= len; i += 32 ) {
+			a = vld1q_u8(src+i);
+			b = vld1q_u8(src+i+16);
+			vst1q_u8(dst+i, a);
+			vst1q_u8(dst+i+16, b);
+		}
+		if ( i+16 <= len ) {
+			vst1q_u8(dst+i, vld1q_u8(src+i));
+		}
+		vst1q_u8(dst+len-16, edge);
+	} else {
+		edge = vld1q_u8(src);
+		for ( i = len; i-32 >= 0; i -= 32 ) {
+			a = vld1q_u8(src+i-16);
+			b = vld1q_u8(src+i-32);
+			vst1q_u8(dst+i-16, a);
+			vst1q_u8(dst+i-32, b);
+		}
+		if ( i-16 >= 0 ) {
+			vst1q_u8(dst+i-16, vld1q_u8(src+i-16));
+		}
+		vst1q_u8(dst, edge);
+	}
+}
+#endif /* SDL_ARM_NEON_BLITTERS */
+
+static void SDL_InitCopyFuncs(void)
+{
+	const char *env;
+
+	if ( copy_funcs_ready ) {
+		return;
+	}
+#if SDL_ARM_NEON_BLITTERS
+	if ( SDL_HasNEON() ) {
+		SDL_CopyRow = SDL_CopyRowNEON;
+		SDL_MoveRow = SDL_MoveRowNEON;
+	}
+#endif
+#if SDL_SSE2_BLITTERS
+	if ( SDL_HasSSE2() ) {
+		SDL_CopyRow = SDL_CopyRowSSE2;
+		SDL_MoveRow = SDL_MoveRowSSE2;
+	}
+#endif
+#if SDL_AVX2_BLITTERS
+	if ( SDL_HasAVX2() ) {
+		SDL_CopyRow = SDL_CopyRowAVX2;
+		SDL_MoveRow = SDL_MoveRowAVX2;
+	}
+#endif
+	env = SDL_getenv("SDL_COPY_STREAM_THRESHOLD");
+	copy_stream_threshold = env ? SDL_atoi(env) : SDL_COPY_STREAM_BYTES;
+	if ( copy_stream_threshold < 0 ) {
+		copy_stream_threshold = 0;
+	}
+	copy_funcs_ready = 1;
+}
+
 static void SDL_BlitCopy(SDL_BlitInfo *info)
 {
 	Uint8 *src, *dst;
@@ -165,6 +724,21 @@ static void SDL_BlitCopy(SDL_BlitInfo *info)
 	srcskip = w+info->s_skip;
 	dstskip = w+info->d_skip;
 
+	if ( SDL_CopyRow ) {
+		int stream = (copy_stream_threshold &&
+		              w * h >= copy_stream_threshold);
+		while ( h-- ) {
+			SDL_CopyRow(dst, src, w, stream);
+			src += srcskip;
+			dst += dstskip;
+		}
+#if SDL_SSE2_BLITTERS
+		if ( stream ) {
+			/* Order the streaming stores before anything that follows */
+			_mm_sfence();
+		}
+#endif
+	} else
 #ifdef SSE_ASMBLIT
 	if(SDL_HasSSE())
 	{
@@ -212,7 +786,20 @@ static void SDL_BlitCopyOverlap(SDL_BlitInfo *info)
 	dst = info->d_pixels;
 	srcskip = w+info->s_skip;
 	dstskip = w+info->d_skip;
-	if ( dst < src ) {
+	if ( SDL_MoveRow ) {
+		/* Each row is overlap safe, so only the row order matters */
+		if ( dst > src ) {
+			src += ((h-1) * srcskip);
+			dst += ((h-1) * dstskip);
+			srcskip = -srcskip;
+			dstskip = -dstskip;
+		}
+		while ( h-- ) {
+			SDL_MoveRow(dst, src, w);
+			src += srcskip;
+			dst += dstskip;
+		}
+	} else if ( dst < src ) {
 		while ( h-- ) {
 			SDL_memmove(dst, src, w);
 			src += srcskip;
@@ -229,6 +816,225 @@ static void SDL_BlitCopyOverlap(SDL_BlitInfo *info)
 	}
 }
 
+static const SDL_BlitterName SDL_BlitterNamesCopy[] = {
+	SDL_BLITTER_NAME(SDL_BlitCopy),
+	SDL_BLITTER_NAME(SDL_BlitCopyOverlap),
+	{ NULL, NULL }
+};
+
+/*
+ * The blit functions chosen by SDL_CalculateBlit{0,1,N}() are cached
+ * process wide, keyed by everything those functions look at, so that
+ * remapping a surface after a palette, colorkey or alpha change doesn't
+ * walk the blitter tables again.  The cache is direct mapped; an entry
+ * is simply replaced when another key hashes to the same slot.  Entries
+ * are only read and written with SDL_LockMapCache() held.
+ */
+#define SDL_BLIT_CACHE_SIZE	64	/* Must be a power of two */
+#define SDL_BLIT_KEY_WORDS	11
+
+typedef struct {
+	Uint32 key[SDL_BLIT_KEY_WORDS];
+	SDL_loblit blit;
+	void *aux_data;
+} SDL_BlitCacheEntry;
+
+static SDL_BlitCacheEntry blit_cache[SDL_BLIT_CACHE_SIZE];
+SDL_BlitCacheStats SDL_blit_cache_stats;
+
+static SDL_BlitCacheEntry *SDL_BlitCacheKey(SDL_Surface *surface,
+                                            int blit_index, Uint32 *key)
+{
+	SDL_PixelFormat *sf = surface->format;
+	SDL_PixelFormat *df = surface->map->dst->format;
+	Uint32 hash;
+	int i;
+
+	/* key[0] is never zero, so an empty entry can't match */
+	key[0] = (sf->BitsPerPixel | (sf->BytesPerPixel << 8) |
+	          (df->BitsPerPixel << 16) | (df->BytesPerPixel << 24));
+	key[1] = sf->Rmask;
+	key[2] = sf->Gmask;
+	key[3] = sf->Bmask;
+	key[4] = sf->Amask;
+	key[5] = df->Rmask;
+	key[6] = df->Gmask;
+	key[7] = df->Bmask;
+	key[8] = df->Amask;
+	key[9] = (blit_index |
+	          (surface->map->identity << 2) |
+	          ((surface->map->table != NULL) << 3) |
+	          ((surface == surface->map->dst) << 4) |
+	          (((surface->map->dst->flags & SDL_HWSURFACE) != 0) << 5) |
+	          ((surface->flags & SDL_SRCCOLORKEY) ? 0x40 : 0) |
+	          ((blit_index & 2) ? (sf->alpha << 8) : 0));
+	key[10] = (SDL_HasMMX() | (SDL_HasSSE() << 1) | (SDL_HasSSE2() << 2) |
+	           (SDL_HasAVX2() << 3) | (SDL_HasAltiVec() << 4) |
+	           (SDL_HasNEON() << 5));
+
+	hash = 2166136261u;
+	for ( i = 0; i < SDL_BLIT_KEY_WORDS; ++i ) {
+		hash = (hash ^ key[i]) * 16777619u;
+	}
+	hash ^= (hash >> 16);
+	return &blit_cache[hash & (SDL_BLIT_CACHE_SIZE-1)];
+}
+
+/* Choose the blit function for a non-identity mapping */
+static SDL_loblit SDL_ChooseBlit(SDL_Surface *surface, int blit_index)
+{
+	if ( surface->format->BitsPerPixel < 8 ) {
+		return SDL_CalculateBlit0(surface, blit_index);
+	}
+	switch ( surface->format->BytesPerPixel ) {
+	    case 1:
+		return SDL_CalculateBlit1(surface, blit_index);
+	    case 2:
+	    case 3:
+	    case 4:
+		return SDL_CalculateBlitN(surface, blit_index);
+	    default:
+		return NULL;
+	}
+}
+
+static SDL_loblit SDL_CachedBlit(SDL_Surface *surface, int blit_index)
+{
+	struct private_swaccel *sdata = surface->map->sw_data;
+	Uint32 key[SDL_BLIT_KEY_WORDS];
+	SDL_BlitCacheEntry *entry;
+	SDL_loblit blit;
+
+	entry = SDL_BlitCacheKey(surface, blit_index, key);
+	SDL_LockMapCache();
+	if ( SDL_memcmp(entry->key, key, sizeof(key)) == 0 ) {
+		++SDL_blit_cache_stats.blit_hits;
+		sdata->aux_data = entry->aux_data;
+		blit = entry->blit;
+		SDL_UnlockMapCache();
+		return blit;
+	}
+	++SDL_blit_cache_stats.blit_misses;
+	SDL_UnlockMapCache();
+
+	sdata->aux_data = NULL;
+	blit = SDL_ChooseBlit(surface, blit_index);
+	if ( blit != NULL ) {
+		SDL_LockMapCache();
+		SDL_memcpy(entry->key, key, sizeof(key));
+		entry->blit = blit;
+		entry->aux_data = sdata->aux_data;
+		SDL_UnlockMapCache();
+	}
+	return blit;
+}
+
+void SDL_GetBlitCacheStats(SDL_BlitCacheStats *stats, int reset)
+{
+	SDL_LockMapCache();
+	if ( stats ) {
+		*stats = SDL_blit_cache_stats;
+	}
+	if ( reset ) {
+		SDL_memset(&SDL_blit_cache_stats, 0, sizeof(SDL_blit_cache_stats));
+	}
+	SDL_UnlockMapCache();
+}
+
+/* Return the name of the blitter used for the surface's current mapping */
+const char *SDL_GetBlitterName(SDL_Surface *surface)
+{
+	static const SDL_BlitterName *tables[] = {
+		SDL_BlitterNamesCopy, SDL_BlitterNames0, SDL_BlitterNames1,
+		SDL_BlitterNamesN, SDL_BlitterNamesA, SDL_BlitterNamesAuto
+	};
+	SDL_BlitMap *map;
+	SDL_loblit blit;
+	int i, j;
+
+	if ( !surface || !surface->map || !surface->map->dst ||
+	     surface->map->format_version != surface->map->dst->format_version ) {
+		SDL_SetError("Surface has not been blitted");
+		return(NULL);
+	}
+	map = surface->map;
+	if ( (surface->flags & SDL_HWACCEL) == SDL_HWACCEL ) {
+		return("hardware");
+	}
+	if ( map->sw_blit == SDL_RLEBlit ) {
+		return("SDL_RLEBlit");
+	}
+	if ( map->sw_blit == SDL_RLEAlphaBlit ) {
+		return("SDL_RLEAlphaBlit");
+	}
+	blit = map->sw_data->blit;
+	for ( i = 0; i < SDL_arraysize(tables); ++i ) {
+		for ( j = 0; tables[i][j].blit; ++j ) {
+			if ( tables[i][j].blit == blit ) {
+				return(tables[i][j].name);
+			}
+		}
+	}
+	return("unknown");
+}
+
+/*
+ * RLE encoding lets colorkey blits skip transparent runs, but 16-bit RLE
+ * surfaces pay for it with per-run overhead, and any RLE surface has to
+ * be decoded and encoded again each time it is locked.  If there is a
+ * SIMD colorkey blitter for the surface, it is used instead of RLE when
+ * the surface has fewer pixels than SDL_VIDEO_RLE_MIN_PIXELS (by default
+ * SDL_RLE_MIN_PIXELS16 for 16-bit surfaces and 0 otherwise), or when it
+ * was re-encoded SDL_RLE_MAX_RECODES times within SDL_RLE_RECODE_PERIOD
+ * milliseconds.
+ */
+#define SDL_RLE_MIN_PIXELS16	(128*128)
+#define SDL_RLE_MAX_RECODES	4
+#define SDL_RLE_RECODE_PERIOD	1000
+
+static int rle_min_pixels = -2;
+
+int SDL_PreferKeyBlit(SDL_Surface *surface)
+{
+	int min_pixels;
+
+	if ( !SDL_IsKeyBlitSIMD(surface->map->sw_data->blit) ) {
+		return(0);
+	}
+	if ( rle_min_pixels == -2 ) {
+		const char *env = SDL_getenv("SDL_VIDEO_RLE_MIN_PIXELS");
+		rle_min_pixels = -1;	/* depends on the pixel size */
+		if ( env ) {
+			rle_min_pixels = SDL_atoi(env);
+			if ( rle_min_pixels < 0 ) {
+				rle_min_pixels = 0;
+			}
+		}
+	}
+	min_pixels = rle_min_pixels;
+	if ( min_pixels < 0 ) {
+		min_pixels = (surface->format->BytesPerPixel == 2) ?
+		             SDL_RLE_MIN_PIXELS16 : 0;
+	}
+	return( surface->w * surface->h < min_pixels ||
+	        surface->map->rle_recodes >= SDL_RLE_MAX_RECODES );
+}
+
+/* Called when an RLE surface is unlocked, returns true if it should be
+   encoded again rather than blitted from the raw pixels from now on */
+int SDL_RecodeRLE(SDL_Surface *surface)
+{
+	SDL_BlitMap *map = surface->map;
+	Uint32 now = SDL_GetTicks();
+
+	if ( (now - map->rle_recode_ticks) > SDL_RLE_RECODE_PERIOD ) {
+		map->rle_recode_ticks = now;
+		map->rle_recodes = 0;
+	}
+	++map->rle_recodes;
+	return( !SDL_PreferKeyBlit(surface) );
+}
+
 /* Figure out which of many blit routines to set up on a surface */
 int SDL_CalculateBlit(SDL_Surface *surface)
 {
@@ -302,6 +1108,7 @@ int SDL_CalculateBlit(SDL_Surface *surface)
 
 	/* Check for special "identity" case -- copy blit */
 	if ( surface->map->identity && blit_index == 0 ) {
+		SDL_InitCopyFuncs();
 	        surface->map->sw_data->blit = SDL_BlitCopy;
 
 		/* Handle overlapping blits on the same surface */
@@ -309,26 +1116,8 @@ int SDL_CalculateBlit(SDL_Surface *surface)
 		        surface->map->sw_data->blit = SDL_BlitCopyOverlap;
 		}
 	} else {
-		if ( surface->format->BitsPerPixel < 8 ) {
-			surface->map->sw_data->blit =
-			    SDL_CalculateBlit0(surface, blit_index);
-		} else {
-			switch ( surface->format->BytesPerPixel ) {
-			    case 1:
-				surface->map->sw_data->blit =
-				    SDL_CalculateBlit1(surface, blit_index);
-				break;
-			    case 2:
-			    case 3:
-			    case 4:
-				surface->map->sw_data->blit =
-				    SDL_CalculateBlitN(surface, blit_index);
-				break;
-			    default:
-				surface->map->sw_data->blit = NULL;
-				break;
-			}
-		}
+		surface->map->sw_data->blit =
+		    SDL_CachedBlit(surface, blit_index);
 	}
 	/* Make sure we have a blit function */
 	if ( surface->map->sw_data->blit == NULL ) {
@@ -337,18 +1126,33 @@ int SDL_CalculateBlit(SDL_Surface *surface)
 		return(-1);
 	}
 
-	/* Choose software blitting function */
+	/* Choose software blitting function; an RLE encoding done in the
+	   background leaves the raw pixels blitted until it's installed */
 	if(surface->flags & SDL_RLEACCELOK
 	   && (surface->flags & SDL_HWACCEL) != SDL_HWACCEL) {
 
 	        if(surface->map->identity
 		   && (blit_index == 1
 		       || (blit_index == 3 && !surface->format->Amask))) {
-		        if ( SDL_RLESurface(surface) == 0 )
+		        if ( SDL_PreferKeyBlit(surface) ) {
+			        SDL_LockMapCache();
+			        ++SDL_blit_cache_stats.rle_skipped;
+			        SDL_UnlockMapCache();
+			} else if ( SDL_RLESurfaceAsync(surface) < 0 &&
+			            SDL_RLESurface(surface) == 0 ) {
+			        SDL_LockMapCache();
+			        ++SDL_blit_cache_stats.rle_encoded;
+			        SDL_UnlockMapCache();
 			        surface->map->sw_blit = SDL_RLEBlit;
+			}
 		} else if(blit_index == 2 && surface->format->Amask) {
-		        if ( SDL_RLESurface(surface) == 0 )
+		        if ( SDL_RLESurfaceAsync(surface) < 0 &&
+			     SDL_RLESurface(surface) == 0 ) {
+			        SDL_LockMapCache();
+			        ++SDL_blit_cache_stats.rle_encoded;
+			        SDL_UnlockMapCache();
 			        surface->map->sw_blit = SDL_RLEAlphaBlit;
+			}
 		}
 	}
 	
@@ -36,9 +36,11 @@ typedef struct {
 	int d_width;
 	int d_height;
 	int d_skip;
+	int d_x, d_y;		/* Destination position, for dithering */
 	void *aux_data;
 	SDL_PixelFormat *src;
 	Uint8 *table;
+	Uint8 *pair_table;
 	SDL_PixelFormat *dst;
 } SDL_BlitInfo;
 
@@ -56,10 +58,20 @@ typedef struct SDL_BlitMap {
 	SDL_Surface *dst;
 	int identity;
 	Uint8 *table;
+	Uint8 *pair_table;	/* Two pixels per lookup, see SDL_MapSurface() */
 	SDL_blit hw_blit;
 	SDL_blit sw_blit;
 	struct private_hwaccel *hw_data;
 	struct private_swaccel *sw_data;
+	unsigned int rle_recodes;	/* RLE re-encodings on unlock, */
+	Uint32 rle_recode_ticks;	/* counted since this time */
+	Uint32 prepare_flags;		/* SDL_PREPARE_* from SDL_PrepareSurface() */
+	struct SDL_RLEJob *rle_job;	/* RLE encoding running in the background */
+	int rle_kept;			/* raw pixels kept with the RLE encoding, */
+	Uint32 rle_hash[8];		/* and a hash of them */
+	int pool_class;			/* size class + 1 of the pixels, */
+	void *pool_pixels;		/* if SDL_PoolAllocPixels() made them */
+	struct SDL_Surface *pool_next;	/* next free surface in the pool */
 
 	/* the version count matches the destination; mismatch indicates
 	   an invalid mapping */
@@ -69,12 +81,119 @@ typedef struct SDL_BlitMap {
 
 /* Functions found in SDL_blit.c */
 extern int SDL_CalculateBlit(SDL_Surface *surface);
+extern int SDL_PreferKeyBlit(SDL_Surface *surface);
+extern int SDL_RecodeRLE(SDL_Surface *surface);
+extern void SDL_BlitThreadsInit(void);
+extern void SDL_BlitThreadsQuit(void);
+
+/* Work split into row bands for the blit worker threads, in SDL_blit.c.
+   SDL_BlitBands() returns how many bands a job of 'pixels' pixels in
+   'rows' rows should be split into, at most SDL_BLIT_MAX_THREADS, or 1
+   if it should run on the calling thread alone.  SDL_RunBands() calls
+   func(data, band) for each band, the last one on the calling thread,
+   and returns when all of them are done.
+ */
+#define SDL_BLIT_MAX_THREADS	16
+typedef void (*SDL_BandFunc)(void *data, int band);
+extern int SDL_BlitBands(int pixels, int rows);
+extern void SDL_RunBands(SDL_BandFunc func, void *data, int bands);
+
+/* Cache counters reported by SDL_GetBlitCacheStats(), in SDL_blit.c */
+extern SDL_BlitCacheStats SDL_blit_cache_stats;
 
 /* Functions found in SDL_blit_{0,1,N,A}.c */
 extern SDL_loblit SDL_CalculateBlit0(SDL_Surface *surface, int complex);
 extern SDL_loblit SDL_CalculateBlit1(SDL_Surface *surface, int complex);
 extern SDL_loblit SDL_CalculateBlitN(SDL_Surface *surface, int complex);
 extern SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int complex);
+extern int SDL_IsKeyBlitSIMD(SDL_loblit blit);
+
+/* Operations with generated kernels in SDL_blit_auto.c */
+enum {
+	SDL_BLIT_AUTO_COPY,		/* BlitNtoN, BlitNtoNCopyAlpha */
+	SDL_BLIT_AUTO_KEY,		/* BlitNtoNKey, BlitNtoNKeyCopyAlpha */
+	SDL_BLIT_AUTO_ALPHA,		/* BlitNtoNSurfaceAlpha */
+	SDL_BLIT_AUTO_ALPHAKEY,		/* BlitNtoNSurfaceAlphaKey */
+	SDL_BLIT_AUTO_PIXELALPHA,	/* BlitNtoNPixelAlpha */
+	SDL_BLIT_AUTO_OPS
+};
+
+/* Returns the generated kernel for the format pair, or NULL */
+extern SDL_loblit SDL_CalculateBlitAuto(SDL_PixelFormat *srcfmt,
+                                        SDL_PixelFormat *dstfmt, int op);
+
+/* Names of the low level blitters, reported by SDL_GetBlitterName() */
+typedef struct {
+	SDL_loblit blit;
+	const char *name;
+} SDL_BlitterName;
+#define SDL_BLITTER_NAME(blit)	{ blit, #blit }
+
+/* Tables found in SDL_blit_{0,1,N,A,auto}.c, ending with a NULL entry */
+extern const SDL_BlitterName SDL_BlitterNames0[];
+extern const SDL_BlitterName SDL_BlitterNames1[];
+extern const SDL_BlitterName SDL_BlitterNamesN[];
+extern const SDL_BlitterName SDL_BlitterNamesA[];
+extern const SDL_BlitterName SDL_BlitterNamesAuto[];
+
+#if SDL_AVX2_BLITTERS
+/* AVX2 code is compiled per function and only called after SDL_HasAVX2() */
+#define SDL_TARGET_AVX2	__attribute__((target("avx2")))
+#endif
+
+/* Run a scalar blitter over the columns a SIMD loop left over on the right */
+static __inline__ void SDL_BlitRemainder(SDL_BlitInfo *info, int done,
+                                         SDL_loblit blit)
+{
+	SDL_BlitInfo tail = *info;
+	int srcbpp = info->src->BytesPerPixel;
+	int dstbpp = info->dst->BytesPerPixel;
+
+	tail.d_width = info->d_width - done;
+	if ( tail.d_width <= 0 ) {
+		return;
+	}
+	tail.s_width = tail.d_width;
+	tail.s_pixels += done * srcbpp;
+	tail.d_pixels += done * dstbpp;
+	tail.s_skip += done * srcbpp;
+	tail.d_skip += done * dstbpp;
+	tail.d_x += done;
+	blit(&tail);
+}
+
+/* Pixel and pitch alignment of SDL_SIMDALIGNED surfaces, a cache line */
+#define SDL_SURFACE_ALIGNMENT	64
+
+/* Nonzero if every row of the blit starts on an 'align' byte boundary
+   (a power of two) in both surfaces.  SIMD kernels take an 'aligned'
+   argument that is constant in each call, so the compiler builds an
+   aligned and an unaligned version and this picks between them. */
+static __inline__ int SDL_BlitIsAligned(const SDL_BlitInfo *info, int align)
+{
+	uintptr_t bits;
+
+	bits = (uintptr_t)info->s_pixels | (uintptr_t)info->d_pixels;
+	bits |= (uintptr_t)(info->s_skip +
+	                    info->d_width * info->src->BytesPerPixel);
+	bits |= (uintptr_t)(info->d_skip +
+	                    info->d_width * info->dst->BytesPerPixel);
+	return((bits & (align - 1)) == 0);
+}
+
+/* Vector loads and stores for those kernels */
+#define SDL_LOAD_SSE2(aligned, p)					\
+	((aligned) ? _mm_load_si128((const __m128i *)(p)) :		\
+	             _mm_loadu_si128((const __m128i *)(p)))
+#define SDL_STORE_SSE2(aligned, p, v)					\
+	((aligned) ? _mm_store_si128((__m128i *)(p), (v)) :		\
+	             _mm_storeu_si128((__m128i *)(p), (v)))
+#define SDL_LOAD_AVX2(aligned, p)					\
+	((aligned) ? _mm256_load_si256((const __m256i *)(p)) :	\
+	             _mm256_loadu_si256((const __m256i *)(p)))
+#define SDL_STORE_AVX2(aligned, p, v)					\
+	((aligned) ? _mm256_store_si256((__m256i *)(p), (v)) :	\
+	             _mm256_storeu_si256((__m256i *)(p), (v)))
 
 /*
  * Useful macros for blitting routines
@@ -84,6 +203,11 @@ extern SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int complex);
     ((A)->BitsPerPixel == (B)->BitsPerPixel				\
      && ((A)->Rmask == (B)->Rmask) && ((A)->Amask == (B)->Amask))
 
+/* Index of an RGB triple in the inverse palette table of an N to 8-bit
+   blit, see MapNto1() in SDL_pixels.c */
+#define RGB_INDEX555(r, g, b)						\
+	((((r)&0xF8)<<7)|(((g)&0xF8)<<2)|((b)>>3))
+
 /* Load pixel of the specified format from a buffer and get its R-G-B values */
 /* FIXME: rescale values to 0..255 here? */
 #define RGB_FROM_PIXEL(Pixel, fmt, r, g, b)				\
@@ -440,6 +440,15 @@ static SDL_loblit colorkey_blit[] = {
     NULL, BlitBto1Key, BlitBto2Key, BlitBto3Key, BlitBto4Key
 };
 
+const SDL_BlitterName SDL_BlitterNames0[] = {
+	SDL_BLITTER_NAME(BlitBto1), SDL_BLITTER_NAME(BlitBto2),
+	SDL_BLITTER_NAME(BlitBto3), SDL_BLITTER_NAME(BlitBto4),
+	SDL_BLITTER_NAME(BlitBto1Key), SDL_BLITTER_NAME(BlitBto2Key),
+	SDL_BLITTER_NAME(BlitBto3Key), SDL_BLITTER_NAME(BlitBto4Key),
+	SDL_BLITTER_NAME(BlitBtoNAlpha), SDL_BLITTER_NAME(BlitBtoNAlphaKey),
+	{ NULL, NULL }
+};
+
 SDL_loblit SDL_CalculateBlit0(SDL_Surface *surface, int blit_index)
 {
 	int which;
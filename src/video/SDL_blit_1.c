@@ -25,6 +25,11 @@
 #include "SDL_blit.h"
 #include "SDL_sysvideo.h"
 #include "SDL_endian.h"
+#include "SDL_cpuinfo.h"
+
+#if SDL_ARM_NEON_BLITTERS
+#include <arm_neon.h>
+#endif
 
 /* Functions to blit from 8-bit surfaces to other surfaces */
 
@@ -74,6 +79,166 @@ static void Blit1to1(SDL_BlitInfo *info)
 #define HI	0
 #define LO	1
 #endif
+
+/*
+ * 16-bit destinations with a pair table (see SDL_MapSurface()) are
+ * expanded two pixels per lookup.  With NEON, runs of 8 pixels that only
+ * use the first 16 colors are looked up in registers instead of memory,
+ * for palettes that have at least 16 colors in the translation table.
+ */
+#if SDL_ARM_NEON_BLITTERS
+#define CAN_EXPAND16(info) \
+	((info)->src->palette && (info)->src->palette->ncolors >= 16)
+
+typedef struct {
+	uint8x8x2_t plane[4];	/* Byte planes of the first 16 colors */
+	uint8x8_t limit;
+} SDL_Expand16;
+
+static void SetupExpand16(SDL_Expand16 *ex, const Uint8 *map, int bpp)
+{
+	Uint8 bytes[4][16];
+	int i, j;
+
+	for ( i = 0; i < 16; ++i ) {
+		for ( j = 0; j < bpp; ++j ) {
+			bytes[j][i] = map[i*bpp+j];
+		}
+	}
+	for ( j = 0; j < bpp; ++j ) {
+		ex->plane[j].val[0] = vld1_u8(bytes[j]);
+		ex->plane[j].val[1] = vld1_u8(bytes[j]+8);
+	}
+	ex->limit = vdup_n_u8(15);
+}
+
+/* Expand 8 pixels if they are all below 16, returns 0 if they're not */
+static __inline__ int Expand16to2(const SDL_Expand16 *ex,
+                                  const Uint8 *src, Uint8 *dst)
+{
+	uint8x8_t idx = vld1_u8(src);
+	uint8x8x2_t out;
+
+	if ( vget_lane_u64(vreinterpret_u64_u8(vcgt_u8(idx, ex->limit)), 0) ) {
+		return 0;
+	}
+	out.val[0] = vtbl2_u8(ex->plane[0], idx);
+	out.val[1] = vtbl2_u8(ex->plane[1], idx);
+	vst2_u8(dst, out);
+	return 1;
+}
+
+static __inline__ int Expand16to4(const SDL_Expand16 *ex,
+                                  const Uint8 *src, Uint8 *dst)
+{
+	uint8x8_t idx = vld1_u8(src);
+	uint8x8x4_t out;
+
+	if ( vget_lane_u64(vreinterpret_u64_u8(vcgt_u8(idx, ex->limit)), 0) ) {
+		return 0;
+	}
+	out.val[0] = vtbl2_u8(ex->plane[0], idx);
+	out.val[1] = vtbl2_u8(ex->plane[1], idx);
+	out.val[2] = vtbl2_u8(ex->plane[2], idx);
+	out.val[3] = vtbl2_u8(ex->plane[3], idx);
+	vst4_u8(dst, out);
+	return 1;
+}
+#endif /* SDL_ARM_NEON_BLITTERS */
+
+static void Blit1to2Expand(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint16 *dst = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip/2;
+	Uint16 *map = (Uint16 *)info->table;
+	Uint32 *pairs = (Uint32 *)info->pair_table;
+	int c;
+#if SDL_ARM_NEON_BLITTERS
+	SDL_Expand16 ex;
+	int neon = SDL_HasNEON() && CAN_EXPAND16(info);
+
+	if ( neon ) {
+		SetupExpand16(&ex, info->table, 2);
+	}
+#endif
+
+	while ( height-- ) {
+		c = width;
+		/* Align the destination for the 32-bit pair stores */
+		if ( ((uintptr_t)dst & 3) && c ) {
+			*dst++ = map[*src++];
+			--c;
+		}
+#if SDL_ARM_NEON_BLITTERS
+		if ( neon ) {
+			for ( ; c >= 8; c -= 8, src += 8, dst += 8 ) {
+				int i;
+				if ( Expand16to2(&ex, src, (Uint8 *)dst) ) {
+					continue;
+				}
+				if ( pairs ) {
+					for ( i = 0; i < 8; i += 2 ) {
+						*(Uint32 *)&dst[i] =
+						    pairs[(src[i]<<8)|src[i+1]];
+					}
+				} else {
+					for ( i = 0; i < 8; ++i ) {
+						dst[i] = map[src[i]];
+					}
+				}
+			}
+		}
+#endif
+		if ( pairs ) {
+			for ( ; c >= 2; c -= 2 ) {
+				*(Uint32 *)dst = pairs[(src[0]<<8)|src[1]];
+				src += 2;
+				dst += 2;
+			}
+		}
+		while ( c-- ) {
+			*dst++ = map[*src++];
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+
+#if SDL_ARM_NEON_BLITTERS
+static void Blit1to4NEON(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip/4;
+	Uint32 *map = (Uint32 *)info->table;
+	SDL_Expand16 ex;
+	int c, i;
+
+	SetupExpand16(&ex, info->table, 4);
+	while ( height-- ) {
+		for ( c = width; c >= 8; c -= 8, src += 8, dst += 8 ) {
+			if ( !Expand16to4(&ex, src, (Uint8 *)dst) ) {
+				for ( i = 0; i < 8; ++i ) {
+					dst[i] = map[src[i]];
+				}
+			}
+		}
+		while ( c-- ) {
+			*dst++ = map[*src++];
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+#endif /* SDL_ARM_NEON_BLITTERS */
+
 static void Blit1to2(SDL_BlitInfo *info)
 {
 #ifndef USE_DUFFS_LOOP
@@ -84,6 +249,15 @@ static void Blit1to2(SDL_BlitInfo *info)
 	Uint16 *map;
 	int srcskip, dstskip;
 
+	if ( info->pair_table
+#if SDL_ARM_NEON_BLITTERS
+	     || (SDL_HasNEON() && CAN_EXPAND16(info))
+#endif
+	   ) {
+		Blit1to2Expand(info);
+		return;
+	}
+
 	/* Set up some basic variables */
 	width = info->d_width;
 	height = info->d_height;
@@ -238,6 +412,13 @@ static void Blit1to4(SDL_BlitInfo *info)
 	Uint32 *map, *dst;
 	int srcskip, dstskip;
 
+#if SDL_ARM_NEON_BLITTERS
+	if ( SDL_HasNEON() && CAN_EXPAND16(info) ) {
+		Blit1to4NEON(info);
+		return;
+	}
+#endif
+
 	/* Set up some basic variables */
 	width = info->d_width;
 	height = info->d_height;
@@ -324,11 +505,49 @@ static void Blit1to2Key(SDL_BlitInfo *info)
 	Uint16 *dstp = (Uint16 *)info->d_pixels;
 	int dstskip = info->d_skip;
 	Uint16 *palmap = (Uint16 *)info->table;
+	Uint32 *pairs = (Uint32 *)info->pair_table;
 	Uint32 ckey = info->src->colorkey;
 
 	/* Set up some basic variables */
 	dstskip /= 2;
 
+	if ( pairs ) {
+		/* Look up two pixels at once where neither is transparent */
+		while ( height-- ) {
+			int c = width;
+			if ( ((uintptr_t)dstp & 3) && c ) {
+				if ( *src != ckey ) {
+					*dstp = palmap[*src];
+				}
+				src++;
+				dstp++;
+				--c;
+			}
+			for ( ; c >= 2; c -= 2 ) {
+				if ( src[0] != ckey && src[1] != ckey ) {
+					*(Uint32 *)dstp =
+					    pairs[(src[0]<<8)|src[1]];
+				} else if ( src[0] != ckey ) {
+					dstp[0] = palmap[src[0]];
+				} else if ( src[1] != ckey ) {
+					dstp[1] = palmap[src[1]];
+				}
+				src += 2;
+				dstp += 2;
+			}
+			if ( c ) {
+				if ( *src != ckey ) {
+					*dstp = palmap[*src];
+				}
+				src++;
+				dstp++;
+			}
+			src += srcskip;
+			dstp += dstskip;
+		}
+		return;
+	}
+
 	while ( height-- ) {
 		DUFFS_LOOP(
 		{
@@ -491,6 +710,15 @@ static SDL_loblit one_blitkey[] = {
         NULL, Blit1to1Key, Blit1to2Key, Blit1to3Key, Blit1to4Key
 };
 
+const SDL_BlitterName SDL_BlitterNames1[] = {
+	SDL_BLITTER_NAME(Blit1to1), SDL_BLITTER_NAME(Blit1to2),
+	SDL_BLITTER_NAME(Blit1to3), SDL_BLITTER_NAME(Blit1to4),
+	SDL_BLITTER_NAME(Blit1to1Key), SDL_BLITTER_NAME(Blit1to2Key),
+	SDL_BLITTER_NAME(Blit1to3Key), SDL_BLITTER_NAME(Blit1to4Key),
+	SDL_BLITTER_NAME(Blit1toNAlpha), SDL_BLITTER_NAME(Blit1toNAlphaKey),
+	{ NULL, NULL }
+};
+
 SDL_loblit SDL_CalculateBlit1(SDL_Surface *surface, int blit_index)
 {
 	int which;
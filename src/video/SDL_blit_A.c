@@ -59,6 +59,15 @@
 #include <mmintrin.h>
 #include <mm3dnow.h>
 #endif
+#if SDL_SSE2_BLITTERS
+#include <emmintrin.h>
+#endif
+#if SDL_AVX2_BLITTERS
+#include <immintrin.h>
+#endif
+#if SDL_ARM_NEON_BLITTERS
+#include <arm_neon.h>
+#endif
 
 /* Functions to perform alpha blended blitting */
 
@@ -102,9 +111,7 @@ static void BlitNto1SurfaceAlpha(SDL_BlitInfo *info)
 			  ((dG>>5)<<(2))|
 			  ((dB>>6)<<(0));
 		} else {
-		    *dst = palmap[((dR>>5)<<(3+2))|
-				  ((dG>>5)<<(2))  |
-				  ((dB>>6)<<(0))];
+		    *dst = palmap[RGB_INDEX555(dR, dG, dB)];
 		}
 		dst++;
 		src += srcbpp;
@@ -155,9 +162,7 @@ static void BlitNto1PixelAlpha(SDL_BlitInfo *info)
 			  ((dG>>5)<<(2))|
 			  ((dB>>6)<<(0));
 		} else {
-		    *dst = palmap[((dR>>5)<<(3+2))|
-				  ((dG>>5)<<(2))  |
-				  ((dB>>6)<<(0))  ];
+		    *dst = palmap[RGB_INDEX555(dR, dG, dB)];
 		}
 		dst++;
 		src += srcbpp;
@@ -210,9 +215,7 @@ static void BlitNto1SurfaceAlphaKey(SDL_BlitInfo *info)
 			      ((dG>>5)<<(2)) |
 			      ((dB>>6)<<(0));
 		    } else {
-			*dst = palmap[((dR>>5)<<(3+2))|
-				      ((dG>>5)<<(2))  |
-				      ((dB>>6)<<(0))  ];
+			*dst = palmap[RGB_INDEX555(dR, dG, dB)];
 		    }
 		}
 		dst++;
@@ -2719,8 +2722,566 @@ static void BlitNtoNPixelAlpha(SDL_BlitInfo *info)
 	}
 }
 
+#if SDL_SSE2_BLITTERS
+/*
+ * SSE2 versions of the RGB888 and 16-bit blenders above.  Each channel
+ * is blended as (s * alpha + d * (256 - alpha)) >> 8 (or the 5-bit alpha
+ * equivalent for 16-bit), which gives the same results as the scalar
+ * code, in 16-bit lanes.  Leftover pixels go through the scalar code.
+ * The loops take an 'aligned' argument, see SDL_BlitIsAligned().
+ */
+
+/* blend the bytes of s into d, alpha holds 16-bit alpha per channel */
+#define BLEND_8888_SSE2(s, d, alpha_lo, alpha_hi, zero)			\
+	_mm_packus_epi16(						\
+		_mm_srli_epi16(_mm_add_epi16(				\
+			_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), alpha_lo), \
+			_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero),	\
+				_mm_sub_epi16(_mm_set1_epi16(256), alpha_lo))), 8), \
+		_mm_srli_epi16(_mm_add_epi16(				\
+			_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), alpha_hi), \
+			_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero),	\
+				_mm_sub_epi16(_mm_set1_epi16(256), alpha_hi))), 8))
 
-SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
+/* fast RGB888->(A)RGB888 blending with surface alpha */
+static __inline__ void BlendRGBtoRGBSurfaceAlphaSSE2(SDL_BlitInfo *info,
+                                                     int aligned)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~3;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = (info->s_skip >> 2) + info->d_width - vwidth;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = (info->d_skip >> 2) + info->d_width - vwidth;
+	__m128i zero = _mm_setzero_si128();
+	__m128i alpha = _mm_set1_epi16(info->src->alpha);
+	__m128i amask = _mm_set1_epi32(0xff000000);
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 4 ) {
+				__m128i s = SDL_LOAD_SSE2(aligned, srcp);
+				__m128i d = SDL_LOAD_SSE2(aligned, dstp);
+				d = BLEND_8888_SSE2(s, d, alpha, alpha, zero);
+				SDL_STORE_SSE2(aligned, dstp, _mm_or_si128(d, amask));
+				srcp += 4;
+				dstp += 4;
+			}
+			srcp += srcskip;
+			dstp += dstskip;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, BlitRGBtoRGBSurfaceAlpha);
+}
+static void BlitRGBtoRGBSurfaceAlphaSSE2(SDL_BlitInfo *info)
+{
+	if ( SDL_BlitIsAligned(info, 16) ) {
+		BlendRGBtoRGBSurfaceAlphaSSE2(info, 1);
+	} else {
+		BlendRGBtoRGBSurfaceAlphaSSE2(info, 0);
+	}
+}
+
+/* fast ARGB888->(A)RGB888 blending with pixel alpha */
+static __inline__ void BlendRGBtoRGBPixelAlphaSSE2(SDL_BlitInfo *info,
+                                                   int aligned)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~3;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = (info->s_skip >> 2) + info->d_width - vwidth;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = (info->d_skip >> 2) + info->d_width - vwidth;
+	__m128i zero = _mm_setzero_si128();
+	__m128i opaque = _mm_set1_epi32(SDL_ALPHA_OPAQUE);
+	__m128i amask = _mm_set1_epi32(0xff000000);
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 4 ) {
+				__m128i s = SDL_LOAD_SSE2(aligned, srcp);
+				__m128i d = SDL_LOAD_SSE2(aligned, dstp);
+				__m128i a = _mm_srli_epi32(s, 24);
+				__m128i a16 = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+				__m128i blend = BLEND_8888_SSE2(s, d,
+					_mm_unpacklo_epi32(a16, a16),
+					_mm_unpackhi_epi32(a16, a16), zero);
+				/* opaque pixels are copied, as in the C version */
+				a = _mm_cmpeq_epi32(a, opaque);
+				blend = _mm_or_si128(_mm_and_si128(a, s),
+				                     _mm_andnot_si128(a, blend));
+				/* and the destination alpha is kept */
+				blend = _mm_or_si128(_mm_andnot_si128(amask, blend),
+				                     _mm_and_si128(amask, d));
+				SDL_STORE_SSE2(aligned, dstp, blend);
+				srcp += 4;
+				dstp += 4;
+			}
+			srcp += srcskip;
+			dstp += dstskip;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, BlitRGBtoRGBPixelAlpha);
+}
+static void BlitRGBtoRGBPixelAlphaSSE2(SDL_BlitInfo *info)
+{
+	if ( SDL_BlitIsAligned(info, 16) ) {
+		BlendRGBtoRGBPixelAlphaSSE2(info, 1);
+	} else {
+		BlendRGBtoRGBPixelAlphaSSE2(info, 0);
+	}
+}
+
+/* RGB565 or RGB555 blending with surface alpha, 8 pixels at a time */
+static __inline__ void Blend16to16SurfaceAlphaSSE2(SDL_BlitInfo *info,
+                                   int gbits, SDL_loblit scalar, int aligned)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~7;
+	Uint16 *srcp = (Uint16 *)info->s_pixels;
+	int srcskip = (info->s_skip >> 1) + info->d_width - vwidth;
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = (info->d_skip >> 1) + info->d_width - vwidth;
+	unsigned alpha = info->src->alpha >> 3;	/* downscale alpha to 5 bits */
+	__m128i sa = _mm_set1_epi16(alpha);
+	__m128i da = _mm_set1_epi16(32 - alpha);
+	__m128i rmask = _mm_set1_epi16(0x1f << (5 + gbits));
+	__m128i gmask = _mm_set1_epi16(((1 << gbits) - 1) << 5);
+	__m128i bmask = _mm_set1_epi16(0x1f);
+	__m128i rshift = _mm_cvtsi32_si128(5 + gbits);
+
+#define BLEND_16_SSE2(s, d) \
+	_mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(s, sa), \
+	                             _mm_mullo_epi16(d, da)), 5)
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 8 ) {
+				__m128i s = SDL_LOAD_SSE2(aligned, srcp);
+				__m128i d = SDL_LOAD_SSE2(aligned, dstp);
+				__m128i r, g, b;
+				r = BLEND_16_SSE2(
+					_mm_srl_epi16(_mm_and_si128(s, rmask), rshift),
+					_mm_srl_epi16(_mm_and_si128(d, rmask), rshift));
+				g = BLEND_16_SSE2(
+					_mm_srli_epi16(_mm_and_si128(s, gmask), 5),
+					_mm_srli_epi16(_mm_and_si128(d, gmask), 5));
+				b = BLEND_16_SSE2(_mm_and_si128(s, bmask),
+				                  _mm_and_si128(d, bmask));
+				d = _mm_or_si128(_mm_or_si128(
+					_mm_sll_epi16(r, rshift),
+					_mm_slli_epi16(g, 5)), b);
+				SDL_STORE_SSE2(aligned, dstp, d);
+				srcp += 8;
+				dstp += 8;
+			}
+			srcp += srcskip;
+			dstp += dstskip;
+		}
+	}
+#undef BLEND_16_SSE2
+	SDL_BlitRemainder(info, vwidth, scalar);
+}
+static void Blit16to16SurfaceAlphaSSE2(SDL_BlitInfo *info, int gbits,
+                                       SDL_loblit scalar)
+{
+	if ( SDL_BlitIsAligned(info, 16) ) {
+		Blend16to16SurfaceAlphaSSE2(info, gbits, scalar, 1);
+	} else {
+		Blend16to16SurfaceAlphaSSE2(info, gbits, scalar, 0);
+	}
+}
+
+static void Blit565to565SurfaceAlphaSSE2(SDL_BlitInfo *info)
+{
+	Blit16to16SurfaceAlphaSSE2(info, 6, Blit565to565SurfaceAlpha);
+}
+
+static void Blit555to555SurfaceAlphaSSE2(SDL_BlitInfo *info)
+{
+	Blit16to16SurfaceAlphaSSE2(info, 5, Blit555to555SurfaceAlpha);
+}
+#endif /* SDL_SSE2_BLITTERS */
+
+#if SDL_AVX2_BLITTERS
+/* AVX2 versions of the RGB888 blenders, 8 pixels at a time, with an
+   'aligned' argument like the SSE2 ones */
+
+#define BLEND_8888_AVX2(s, d, alpha_lo, alpha_hi, zero)			\
+	_mm256_packus_epi16(						\
+		_mm256_srli_epi16(_mm256_add_epi16(			\
+			_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), alpha_lo), \
+			_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), \
+				_mm256_sub_epi16(_mm256_set1_epi16(256), alpha_lo))), 8), \
+		_mm256_srli_epi16(_mm256_add_epi16(			\
+			_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), alpha_hi), \
+			_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), \
+				_mm256_sub_epi16(_mm256_set1_epi16(256), alpha_hi))), 8))
+
+static SDL_TARGET_AVX2 __inline__ void BlendRGBtoRGBSurfaceAlphaAVX2(
+                                           SDL_BlitInfo *info, int aligned)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~7;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = (info->s_skip >> 2) + info->d_width - vwidth;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = (info->d_skip >> 2) + info->d_width - vwidth;
+	__m256i zero = _mm256_setzero_si256();
+	__m256i alpha = _mm256_set1_epi16(info->src->alpha);
+	__m256i amask = _mm256_set1_epi32(0xff000000);
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 8 ) {
+				__m256i s = SDL_LOAD_AVX2(aligned, srcp);
+				__m256i d = SDL_LOAD_AVX2(aligned, dstp);
+				d = BLEND_8888_AVX2(s, d, alpha, alpha, zero);
+				SDL_STORE_AVX2(aligned, dstp,
+				               _mm256_or_si256(d, amask));
+				srcp += 8;
+				dstp += 8;
+			}
+			srcp += srcskip;
+			dstp += dstskip;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, BlitRGBtoRGBSurfaceAlphaSSE2);
+}
+static SDL_TARGET_AVX2 void BlitRGBtoRGBSurfaceAlphaAVX2(SDL_BlitInfo *info)
+{
+	if ( SDL_BlitIsAligned(info, 32) ) {
+		BlendRGBtoRGBSurfaceAlphaAVX2(info, 1);
+	} else {
+		BlendRGBtoRGBSurfaceAlphaAVX2(info, 0);
+	}
+}
+
+static SDL_TARGET_AVX2 __inline__ void BlendRGBtoRGBPixelAlphaAVX2(
+                                           SDL_BlitInfo *info, int aligned)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~7;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = (info->s_skip >> 2) + info->d_width - vwidth;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = (info->d_skip >> 2) + info->d_width - vwidth;
+	__m256i zero = _mm256_setzero_si256();
+	__m256i opaque = _mm256_set1_epi32(SDL_ALPHA_OPAQUE);
+	__m256i amask = _mm256_set1_epi32(0xff000000);
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 8 ) {
+				__m256i s = SDL_LOAD_AVX2(aligned, srcp);
+				__m256i d = SDL_LOAD_AVX2(aligned, dstp);
+				__m256i a = _mm256_srli_epi32(s, 24);
+				__m256i a16 = _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+				__m256i blend = BLEND_8888_AVX2(s, d,
+					_mm256_unpacklo_epi32(a16, a16),
+					_mm256_unpackhi_epi32(a16, a16), zero);
+				a = _mm256_cmpeq_epi32(a, opaque);
+				blend = _mm256_blendv_epi8(blend, s, a);
+				blend = _mm256_blendv_epi8(blend, d, amask);
+				SDL_STORE_AVX2(aligned, dstp, blend);
+				srcp += 8;
+				dstp += 8;
+			}
+			srcp += srcskip;
+			dstp += dstskip;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, BlitRGBtoRGBPixelAlphaSSE2);
+}
+static SDL_TARGET_AVX2 void BlitRGBtoRGBPixelAlphaAVX2(SDL_BlitInfo *info)
+{
+	if ( SDL_BlitIsAligned(info, 32) ) {
+		BlendRGBtoRGBPixelAlphaAVX2(info, 1);
+	} else {
+		BlendRGBtoRGBPixelAlphaAVX2(info, 0);
+	}
+}
+#endif /* SDL_AVX2_BLITTERS */
+
+#if SDL_ARM_NEON_BLITTERS
+/*
+ * NEON versions of the blenders above, eight pixels at a time.  They are
+ * written for little endian byte order, where the alpha of an ARGB8888
+ * pixel is byte 3.  Each channel is blended as
+ * (s * alpha + d * (256 - alpha)) >> 8 (or the 5-bit alpha equivalent
+ * for 16-bit), matching the scalar code.  Leftover pixels go through the
+ * scalar code.
+ */
+
+/* (s * alpha + d * (256 - alpha)) >> 8 in 8-bit lanes, inv is 255-alpha */
+#define BLEND_8888_NEON(s, d, alpha, inv) \
+	vshrn_n_u16(vaddw_u8(vmlal_u8(vmull_u8(s, alpha), d, inv), d), 8)
+
+/* fast RGB888->(A)RGB888 blending with surface alpha */
+static void BlitRGBtoRGBSurfaceAlphaNEON(SDL_BlitInfo *info)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~7;
+	Uint8 *srcp = info->s_pixels;
+	int srcskip = info->s_skip + (info->d_width - vwidth) * 4;
+	Uint8 *dstp = info->d_pixels;
+	int dstskip = info->d_skip + (info->d_width - vwidth) * 4;
+	uint8x8_t alpha = vdup_n_u8(info->src->alpha);
+	uint8x8_t inv = vmvn_u8(alpha);
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 8 ) {
+				uint8x8x4_t s = vld4_u8(srcp);
+				uint8x8x4_t d = vld4_u8(dstp);
+				d.val[0] = BLEND_8888_NEON(s.val[0], d.val[0], alpha, inv);
+				d.val[1] = BLEND_8888_NEON(s.val[1], d.val[1], alpha, inv);
+				d.val[2] = BLEND_8888_NEON(s.val[2], d.val[2], alpha, inv);
+				d.val[3] = vdup_n_u8(0xff);
+				vst4_u8(dstp, d);
+				srcp += 32;
+				dstp += 32;
+			}
+			srcp += srcskip;
+			dstp += dstskip;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, BlitRGBtoRGBSurfaceAlpha);
+}
+
+/* fast ARGB888->(A)RGB888 blending with pixel alpha */
+static void BlitRGBtoRGBPixelAlphaNEON(SDL_BlitInfo *info)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~7;
+	Uint8 *srcp = info->s_pixels;
+	int srcskip = info->s_skip + (info->d_width - vwidth) * 4;
+	Uint8 *dstp = info->d_pixels;
+	int dstskip = info->d_skip + (info->d_width - vwidth) * 4;
+	uint8x8_t opaque = vdup_n_u8(SDL_ALPHA_OPAQUE);
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 8 ) {
+				uint8x8x4_t s = vld4_u8(srcp);
+				uint8x8x4_t d = vld4_u8(dstp);
+				uint8x8_t alpha = s.val[3];
+				uint8x8_t inv = vmvn_u8(alpha);
+				/* opaque pixels are copied, as in the C version */
+				uint8x8_t copy = vceq_u8(alpha, opaque);
+				int i;
+				for ( i = 0; i < 3; ++i ) {
+					d.val[i] = vbsl_u8(copy, s.val[i],
+						BLEND_8888_NEON(s.val[i], d.val[i], alpha, inv));
+				}
+				vst4_u8(dstp, d);
+				srcp += 32;
+				dstp += 32;
+			}
+			srcp += srcskip;
+			dstp += dstskip;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, BlitRGBtoRGBPixelAlpha);
+}
+
+/* (s * alpha + d * (32 - alpha)) >> 5 in 16-bit lanes */
+#define BLEND_16_NEON(s, d, alpha, inv) \
+	vshrq_n_u16(vmlaq_u16(vmulq_u16(s, alpha), d, inv), 5)
+
+/* RGB565 or RGB555 blending with surface alpha */
+static void Blit16to16SurfaceAlphaNEON(SDL_BlitInfo *info, int is555,
+                                       SDL_loblit scalar)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~7;
+	Uint16 *srcp = (Uint16 *)info->s_pixels;
+	int srcskip = (info->s_skip >> 1) + info->d_width - vwidth;
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = (info->d_skip >> 1) + info->d_width - vwidth;
+	unsigned alpha = info->src->alpha >> 3;	/* downscale alpha to 5 bits */
+	uint16x8_t sa = vdupq_n_u16(alpha);
+	uint16x8_t da = vdupq_n_u16(32 - alpha);
+	uint16x8_t five = vdupq_n_u16(0x1f);
+	uint16x8_t gmask = vdupq_n_u16(is555 ? 0x1f : 0x3f);
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 8 ) {
+				uint16x8_t s = vld1q_u16(srcp);
+				uint16x8_t d = vld1q_u16(dstp);
+				uint16x8_t r, g, b;
+				if ( is555 ) {
+					r = BLEND_16_NEON(vandq_u16(vshrq_n_u16(s, 10), five),
+					                  vandq_u16(vshrq_n_u16(d, 10), five),
+					                  sa, da);
+				} else {
+					r = BLEND_16_NEON(vshrq_n_u16(s, 11),
+					                  vshrq_n_u16(d, 11), sa, da);
+				}
+				g = BLEND_16_NEON(vandq_u16(vshrq_n_u16(s, 5), gmask),
+				                  vandq_u16(vshrq_n_u16(d, 5), gmask),
+				                  sa, da);
+				b = BLEND_16_NEON(vandq_u16(s, five),
+				                  vandq_u16(d, five), sa, da);
+				if ( is555 ) {
+					d = vorrq_u16(vshlq_n_u16(r, 10), vshlq_n_u16(g, 5));
+				} else {
+					d = vorrq_u16(vshlq_n_u16(r, 11), vshlq_n_u16(g, 5));
+				}
+				vst1q_u16(dstp, vorrq_u16(d, b));
+				srcp += 8;
+				dstp += 8;
+			}
+			srcp += srcskip;
+			dstp += dstskip;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, scalar);
+}
+
+static void Blit565to565SurfaceAlphaNEON(SDL_BlitInfo *info)
+{
+	Blit16to16SurfaceAlphaNEON(info, 0, Blit565to565SurfaceAlpha);
+}
+
+static void Blit555to555SurfaceAlphaNEON(SDL_BlitInfo *info)
+{
+	Blit16to16SurfaceAlphaNEON(info, 1, Blit555to555SurfaceAlpha);
+}
+
+/* ARGB8888 (or ABGR8888) -> RGB565 or RGB555 blending with pixel alpha.
+   Byte 2 of the source goes to the top destination channel, byte 0 to
+   the bottom one, which covers both orders the C versions accept. */
+static void BlitARGBto16PixelAlphaNEON(SDL_BlitInfo *info, int is555,
+                                       SDL_loblit scalar)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~7;
+	Uint8 *srcp = info->s_pixels;
+	int srcskip = info->s_skip + (info->d_width - vwidth) * 4;
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = (info->d_skip >> 1) + info->d_width - vwidth;
+	uint16x8_t five = vdupq_n_u16(0x1f);
+	uint16x8_t gmask = vdupq_n_u16(is555 ? 0x1f : 0x3f);
+	uint16x8_t thirtytwo = vdupq_n_u16(32);
+	uint16x8_t zero = vdupq_n_u16(0);
+	uint16x8_t opaque = vdupq_n_u16(SDL_ALPHA_OPAQUE >> 3);
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 8 ) {
+				uint8x8x4_t s = vld4_u8(srcp);
+				uint16x8_t d = vld1q_u16(dstp);
+				/* downscale alpha to 5 bits */
+				uint16x8_t alpha = vmovl_u8(vshr_n_u8(s.val[3], 3));
+				uint16x8_t inv = vsubq_u16(thirtytwo, alpha);
+				uint16x8_t sr = vmovl_u8(vshr_n_u8(s.val[2], 3));
+				uint16x8_t sg = vmovl_u8(is555 ? vshr_n_u8(s.val[1], 3)
+				                               : vshr_n_u8(s.val[1], 2));
+				uint16x8_t sb = vmovl_u8(vshr_n_u8(s.val[0], 3));
+				uint16x8_t r, g, b, out, keep;
+				if ( is555 ) {
+					r = vandq_u16(vshrq_n_u16(d, 10), five);
+				} else {
+					r = vshrq_n_u16(d, 11);
+				}
+				g = vandq_u16(vshrq_n_u16(d, 5), gmask);
+				b = vandq_u16(d, five);
+				/* opaque pixels are copied, as in the C version */
+				keep = vceqq_u16(alpha, opaque);
+				r = vbslq_u16(keep, sr, BLEND_16_NEON(sr, r, alpha, inv));
+				g = vbslq_u16(keep, sg, BLEND_16_NEON(sg, g, alpha, inv));
+				b = vbslq_u16(keep, sb, BLEND_16_NEON(sb, b, alpha, inv));
+				if ( is555 ) {
+					out = vorrq_u16(vshlq_n_u16(r, 10), vshlq_n_u16(g, 5));
+				} else {
+					out = vorrq_u16(vshlq_n_u16(r, 11), vshlq_n_u16(g, 5));
+				}
+				out = vorrq_u16(out, b);
+				/* and transparent ones leave the destination alone */
+				keep = vceqq_u16(alpha, zero);
+				vst1q_u16(dstp, vbslq_u16(keep, d, out));
+				srcp += 32;
+				dstp += 8;
+			}
+			srcp += srcskip;
+			dstp += dstskip;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, scalar);
+}
+
+static void BlitARGBto565PixelAlphaNEON(SDL_BlitInfo *info)
+{
+	BlitARGBto16PixelAlphaNEON(info, 0, BlitARGBto565PixelAlpha);
+}
+
+static void BlitARGBto555PixelAlphaNEON(SDL_BlitInfo *info)
+{
+	BlitARGBto16PixelAlphaNEON(info, 1, BlitARGBto555PixelAlpha);
+}
+#endif /* SDL_ARM_NEON_BLITTERS */
+
+const SDL_BlitterName SDL_BlitterNamesA[] = {
+#if MMX_ASMBLIT
+	SDL_BLITTER_NAME(BlitRGBtoRGBSurfaceAlphaMMX),
+	SDL_BLITTER_NAME(BlitRGBtoRGBPixelAlphaMMX),
+	SDL_BLITTER_NAME(BlitRGBtoRGBPixelAlphaMMX3DNOW),
+	SDL_BLITTER_NAME(Blit565to565SurfaceAlphaMMX),
+	SDL_BLITTER_NAME(Blit555to555SurfaceAlphaMMX),
+#endif
+#if SDL_ALTIVEC_BLITTERS
+	SDL_BLITTER_NAME(Blit32to565PixelAlphaAltivec),
+	SDL_BLITTER_NAME(Blit32to32SurfaceAlphaKeyAltivec),
+	SDL_BLITTER_NAME(Blit32to32PixelAlphaAltivec),
+	SDL_BLITTER_NAME(BlitRGBtoRGBPixelAlphaAltivec),
+	SDL_BLITTER_NAME(Blit32to32SurfaceAlphaAltivec),
+	SDL_BLITTER_NAME(BlitRGBtoRGBSurfaceAlphaAltivec),
+#endif
+#if SDL_SSE2_BLITTERS
+	SDL_BLITTER_NAME(BlitRGBtoRGBSurfaceAlphaSSE2),
+	SDL_BLITTER_NAME(BlitRGBtoRGBPixelAlphaSSE2),
+	SDL_BLITTER_NAME(Blit565to565SurfaceAlphaSSE2),
+	SDL_BLITTER_NAME(Blit555to555SurfaceAlphaSSE2),
+#endif
+#if SDL_AVX2_BLITTERS
+	SDL_BLITTER_NAME(BlitRGBtoRGBSurfaceAlphaAVX2),
+	SDL_BLITTER_NAME(BlitRGBtoRGBPixelAlphaAVX2),
+#endif
+#if SDL_ARM_NEON_BLITTERS
+	SDL_BLITTER_NAME(BlitRGBtoRGBSurfaceAlphaNEON),
+	SDL_BLITTER_NAME(BlitRGBtoRGBPixelAlphaNEON),
+	SDL_BLITTER_NAME(Blit565to565SurfaceAlphaNEON),
+	SDL_BLITTER_NAME(Blit555to555SurfaceAlphaNEON),
+	SDL_BLITTER_NAME(BlitARGBto565PixelAlphaNEON),
+	SDL_BLITTER_NAME(BlitARGBto555PixelAlphaNEON),
+#endif
+	SDL_BLITTER_NAME(BlitNto1SurfaceAlpha),
+	SDL_BLITTER_NAME(BlitNto1PixelAlpha),
+	SDL_BLITTER_NAME(BlitNto1SurfaceAlphaKey),
+	SDL_BLITTER_NAME(BlitRGBtoRGBSurfaceAlpha),
+	SDL_BLITTER_NAME(BlitRGBtoRGBPixelAlpha),
+	SDL_BLITTER_NAME(Blit565to565SurfaceAlpha),
+	SDL_BLITTER_NAME(Blit555to555SurfaceAlpha),
+	SDL_BLITTER_NAME(BlitARGBto565PixelAlpha),
+	SDL_BLITTER_NAME(BlitARGBto555PixelAlpha),
+	SDL_BLITTER_NAME(BlitNtoNSurfaceAlpha),
+	SDL_BLITTER_NAME(BlitNtoNSurfaceAlphaKey),
+	SDL_BLITTER_NAME(BlitNtoNPixelAlpha),
+	{ NULL, NULL }
+};
+
+static SDL_loblit CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 {
     SDL_PixelFormat *sf = surface->format;
     SDL_PixelFormat *df = surface->map->dst->format;
@@ -2751,6 +3312,16 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 		if(SDL_HasMMX())
 			return Blit565to565SurfaceAlphaMMX;
 		else
+#endif
+#if SDL_SSE2_BLITTERS
+		if(SDL_HasSSE2())
+			return Blit565to565SurfaceAlphaSSE2;
+		else
+#endif
+#if SDL_ARM_NEON_BLITTERS
+		if(SDL_HasNEON())
+			return Blit565to565SurfaceAlphaNEON;
+		else
 #endif
 			return Blit565to565SurfaceAlpha;
 		    }
@@ -2760,6 +3331,16 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 		if(SDL_HasMMX())
 			return Blit555to555SurfaceAlphaMMX;
 		else
+#endif
+#if SDL_SSE2_BLITTERS
+		if(SDL_HasSSE2())
+			return Blit555to555SurfaceAlphaSSE2;
+		else
+#endif
+#if SDL_ARM_NEON_BLITTERS
+		if(SDL_HasNEON())
+			return Blit555to555SurfaceAlphaNEON;
+		else
 #endif
 			return Blit555to555SurfaceAlpha;
 		    }
@@ -2785,6 +3366,18 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 				if(!(surface->map->dst->flags & SDL_HWSURFACE)
 					&& SDL_HasAltiVec())
 					return BlitRGBtoRGBSurfaceAlphaAltivec;
+#endif
+#if SDL_AVX2_BLITTERS
+				if(SDL_HasAVX2())
+					return BlitRGBtoRGBSurfaceAlphaAVX2;
+#endif
+#if SDL_SSE2_BLITTERS
+				if(SDL_HasSSE2())
+					return BlitRGBtoRGBSurfaceAlphaSSE2;
+#endif
+#if SDL_ARM_NEON_BLITTERS
+				if(SDL_HasNEON())
+					return BlitRGBtoRGBSurfaceAlphaNEON;
 #endif
 				return BlitRGBtoRGBSurfaceAlpha;
 			}
@@ -2820,6 +3413,14 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 	       && sf->Gmask == 0xff00
 	       && ((sf->Rmask == 0xff && df->Rmask == 0x1f)
 		   || (sf->Bmask == 0xff && df->Bmask == 0x1f))) {
+#if SDL_ARM_NEON_BLITTERS
+		if(SDL_HasNEON()) {
+		    if(df->Gmask == 0x7e0)
+			return BlitARGBto565PixelAlphaNEON;
+		    else if(df->Gmask == 0x3e0)
+			return BlitARGBto555PixelAlphaNEON;
+		}
+#endif
 		if(df->Gmask == 0x7e0)
 		    return BlitARGBto565PixelAlpha;
 		else if(df->Gmask == 0x3e0)
@@ -2852,6 +3453,18 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 			if(!(surface->map->dst->flags & SDL_HWSURFACE)
 				&& SDL_HasAltiVec())
 				return BlitRGBtoRGBPixelAlphaAltivec;
+#endif
+#if SDL_AVX2_BLITTERS
+			if(SDL_HasAVX2())
+				return BlitRGBtoRGBPixelAlphaAVX2;
+#endif
+#if SDL_SSE2_BLITTERS
+			if(SDL_HasSSE2())
+				return BlitRGBtoRGBPixelAlphaSSE2;
+#endif
+#if SDL_ARM_NEON_BLITTERS
+			if(SDL_HasNEON())
+				return BlitRGBtoRGBPixelAlphaNEON;
 #endif
 			return BlitRGBtoRGBPixelAlpha;
 		}
@@ -2871,3 +3484,20 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
     }
 }
 
+SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
+{
+    SDL_loblit blit = CalculateAlphaBlit(surface, blit_index);
+    SDL_loblit autoblit = NULL;
+    SDL_PixelFormat *sf = surface->format;
+    SDL_PixelFormat *df = surface->map->dst->format;
+
+    /* Prefer a generated kernel for the format pair to the general ones */
+    if(blit == BlitNtoNSurfaceAlpha)
+	autoblit = SDL_CalculateBlitAuto(sf, df, SDL_BLIT_AUTO_ALPHA);
+    else if(blit == BlitNtoNSurfaceAlphaKey)
+	autoblit = SDL_CalculateBlitAuto(sf, df, SDL_BLIT_AUTO_ALPHAKEY);
+    else if(blit == BlitNtoNPixelAlpha)
+	autoblit = SDL_CalculateBlitAuto(sf, df, SDL_BLIT_AUTO_PIXELALPHA);
+    return autoblit ? autoblit : blit;
+}
+
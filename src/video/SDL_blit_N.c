@@ -810,6 +810,382 @@ static void ConvertAltivec32to32_prefetch(SDL_BlitInfo *info)
     vec_dss(DST_CHAN_DEST);
 }
 
+#if __MWERKS__
+#pragma altivec_model off
+#endif
+#endif /* SDL_ALTIVEC_BLITTERS */
+
+#if SDL_ARM_NEON_BLITTERS
+#include <arm_neon.h>
+
+/* NEON blitters are written for little endian byte order, so byte lane N
+   of a 32-bit pixel holds the channel with shift N*8 */
+#define NEON_LANE(shift)	((shift) >> 3)
+
+/* 32-bit 8888 --> RGB 5-6-5 or RGB 5-5-5, eight pixels at a time.
+   If keyed, pixels matching the source colorkey are left alone: each
+   byte of the pixel is compared and the results select the old value. */
+static __inline__ void Blit32to16NEON(SDL_BlitInfo *info,
+                                      int ri, int gi, int bi, int is555,
+                                      int keyed)
+{
+	int width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint16 *dst = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip / 2;
+	Uint32 rgbmask = ~info->src->Amask;
+	Uint32 ckey = info->src->colorkey & rgbmask;
+	uint8x8_t km[4], kv[4];
+	int i;
+
+	for ( i = 0; i < 4; ++i ) {
+		km[i] = vdup_n_u8((Uint8)(rgbmask >> (i * 8)));
+		kv[i] = vdup_n_u8((Uint8)(ckey >> (i * 8)));
+	}
+
+	while ( height-- ) {
+		width = info->d_width;
+		while ( width >= 8 ) {
+			uint8x8x4_t px = vld4_u8(src);
+			uint16x8_t r = vshll_n_u8(px.val[ri], 8);
+			uint16x8_t g = vshll_n_u8(px.val[gi], 8);
+			uint16x8_t b = vshll_n_u8(px.val[bi], 8);
+			uint16x8_t out;
+			if ( is555 ) {
+				out = vsriq_n_u16(vdupq_n_u16(0), r, 1);
+				out = vsriq_n_u16(out, g, 6);
+			} else {
+				out = vsriq_n_u16(r, g, 5);
+			}
+			out = vsriq_n_u16(out, b, 11);
+			if ( keyed ) {
+				uint8x8_t same = vdup_n_u8(0xFF);
+				uint16x8_t skip;
+				for ( i = 0; i < 4; ++i ) {
+					same = vand_u8(same, vceq_u8(
+						vand_u8(px.val[i], km[i]), kv[i]));
+				}
+				skip = vreinterpretq_u16_s16(
+					vmovl_s8(vreinterpret_s8_u8(same)));
+				out = vbslq_u16(skip, vld1q_u16(dst), out);
+			}
+			vst1q_u16(dst, out);
+			src += 32;
+			dst += 8;
+			width -= 8;
+		}
+		while ( width-- ) {
+			unsigned sR = src[ri], sG = src[gi], sB = src[bi];
+			if ( !keyed || (*(Uint32 *)src & rgbmask) != ckey ) {
+				if ( is555 ) {
+					RGB555_FROM_RGB(*dst, sR, sG, sB);
+				} else {
+					RGB565_FROM_RGB(*dst, sR, sG, sB);
+				}
+			}
+			src += 4;
+			++dst;
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+
+static void Blit_RGB888_RGB565NEON(SDL_BlitInfo *info)
+{
+	Blit32to16NEON(info, 2, 1, 0, 0, 0);
+}
+static void Blit_BGR888_RGB565NEON(SDL_BlitInfo *info)
+{
+	Blit32to16NEON(info, 0, 1, 2, 0, 0);
+}
+static void Blit_RGB888_RGB555NEON(SDL_BlitInfo *info)
+{
+	Blit32to16NEON(info, 2, 1, 0, 1, 0);
+}
+static void Blit_BGR888_RGB555NEON(SDL_BlitInfo *info)
+{
+	Blit32to16NEON(info, 0, 1, 2, 1, 0);
+}
+/* Any 8888 --> RGB 5-6-5 or RGB 5-5-5 with a colorkey */
+static void Blit32to16KeyNEON(SDL_BlitInfo *info)
+{
+	SDL_PixelFormat *srcfmt = info->src;
+
+	Blit32to16NEON(info, NEON_LANE(srcfmt->Rshift),
+	               NEON_LANE(srcfmt->Gshift), NEON_LANE(srcfmt->Bshift),
+	               (info->dst->Gmask == 0x03E0), 1);
+}
+
+/* Same format 16-bit colorkey, eight pixels at a time */
+static void Blit2to2KeyNEON(SDL_BlitInfo *info)
+{
+	int width;
+	int height = info->d_height;
+	Uint16 *src = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip / 2;
+	Uint16 *dst = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip / 2;
+	Uint32 rgbmask = ~info->src->Amask;
+	Uint32 ckey = info->src->colorkey & rgbmask;
+	uint16x8_t vmask = vdupq_n_u16((Uint16)rgbmask);
+	uint16x8_t vkey = vdupq_n_u16((Uint16)ckey);
+
+	while ( height-- ) {
+		width = info->d_width;
+		/* A key wider than the pixel never matches */
+		if ( ckey <= 0xFFFF ) {
+			while ( width >= 8 ) {
+				uint16x8_t s = vld1q_u16(src);
+				uint16x8_t skip = vceqq_u16(vandq_u16(s, vmask), vkey);
+				vst1q_u16(dst, vbslq_u16(skip, vld1q_u16(dst), s));
+				src += 8;
+				dst += 8;
+				width -= 8;
+			}
+		}
+		while ( width-- ) {
+			if ( (*src & rgbmask) != ckey ) {
+				*dst = *src;
+			}
+			++src;
+			++dst;
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+
+/* Same format 8888 colorkey, four pixels at a time.  Bits outside the
+   format masks are cleared, as BlitNtoNKey does. */
+static void Blit4to4KeyNEON(SDL_BlitInfo *info)
+{
+	int width;
+	int height = info->d_height;
+	Uint32 *src = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip / 4;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip / 4;
+	SDL_PixelFormat *srcfmt = info->src;
+	Uint32 rgbmask = ~srcfmt->Amask;
+	Uint32 ckey = srcfmt->colorkey & rgbmask;
+	Uint32 keep = (srcfmt->Rmask | srcfmt->Gmask |
+	               srcfmt->Bmask | srcfmt->Amask);
+	uint32x4_t vmask = vdupq_n_u32(rgbmask);
+	uint32x4_t vkey = vdupq_n_u32(ckey);
+	uint32x4_t vkeep = vdupq_n_u32(keep);
+
+	while ( height-- ) {
+		width = info->d_width;
+		while ( width >= 4 ) {
+			uint32x4_t s = vld1q_u32(src);
+			uint32x4_t skip = vceqq_u32(vandq_u32(s, vmask), vkey);
+			vst1q_u32(dst, vbslq_u32(skip, vld1q_u32(dst),
+			                         vandq_u32(s, vkeep)));
+			src += 4;
+			dst += 4;
+			width -= 4;
+		}
+		while ( width-- ) {
+			if ( (*src & rgbmask) != ckey ) {
+				*dst = *src & keep;
+			}
+			++src;
+			++dst;
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+
+/* RGB 5-6-5 --> 32-bit 888, eight pixels at a time.
+   The low bits of each channel and the unused byte are left clear,
+   as BlitNtoN does, so 0x1F -> 0xF8 */
+static __inline__ void Blit565to32NEON(SDL_BlitInfo *info,
+                                       int ri, int gi, int bi, int ai)
+{
+	int width;
+	int height = info->d_height;
+	Uint16 *src = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip / 2;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip;
+	uint8x8_t mask5 = vdup_n_u8(0xF8);
+	uint8x8_t mask6 = vdup_n_u8(0xFC);
+	uint8x8_t zero = vdup_n_u8(0);
+
+	while ( height-- ) {
+		width = info->d_width;
+		while ( width >= 8 ) {
+			uint16x8_t px = vld1q_u16(src);
+			uint8x8x4_t out;
+			out.val[ri] = vand_u8(vshrn_n_u16(px, 8), mask5);
+			out.val[gi] = vand_u8(vshrn_n_u16(px, 3), mask6);
+			out.val[bi] = vshl_n_u8(vmovn_u16(px), 3);
+			out.val[ai] = zero;
+			vst4_u8(dst, out);
+			src += 8;
+			dst += 32;
+			width -= 8;
+		}
+		while ( width-- ) {
+			unsigned Pixel = *src++;
+			dst[ri] = (Pixel >> 8) & 0xF8;
+			dst[gi] = (Pixel >> 3) & 0xFC;
+			dst[bi] = (Pixel << 3) & 0xF8;
+			dst[ai] = 0;
+			dst += 4;
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+
+static void Blit_RGB565_ARGB8888NEON(SDL_BlitInfo *info)
+{
+	Blit565to32NEON(info, 2, 1, 0, 3);
+}
+static void Blit_RGB565_ABGR8888NEON(SDL_BlitInfo *info)
+{
+	Blit565to32NEON(info, 0, 1, 2, 3);
+}
+static void Blit_RGB565_RGBA8888NEON(SDL_BlitInfo *info)
+{
+	Blit565to32NEON(info, 3, 2, 1, 0);
+}
+static void Blit_RGB565_BGRA8888NEON(SDL_BlitInfo *info)
+{
+	Blit565to32NEON(info, 1, 2, 3, 0);
+}
+
+/* RGB 5-5-5 <--> RGB 5-6-5, eight pixels at a time.
+   The low green bit of 5-6-5 is left clear, as BlitNtoN does. */
+static void Blit_RGB555_RGB565NEON(SDL_BlitInfo *info)
+{
+	int width;
+	int height = info->d_height;
+	Uint16 *src = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip / 2;
+	Uint16 *dst = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip / 2;
+	uint16x8_t vrg = vdupq_n_u16(0xFFC0);
+	uint16x8_t vb = vdupq_n_u16(0x001F);
+
+	while ( height-- ) {
+		width = info->d_width;
+		while ( width >= 8 ) {
+			uint16x8_t px = vld1q_u16(src);
+			uint16x8_t out = vandq_u16(vshlq_n_u16(px, 1), vrg);
+			out = vorrq_u16(out, vandq_u16(px, vb));
+			vst1q_u16(dst, out);
+			src += 8;
+			dst += 8;
+			width -= 8;
+		}
+		while ( width-- ) {
+			unsigned Pixel = *src++;
+			*dst++ = ((Pixel << 1) & 0xFFC0) | (Pixel & 0x001F);
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+
+static void Blit_RGB565_RGB555NEON(SDL_BlitInfo *info)
+{
+	int width;
+	int height = info->d_height;
+	Uint16 *src = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip / 2;
+	Uint16 *dst = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip / 2;
+	uint16x8_t vrg = vdupq_n_u16(0x7FE0);
+	uint16x8_t vb = vdupq_n_u16(0x001F);
+
+	while ( height-- ) {
+		width = info->d_width;
+		while ( width >= 8 ) {
+			uint16x8_t px = vld1q_u16(src);
+			uint16x8_t out = vandq_u16(vshrq_n_u16(px, 1), vrg);
+			out = vorrq_u16(out, vandq_u16(px, vb));
+			vst1q_u16(dst, out);
+			src += 8;
+			dst += 8;
+			width -= 8;
+		}
+		while ( width-- ) {
+			unsigned Pixel = *src++;
+			*dst++ = ((Pixel >> 1) & 0x7FE0) | (Pixel & 0x001F);
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+
+/* Any 8888 --> 8888 channel swizzle, using a byte table lookup.
+   Lookups with an index outside the table produce zero, which leaves
+   room to OR in a constant alpha when the source has none. */
+static void ConvertNEON32to32(SDL_BlitInfo *info)
+{
+	int width;
+	int height = info->d_height;
+	Uint32 *src = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip / 4;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip / 4;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	Uint8 index[8];
+	Uint8 fill[8];
+	uint8x8_t vindex, vfill;
+	int i;
+
+	SDL_memset(index, 0xFF, sizeof(index));
+	SDL_memset(fill, 0, sizeof(fill));
+	for ( i = 0; i < 2; ++i ) {
+		index[i*4+NEON_LANE(dstfmt->Rshift)] = i*4+NEON_LANE(srcfmt->Rshift);
+		index[i*4+NEON_LANE(dstfmt->Gshift)] = i*4+NEON_LANE(srcfmt->Gshift);
+		index[i*4+NEON_LANE(dstfmt->Bshift)] = i*4+NEON_LANE(srcfmt->Bshift);
+		if ( dstfmt->Amask ) {
+			if ( srcfmt->Amask ) {
+				index[i*4+NEON_LANE(dstfmt->Ashift)] =
+					i*4+NEON_LANE(srcfmt->Ashift);
+			} else {
+				fill[i*4+NEON_LANE(dstfmt->Ashift)] = srcfmt->alpha;
+			}
+		}
+	}
+	vindex = vld1_u8(index);
+	vfill = vld1_u8(fill);
+
+	while ( height-- ) {
+		width = info->d_width;
+		while ( width >= 4 ) {
+			uint8x16_t px = vld1q_u8((Uint8 *)src);
+			uint8x8_t lo = vtbl1_u8(vget_low_u8(px), vindex);
+			uint8x8_t hi = vtbl1_u8(vget_high_u8(px), vindex);
+			lo = vorr_u8(lo, vfill);
+			hi = vorr_u8(hi, vfill);
+			vst1q_u8((Uint8 *)dst, vcombine_u8(lo, hi));
+			src += 4;
+			dst += 4;
+			width -= 4;
+		}
+		while ( width-- ) {
+			Uint8 *s = (Uint8 *)src++;
+			Uint8 *d = (Uint8 *)dst++;
+			for ( i = 0; i < 4; ++i ) {
+				d[i] = (index[i] < 4 ? s[index[i]] : 0) | fill[i];
+			}
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+#endif /* SDL_ARM_NEON_BLITTERS */
+
 static Uint32 GetBlitFeatures( void )
 {
     static Uint32 features = 0xffffffff;
@@ -823,23 +1199,24 @@ static Uint32 GetBlitFeatures( void )
             features = ( 0
                 /* Feature 1 is has-MMX */
                 | ((SDL_HasMMX()) ? 1 : 0)
+#if SDL_ALTIVEC_BLITTERS
                 /* Feature 2 is has-AltiVec */
                 | ((SDL_HasAltiVec()) ? 2 : 0)
                 /* Feature 4 is dont-use-prefetch */
                 /* !!!! FIXME: Check for G5 or later, not the cache size! Always prefetch on a G4. */
                 | ((GetL3CacheSize() == 0) ? 4 : 0)
+#endif
+                /* Feature 8 is has-NEON */
+                | ((SDL_HasNEON()) ? 8 : 0)
+                /* Feature 16 is has-SSE2 */
+                | ((SDL_HasSSE2()) ? 16 : 0)
+                /* Feature 32 is has-AVX2 */
+                | ((SDL_HasAVX2()) ? 32 : 0)
             );
         }
     }
     return features;
 }
-#if __MWERKS__
-#pragma altivec_model off
-#endif
-#else
-/* Feature 1 is has-MMX */
-#define GetBlitFeatures() ((Uint32)(SDL_HasMMX() ? 1 : 0))
-#endif
 
 /* This is now endian dependent */
 #if SDL_BYTEORDER == SDL_LIL_ENDIAN
@@ -869,6 +1246,12 @@ static Uint32 GetBlitFeatures( void )
 	              (((src)&0x0000E000)>>11)| \
 	              (((src)&0x000000C0)>>6)); \
 }
+/* Index of an RGB 8-8-8 pixel in the inverse palette, see RGB_INDEX555 */
+#define RGB888_INDEX555(dst, src) { \
+	dst = (((src)&0x00F80000)>>9)| \
+	      (((src)&0x0000F800)>>6)| \
+	      (((src)&0x000000F8)>>3); \
+}
 static void Blit_RGB888_index8(SDL_BlitInfo *info)
 {
 #ifndef USE_DUFFS_LOOP
@@ -927,37 +1310,37 @@ static void Blit_RGB888_index8(SDL_BlitInfo *info)
 		while ( height-- ) {
 #ifdef USE_DUFFS_LOOP
 			DUFFS_LOOP(
-				RGB888_RGB332(Pixel, *src);
+				RGB888_INDEX555(Pixel, *src);
 				*dst++ = map[Pixel];
 				++src;
 			, width);
 #else
 			for ( c=width/4; c; --c ) {
 				/* Pack RGB into 8bit pixel */
-				RGB888_RGB332(Pixel, *src);
+				RGB888_INDEX555(Pixel, *src);
 				*dst++ = map[Pixel];
 				++src;
-				RGB888_RGB332(Pixel, *src);
+				RGB888_INDEX555(Pixel, *src);
 				*dst++ = map[Pixel];
 				++src;
-				RGB888_RGB332(Pixel, *src);
+				RGB888_INDEX555(Pixel, *src);
 				*dst++ = map[Pixel];
 				++src;
-				RGB888_RGB332(Pixel, *src);
+				RGB888_INDEX555(Pixel, *src);
 				*dst++ = map[Pixel];
 				++src;
 			}
 			switch ( width & 3 ) {
 				case 3:
-					RGB888_RGB332(Pixel, *src);
+					RGB888_INDEX555(Pixel, *src);
 					*dst++ = map[Pixel];
 					++src;
 				case 2:
-					RGB888_RGB332(Pixel, *src);
+					RGB888_INDEX555(Pixel, *src);
 					*dst++ = map[Pixel];
 					++src;
 				case 1:
-					RGB888_RGB332(Pixel, *src);
+					RGB888_INDEX555(Pixel, *src);
 					*dst++ = map[Pixel];
 					++src;
 			}
@@ -1818,12 +2201,12 @@ static void Blit_RGB565_BGRA8888(SDL_BlitInfo *info)
     Blit_RGB565_32(info, RGB565_BGRA8888_LUT);
 }
 
-/* Special optimized blit for RGB 8-8-8 --> RGB 3-3-2 */
-#ifndef RGB888_RGB332
-#define RGB888_RGB332(dst, src) { \
-	dst = (((src)&0x00E00000)>>16)| \
-	      (((src)&0x0000E000)>>11)| \
-	      (((src)&0x000000C0)>>6); \
+/* Special optimized blit for RGB 8-8-8 --> inverse palette */
+#ifndef RGB888_INDEX555
+#define RGB888_INDEX555(dst, src) { \
+	dst = (((src)&0x00F80000)>>9)| \
+	      (((src)&0x0000F800)>>6)| \
+	      (((src)&0x000000F8)>>3); \
 }
 #endif
 static void Blit_RGB888_index8_map(SDL_BlitInfo *info)
@@ -1850,7 +2233,7 @@ static void Blit_RGB888_index8_map(SDL_BlitInfo *info)
 #ifdef USE_DUFFS_LOOP
 	while ( height-- ) {
 		DUFFS_LOOP(
-			RGB888_RGB332(Pixel, *src);
+			RGB888_INDEX555(Pixel, *src);
 			*dst++ = map[Pixel];
 			++src;
 		, width);
@@ -1861,30 +2244,30 @@ static void Blit_RGB888_index8_map(SDL_BlitInfo *info)
 	while ( height-- ) {
 		for ( c=width/4; c; --c ) {
 			/* Pack RGB into 8bit pixel */
-			RGB888_RGB332(Pixel, *src);
+			RGB888_INDEX555(Pixel, *src);
 			*dst++ = map[Pixel];
 			++src;
-			RGB888_RGB332(Pixel, *src);
+			RGB888_INDEX555(Pixel, *src);
 			*dst++ = map[Pixel];
 			++src;
-			RGB888_RGB332(Pixel, *src);
+			RGB888_INDEX555(Pixel, *src);
 			*dst++ = map[Pixel];
 			++src;
-			RGB888_RGB332(Pixel, *src);
+			RGB888_INDEX555(Pixel, *src);
 			*dst++ = map[Pixel];
 			++src;
 		}
 		switch ( width & 3 ) {
 			case 3:
-				RGB888_RGB332(Pixel, *src);
+				RGB888_INDEX555(Pixel, *src);
 				*dst++ = map[Pixel];
 				++src;
 			case 2:
-				RGB888_RGB332(Pixel, *src);
+				RGB888_INDEX555(Pixel, *src);
 				*dst++ = map[Pixel];
 				++src;
 			case 1:
-				RGB888_RGB332(Pixel, *src);
+				RGB888_INDEX555(Pixel, *src);
 				*dst++ = map[Pixel];
 				++src;
 		}
@@ -1959,9 +2342,7 @@ static void BlitNto1(SDL_BlitInfo *info)
 								sR, sG, sB);
 				if ( 1 ) {
 				  	/* Pack RGB into 8bit pixel */
-				  	*dst = map[((sR>>5)<<(3+2))|
-						   ((sG>>5)<<(2))  |
-						   ((sB>>6)<<(0))  ];
+				  	*dst = map[RGB_INDEX555(sR, sG, sB)];
 				}
 				dst++;
 				src += srcbpp;
@@ -1972,9 +2353,7 @@ static void BlitNto1(SDL_BlitInfo *info)
 								sR, sG, sB);
 				if ( 1 ) {
 				  	/* Pack RGB into 8bit pixel */
-				  	*dst = map[((sR>>5)<<(3+2))|
-						   ((sG>>5)<<(2))  |
-						   ((sB>>6)<<(0))  ];
+				  	*dst = map[RGB_INDEX555(sR, sG, sB)];
 				}
 				dst++;
 				src += srcbpp;
@@ -2141,9 +2520,7 @@ static void BlitNto1Key(SDL_BlitInfo *info)
 								sR, sG, sB);
 				if ( (Pixel & rgbmask) != ckey ) {
 				  	/* Pack RGB into 8bit pixel */
-				  	*dst = (Uint8)palmap[((sR>>5)<<(3+2))|
-							             ((sG>>5)<<(2))  |
-							             ((sB>>6)<<(0))  ];
+				  	*dst = palmap[RGB_INDEX555(sR, sG, sB)];
 				}
 				dst++;
 				src += srcbpp;
@@ -2155,6 +2532,105 @@ static void BlitNto1Key(SDL_BlitInfo *info)
 	}
 }
 
+/*
+ * Ordered dithering for N to 8-bit blits through an inverse palette, on
+ * when SDL_VIDEO_PALETTE_DITHER is set to 1.  The 4x4 pattern is anchored
+ * to the destination surface, so neighbouring blits line up.  Each step
+ * of the pattern has a table of the dithered, clamped channel values.
+ */
+static int palette_dither = -1;
+static Uint8 dither_levels[4*4][256];
+
+static void InitPaletteDither(void)
+{
+	static const Sint8 pattern[4*4] = {
+		-15,   1, -11,   5,
+		  9,  -7,  13,  -3,
+		 -9,   7, -13,   3,
+		 15,  -1,  11,  -5
+	};
+	const char *env;
+	int i, v;
+
+	env = SDL_getenv("SDL_VIDEO_PALETTE_DITHER");
+	palette_dither = (env && SDL_atoi(env) > 0);
+	for ( i = 0; i < 4*4; ++i ) {
+		for ( v = 0; v < 256; ++v ) {
+			int level = v + pattern[i];
+			if ( level < 0 ) {
+				level = 0;
+			} else if ( level > 255 ) {
+				level = 255;
+			}
+			dither_levels[i][v] = (Uint8)level;
+		}
+	}
+}
+
+static __inline__ void BlitNto1Dithered(SDL_BlitInfo *info, int keyed,
+                                        int srcbpp)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip;
+	SDL_PixelFormat *srcfmt = info->src;
+	const Uint8 *map = info->table;
+	Uint32 rgbmask = ~srcfmt->Amask;
+	Uint32 ckey = srcfmt->colorkey & rgbmask;
+	int x, y = info->d_y;
+	Uint32 Pixel;
+	unsigned sR, sG, sB;
+
+	while ( height-- ) {
+		const Uint8 (*row)[256] = &dither_levels[(y & 3) << 2];
+		for ( x = info->d_x; x < info->d_x + width; ++x ) {
+			DISEMBLE_RGB(src, srcbpp, srcfmt, Pixel, sR, sG, sB);
+			if ( !keyed || (Pixel & rgbmask) != ckey ) {
+				const Uint8 *level = row[x & 3];
+				*dst = map[RGB_INDEX555(level[sR], level[sG],
+				                        level[sB])];
+			}
+			dst++;
+			src += srcbpp;
+		}
+		src += srcskip;
+		dst += dstskip;
+		++y;
+	}
+}
+/* Separate copies for each source depth keep the pixel loads simple */
+static void BlitNto1Dither(SDL_BlitInfo *info)
+{
+	switch ( info->src->BytesPerPixel ) {
+	    case 2:
+		BlitNto1Dithered(info, 0, 2);
+		break;
+	    case 3:
+		BlitNto1Dithered(info, 0, 3);
+		break;
+	    default:
+		BlitNto1Dithered(info, 0, 4);
+		break;
+	}
+}
+static void BlitNto1DitherKey(SDL_BlitInfo *info)
+{
+	switch ( info->src->BytesPerPixel ) {
+	    case 2:
+		BlitNto1Dithered(info, 1, 2);
+		break;
+	    case 3:
+		BlitNto1Dithered(info, 1, 3);
+		break;
+	    default:
+		BlitNto1Dithered(info, 1, 4);
+		break;
+	}
+}
+
 static void Blit2to2Key(SDL_BlitInfo *info)
 {
 	int width = info->d_width;
@@ -2269,73 +2745,1052 @@ static void BlitNtoNKeyCopyAlpha(SDL_BlitInfo *info)
 	}
 }
 
-/* Normal N to N optimized blitters */
-struct blit_table {
-	Uint32 srcR, srcG, srcB;
-	int dstbpp;
-	Uint32 dstR, dstG, dstB;
-	Uint32 blit_features;
-	void *aux_data;
-	SDL_loblit blitfunc;
-	enum { NO_ALPHA=1, SET_ALPHA=2, COPY_ALPHA=4 } alpha;
-};
-static const struct blit_table normal_blit_1[] = {
-	/* Default for 8-bit RGB source, an invalid combination */
-	{ 0,0,0, 0, 0,0,0, 0, NULL, NULL },
-};
-static const struct blit_table normal_blit_2[] = {
-#if SDL_HERMES_BLITTERS
-    { 0x0000F800,0x000007E0,0x0000001F, 2, 0x0000001F,0x000007E0,0x0000F800,
-      0, ConvertX86p16_16BGR565, ConvertX86, NO_ALPHA },
-    { 0x0000F800,0x000007E0,0x0000001F, 2, 0x00007C00,0x000003E0,0x0000001F,
-      0, ConvertX86p16_16RGB555, ConvertX86, NO_ALPHA },
-    { 0x0000F800,0x000007E0,0x0000001F, 2, 0x0000001F,0x000003E0,0x00007C00,
-      0, ConvertX86p16_16BGR555, ConvertX86, NO_ALPHA },
-#elif SDL_ALTIVEC_BLITTERS
-    /* has-altivec */
-    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x00000000,0x00000000,0x00000000,
-      2, NULL, Blit_RGB565_32Altivec, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
-    { 0x00007C00,0x000003E0,0x0000001F, 4, 0x00000000,0x00000000,0x00000000,
-      2, NULL, Blit_RGB555_32Altivec, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+/*
+ * Packed 24-bit conversions.  24-bit pixels are moved a byte per channel,
+ * so these are only used when every channel of the 24-bit format is a
+ * whole byte (see BlitFormatsOK), but the other format can be any layout.
+ * The arithmetic is that of BlitNtoN, so the results are identical.
+ */
+
+/* Offset of the byte holding the channel at shift in a 24-bit pixel */
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#define BYTE24(shift)	((shift) >> 3)
+#else
+#define BYTE24(shift)	(2 - ((shift) >> 3))
 #endif
-    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x00FF0000,0x0000FF00,0x000000FF,
-      0, NULL, Blit_RGB565_ARGB8888, SET_ALPHA },
-    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x000000FF,0x0000FF00,0x00FF0000,
-      0, NULL, Blit_RGB565_ABGR8888, SET_ALPHA },
-    { 0x0000F800,0x000007E0,0x0000001F, 4, 0xFF000000,0x00FF0000,0x0000FF00,
-      0, NULL, Blit_RGB565_RGBA8888, SET_ALPHA },
-    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x0000FF00,0x00FF0000,0xFF000000,
-      0, NULL, Blit_RGB565_BGRA8888, SET_ALPHA },
 
-    /* Default for 16-bit RGB source, used if no other blitter matches */
-    { 0,0,0, 0, 0,0,0, 0, NULL, BlitNtoN, 0 }
-};
-static const struct blit_table normal_blit_3[] = {
-	/* Default for 24-bit RGB source, never optimized */
-    { 0,0,0, 0, 0,0,0, 0, NULL, BlitNtoN, 0 }
-};
-static const struct blit_table normal_blit_4[] = {
-#if SDL_HERMES_BLITTERS
-    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000F800,0x000007E0,0x0000001F,
-      1, ConvertMMXpII32_16RGB565, ConvertMMX, NO_ALPHA },
-    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000F800,0x000007E0,0x0000001F,
-      0, ConvertX86p32_16RGB565, ConvertX86, NO_ALPHA },
-    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000001F,0x000007E0,0x0000F800,
-      1, ConvertMMXpII32_16BGR565, ConvertMMX, NO_ALPHA },
-    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000001F,0x000007E0,0x0000F800,
-      0, ConvertX86p32_16BGR565, ConvertX86, NO_ALPHA },
-    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x00007C00,0x000003E0,0x0000001F,
-      1, ConvertMMXpII32_16RGB555, ConvertMMX, NO_ALPHA },
-    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x00007C00,0x000003E0,0x0000001F,
-      0, ConvertX86p32_16RGB555, ConvertX86, NO_ALPHA },
-    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000001F,0x000003E0,0x00007C00,
-      1, ConvertMMXpII32_16BGR555, ConvertMMX, NO_ALPHA },
-    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000001F,0x000003E0,0x00007C00,
-      0, ConvertX86p32_16BGR555, ConvertX86, NO_ALPHA },
-    { 0x00FF0000,0x0000FF00,0x000000FF, 3, 0x00FF0000,0x0000FF00,0x000000FF,
-      1, ConvertMMXpII32_24RGB888, ConvertMMX, NO_ALPHA },
-    { 0x00FF0000,0x0000FF00,0x000000FF, 3, 0x00FF0000,0x0000FF00,0x000000FF,
-      0, ConvertX86p32_24RGB888, ConvertX86, NO_ALPHA },
+/* Packed 24-bit --> any 16 or 32-bit */
+static __inline__ void Blit24toN(SDL_BlitInfo *info, int dstbpp)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	int r = BYTE24(srcfmt->Rshift);
+	int g = BYTE24(srcfmt->Gshift);
+	int b = BYTE24(srcfmt->Bshift);
+	int rloss = dstfmt->Rloss, rshift = dstfmt->Rshift;
+	int gloss = dstfmt->Gloss, gshift = dstfmt->Gshift;
+	int bloss = dstfmt->Bloss, bshift = dstfmt->Bshift;
+	Uint32 alpha = dstfmt->Amask ?
+		(srcfmt->alpha >> dstfmt->Aloss) << dstfmt->Ashift : 0;
+
+	while ( height-- ) {
+		DUFFS_LOOP(
+		{
+			Uint32 Pixel = ((src[r] >> rloss) << rshift) |
+			               ((src[g] >> gloss) << gshift) |
+			               ((src[b] >> bloss) << bshift) | alpha;
+			if ( dstbpp == 2 ) {
+				*(Uint16 *)dst = (Uint16)Pixel;
+			} else {
+				*(Uint32 *)dst = Pixel;
+			}
+			src += 3;
+			dst += dstbpp;
+		},
+		width);
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+static void Blit24to16(SDL_BlitInfo *info)
+{
+	Blit24toN(info, 2);
+}
+static void Blit24to32(SDL_BlitInfo *info)
+{
+	Blit24toN(info, 4);
+}
+
+/* Any 16 or 32-bit --> packed 24-bit */
+static __inline__ void BlitNto24(SDL_BlitInfo *info, int srcbpp)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	int r = BYTE24(dstfmt->Rshift);
+	int g = BYTE24(dstfmt->Gshift);
+	int b = BYTE24(dstfmt->Bshift);
+	Uint32 rmask = srcfmt->Rmask, gmask = srcfmt->Gmask, bmask = srcfmt->Bmask;
+	int rshift = srcfmt->Rshift, rloss = srcfmt->Rloss;
+	int gshift = srcfmt->Gshift, gloss = srcfmt->Gloss;
+	int bshift = srcfmt->Bshift, bloss = srcfmt->Bloss;
+
+	while ( height-- ) {
+		DUFFS_LOOP(
+		{
+			Uint32 Pixel;
+			if ( srcbpp == 2 ) {
+				Pixel = *(Uint16 *)src;
+			} else {
+				Pixel = *(Uint32 *)src;
+			}
+			dst[r] = (Uint8)(((Pixel & rmask) >> rshift) << rloss);
+			dst[g] = (Uint8)(((Pixel & gmask) >> gshift) << gloss);
+			dst[b] = (Uint8)(((Pixel & bmask) >> bshift) << bloss);
+			src += srcbpp;
+			dst += 3;
+		},
+		width);
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+static void Blit16to24(SDL_BlitInfo *info)
+{
+	BlitNto24(info, 2);
+}
+static void Blit32to24(SDL_BlitInfo *info)
+{
+	BlitNto24(info, 4);
+}
+
+/* Packed 24-bit --> packed 24-bit with the channels in another order */
+static void Blit24to24(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip;
+	int sr = BYTE24(info->src->Rshift), dr = BYTE24(info->dst->Rshift);
+	int sg = BYTE24(info->src->Gshift), dg = BYTE24(info->dst->Gshift);
+	int sb = BYTE24(info->src->Bshift), db = BYTE24(info->dst->Bshift);
+
+	while ( height-- ) {
+		DUFFS_LOOP(
+		{
+			Uint8 R = src[sr];
+			Uint8 G = src[sg];
+			Uint8 B = src[sb];
+			dst[dr] = R;
+			dst[dg] = G;
+			dst[db] = B;
+			src += 3;
+			dst += 3;
+		},
+		width);
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+
+#if SDL_ARM_NEON_BLITTERS
+/* NEON versions of the 24-bit conversions, sixteen pixels at a time.
+   vld3q_u8/vst3q_u8 split packed pixels into one register per byte. */
+
+/* Packed 24-bit --> 32-bit 8888 */
+static void Blit24to32NEON(SDL_BlitInfo *info)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~15;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip + (info->d_width - vwidth) * 3;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip + (info->d_width - vwidth) * 4;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	int r = BYTE24(srcfmt->Rshift);
+	int g = BYTE24(srcfmt->Gshift);
+	int b = BYTE24(srcfmt->Bshift);
+	/* The byte not holding R, G or B gets the alpha, or zero */
+	int a = 6 - NEON_LANE(dstfmt->Rshift) - NEON_LANE(dstfmt->Gshift) -
+	        NEON_LANE(dstfmt->Bshift);
+	uint8x16_t alpha = vdupq_n_u8(dstfmt->Amask ? srcfmt->alpha : 0);
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 16 ) {
+				uint8x16x3_t in = vld3q_u8(src);
+				uint8x16x4_t out;
+				out.val[NEON_LANE(dstfmt->Rshift)] = in.val[r];
+				out.val[NEON_LANE(dstfmt->Gshift)] = in.val[g];
+				out.val[NEON_LANE(dstfmt->Bshift)] = in.val[b];
+				out.val[a] = alpha;
+				vst4q_u8(dst, out);
+				src += 48;
+				dst += 64;
+			}
+			src += srcskip;
+			dst += dstskip;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, Blit24to32);
+}
+
+/* 32-bit 8888 --> packed 24-bit */
+static void Blit32to24NEON(SDL_BlitInfo *info)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~15;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip + (info->d_width - vwidth) * 4;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip + (info->d_width - vwidth) * 3;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	int r = NEON_LANE(srcfmt->Rshift);
+	int g = NEON_LANE(srcfmt->Gshift);
+	int b = NEON_LANE(srcfmt->Bshift);
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 16 ) {
+				uint8x16x4_t in = vld4q_u8(src);
+				uint8x16x3_t out;
+				out.val[BYTE24(dstfmt->Rshift)] = in.val[r];
+				out.val[BYTE24(dstfmt->Gshift)] = in.val[g];
+				out.val[BYTE24(dstfmt->Bshift)] = in.val[b];
+				vst3q_u8(dst, out);
+				src += 64;
+				dst += 48;
+			}
+			src += srcskip;
+			dst += dstskip;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, Blit32to24);
+}
+
+/* Packed 24-bit --> packed 24-bit swizzle */
+static void Blit24to24NEON(SDL_BlitInfo *info)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~15;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip + (info->d_width - vwidth) * 3;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip + (info->d_width - vwidth) * 3;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	int r = BYTE24(srcfmt->Rshift);
+	int g = BYTE24(srcfmt->Gshift);
+	int b = BYTE24(srcfmt->Bshift);
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 16 ) {
+				uint8x16x3_t in = vld3q_u8(src);
+				uint8x16x3_t out;
+				out.val[BYTE24(dstfmt->Rshift)] = in.val[r];
+				out.val[BYTE24(dstfmt->Gshift)] = in.val[g];
+				out.val[BYTE24(dstfmt->Bshift)] = in.val[b];
+				vst3q_u8(dst, out);
+				src += 48;
+				dst += 48;
+			}
+			src += srcskip;
+			dst += dstskip;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, Blit24to24);
+}
+
+/* Packed 24-bit --> RGB 5-6-5 or RGB 5-5-5 */
+static __inline__ uint16x8_t Pack24to16NEON(uint8x8_t r, uint8x8_t g,
+                                            uint8x8_t b, int is555)
+{
+	uint16x8_t out;
+	if ( is555 ) {
+		out = vsriq_n_u16(vdupq_n_u16(0), vshll_n_u8(r, 8), 1);
+		out = vsriq_n_u16(out, vshll_n_u8(g, 8), 6);
+	} else {
+		out = vsriq_n_u16(vshll_n_u8(r, 8), vshll_n_u8(g, 8), 5);
+	}
+	return vsriq_n_u16(out, vshll_n_u8(b, 8), 11);
+}
+static __inline__ void Blit24to16NEON(SDL_BlitInfo *info, int is555)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~15;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip + (info->d_width - vwidth) * 3;
+	Uint16 *dst = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip / 2 + (info->d_width - vwidth);
+	int r = BYTE24(info->src->Rshift);
+	int g = BYTE24(info->src->Gshift);
+	int b = BYTE24(info->src->Bshift);
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 16 ) {
+				uint8x16x3_t in = vld3q_u8(src);
+				vst1q_u16(dst, Pack24to16NEON(vget_low_u8(in.val[r]),
+					vget_low_u8(in.val[g]),
+					vget_low_u8(in.val[b]), is555));
+				vst1q_u16(dst + 8, Pack24to16NEON(
+					vget_high_u8(in.val[r]),
+					vget_high_u8(in.val[g]),
+					vget_high_u8(in.val[b]), is555));
+				src += 48;
+				dst += 16;
+			}
+			src += srcskip;
+			dst += dstskip;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, Blit24to16);
+}
+static void Blit24_RGB565NEON(SDL_BlitInfo *info)
+{
+	Blit24to16NEON(info, 0);
+}
+static void Blit24_RGB555NEON(SDL_BlitInfo *info)
+{
+	Blit24to16NEON(info, 1);
+}
+
+/* RGB 5-6-5 or RGB 5-5-5 --> packed 24-bit, with the low bits of each
+   channel left clear like BlitNtoN does */
+static __inline__ void Blit16to24NEON(SDL_BlitInfo *info, int is555)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~15;
+	Uint16 *src = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip / 2 + (info->d_width - vwidth);
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip + (info->d_width - vwidth) * 3;
+	int r = BYTE24(info->dst->Rshift);
+	int g = BYTE24(info->dst->Gshift);
+	int b = BYTE24(info->dst->Bshift);
+	uint8x8_t mask5 = vdup_n_u8(0xF8);
+	uint8x8_t gmask = vdup_n_u8(is555 ? 0xF8 : 0xFC);
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 16 ) {
+				uint16x8_t lo = vld1q_u16(src);
+				uint16x8_t hi = vld1q_u16(src + 8);
+				uint8x16x3_t out;
+				if ( is555 ) {
+					out.val[r] = vcombine_u8(
+						vand_u8(vshrn_n_u16(lo, 7), mask5),
+						vand_u8(vshrn_n_u16(hi, 7), mask5));
+					out.val[g] = vcombine_u8(
+						vand_u8(vshrn_n_u16(lo, 2), gmask),
+						vand_u8(vshrn_n_u16(hi, 2), gmask));
+				} else {
+					out.val[r] = vcombine_u8(
+						vand_u8(vshrn_n_u16(lo, 8), mask5),
+						vand_u8(vshrn_n_u16(hi, 8), mask5));
+					out.val[g] = vcombine_u8(
+						vand_u8(vshrn_n_u16(lo, 3), gmask),
+						vand_u8(vshrn_n_u16(hi, 3), gmask));
+				}
+				out.val[b] = vcombine_u8(
+					vmovn_u16(vshlq_n_u16(lo, 3)),
+					vmovn_u16(vshlq_n_u16(hi, 3)));
+				vst3q_u8(dst, out);
+				src += 16;
+				dst += 48;
+			}
+			src += srcskip;
+			dst += dstskip;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, Blit16to24);
+}
+static void Blit_RGB565_24NEON(SDL_BlitInfo *info)
+{
+	Blit16to24NEON(info, 0);
+}
+static void Blit_RGB555_24NEON(SDL_BlitInfo *info)
+{
+	Blit16to24NEON(info, 1);
+}
+#endif /* SDL_ARM_NEON_BLITTERS */
+
+#if SDL_AVX2_BLITTERS
+#include <immintrin.h>
+
+/*
+ * AVX2 versions of the 24-bit conversions, eight pixels at a time.  The
+ * 24 bytes of eight packed pixels are spread over the two 128-bit lanes,
+ * four pixels in each, so that one in-lane byte shuffle can move every
+ * channel into or out of 32-bit pixels.
+ */
+
+/* Load eight packed pixels, four in the low 12 bytes of each lane */
+static SDL_TARGET_AVX2 __inline__ __m256i Load24AVX2(const Uint8 *src)
+{
+	__m256i v = _mm256_inserti128_si256(
+		_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)src)),
+		_mm_loadl_epi64((const __m128i *)(src + 16)), 1);
+	return _mm256_permutevar8x32_epi32(v,
+		_mm256_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0));
+}
+
+/* Store eight packed pixels from the low 12 bytes of each lane */
+static SDL_TARGET_AVX2 __inline__ void Store24AVX2(Uint8 *dst, __m256i v)
+{
+	v = _mm256_permutevar8x32_epi32(v,
+		_mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+	_mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(v));
+	_mm_storel_epi64((__m128i *)(dst + 16), _mm256_extracti128_si256(v, 1));
+}
+
+/* Shuffle moving the R, G and B bytes of each pixel in a lane from the
+   given offsets in srcbpp byte pixels to those in dstbpp byte pixels.
+   All other bytes are cleared. */
+static SDL_TARGET_AVX2 __m256i Shuffle24AVX2(int srcbpp, int sr, int sg, int sb,
+                                            int dstbpp, int dr, int dg, int db)
+{
+	Uint8 mask[32];
+	int i;
+
+	SDL_memset(mask, 0x80, sizeof(mask));
+	for ( i = 0; i < 4; ++i ) {
+		mask[i*dstbpp+dr] = mask[16+i*dstbpp+dr] = (Uint8)(i*srcbpp+sr);
+		mask[i*dstbpp+dg] = mask[16+i*dstbpp+dg] = (Uint8)(i*srcbpp+sg);
+		mask[i*dstbpp+db] = mask[16+i*dstbpp+db] = (Uint8)(i*srcbpp+sb);
+	}
+	return _mm256_loadu_si256((__m256i *)mask);
+}
+
+/* Packed 24-bit --> 32-bit 8888 */
+static SDL_TARGET_AVX2 void Blit24to32AVX2(SDL_BlitInfo *info)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~7;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip + (info->d_width - vwidth) * 3;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip + (info->d_width - vwidth) * 4;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	__m256i shuffle = Shuffle24AVX2(3, BYTE24(srcfmt->Rshift),
+		BYTE24(srcfmt->Gshift), BYTE24(srcfmt->Bshift),
+		4, dstfmt->Rshift >> 3, dstfmt->Gshift >> 3, dstfmt->Bshift >> 3);
+	__m256i alpha = _mm256_set1_epi32(dstfmt->Amask ?
+		(srcfmt->alpha >> dstfmt->Aloss) << dstfmt->Ashift : 0);
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 8 ) {
+				__m256i p = _mm256_shuffle_epi8(Load24AVX2(src), shuffle);
+				_mm256_storeu_si256((__m256i *)dst,
+				                    _mm256_or_si256(p, alpha));
+				src += 24;
+				dst += 32;
+			}
+			src += srcskip;
+			dst += dstskip;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, Blit24to32);
+}
+
+/* 32-bit 8888 --> packed 24-bit */
+static SDL_TARGET_AVX2 void Blit32to24AVX2(SDL_BlitInfo *info)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~7;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip + (info->d_width - vwidth) * 4;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip + (info->d_width - vwidth) * 3;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	__m256i shuffle = Shuffle24AVX2(4, srcfmt->Rshift >> 3,
+		srcfmt->Gshift >> 3, srcfmt->Bshift >> 3,
+		3, BYTE24(dstfmt->Rshift), BYTE24(dstfmt->Gshift),
+		BYTE24(dstfmt->Bshift));
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 8 ) {
+				__m256i p = _mm256_loadu_si256((__m256i *)src);
+				Store24AVX2(dst, _mm256_shuffle_epi8(p, shuffle));
+				src += 32;
+				dst += 24;
+			}
+			src += srcskip;
+			dst += dstskip;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, Blit32to24);
+}
+
+/* Packed 24-bit --> packed 24-bit swizzle */
+static SDL_TARGET_AVX2 void Blit24to24AVX2(SDL_BlitInfo *info)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~7;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip + (info->d_width - vwidth) * 3;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip + (info->d_width - vwidth) * 3;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	__m256i shuffle = Shuffle24AVX2(3, BYTE24(srcfmt->Rshift),
+		BYTE24(srcfmt->Gshift), BYTE24(srcfmt->Bshift),
+		3, BYTE24(dstfmt->Rshift), BYTE24(dstfmt->Gshift),
+		BYTE24(dstfmt->Bshift));
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 8 ) {
+				Store24AVX2(dst, _mm256_shuffle_epi8(Load24AVX2(src),
+				                                     shuffle));
+				src += 24;
+				dst += 24;
+			}
+			src += srcskip;
+			dst += dstskip;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, Blit24to24);
+}
+
+/* Packed 24-bit --> any 16-bit, through 32-bit XRGB pixels */
+static SDL_TARGET_AVX2 void Blit24to16AVX2(SDL_BlitInfo *info)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~7;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip + (info->d_width - vwidth) * 3;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip + (info->d_width - vwidth) * 2;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	__m256i shuffle = Shuffle24AVX2(3, BYTE24(srcfmt->Rshift),
+		BYTE24(srcfmt->Gshift), BYTE24(srcfmt->Bshift), 4, 2, 1, 0);
+	__m128i rs = _mm_cvtsi32_si128(16 + dstfmt->Rloss);
+	__m128i gs = _mm_cvtsi32_si128(8 + dstfmt->Gloss);
+	__m128i bs = _mm_cvtsi32_si128(dstfmt->Bloss);
+	__m256i rm = _mm256_set1_epi32(0xFF >> dstfmt->Rloss);
+	__m256i gm = _mm256_set1_epi32(0xFF >> dstfmt->Gloss);
+	__m256i bm = _mm256_set1_epi32(0xFF >> dstfmt->Bloss);
+	__m128i rd = _mm_cvtsi32_si128(dstfmt->Rshift);
+	__m128i gd = _mm_cvtsi32_si128(dstfmt->Gshift);
+	__m128i bd = _mm_cvtsi32_si128(dstfmt->Bshift);
+	__m256i alpha = _mm256_set1_epi32(dstfmt->Amask ?
+		(srcfmt->alpha >> dstfmt->Aloss) << dstfmt->Ashift : 0);
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 8 ) {
+				__m256i p = _mm256_shuffle_epi8(Load24AVX2(src), shuffle);
+				__m256i out = _mm256_or_si256(_mm256_or_si256(
+					_mm256_sll_epi32(_mm256_and_si256(_mm256_srl_epi32(p, rs), rm), rd),
+					_mm256_sll_epi32(_mm256_and_si256(_mm256_srl_epi32(p, gs), gm), gd)),
+					_mm256_sll_epi32(_mm256_and_si256(_mm256_srl_epi32(p, bs), bm), bd));
+				out = _mm256_and_si256(_mm256_or_si256(out, alpha),
+				                       _mm256_set1_epi32(0xFFFF));
+				out = _mm256_permute4x64_epi64(
+					_mm256_packus_epi32(out, out), 0x08);
+				_mm_storeu_si128((__m128i *)dst,
+				                 _mm256_castsi256_si128(out));
+				src += 24;
+				dst += 16;
+			}
+			src += srcskip;
+			dst += dstskip;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, Blit24to16);
+}
+
+/* Any 16-bit --> packed 24-bit, through 32-bit XRGB pixels */
+static SDL_TARGET_AVX2 void Blit16to24AVX2(SDL_BlitInfo *info)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~7;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip + (info->d_width - vwidth) * 2;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip + (info->d_width - vwidth) * 3;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	__m256i shuffle = Shuffle24AVX2(4, 2, 1, 0, 3, BYTE24(dstfmt->Rshift),
+		BYTE24(dstfmt->Gshift), BYTE24(dstfmt->Bshift));
+	__m256i byte = _mm256_set1_epi32(0xFF);
+	__m256i rm = _mm256_set1_epi32(srcfmt->Rmask);
+	__m256i gm = _mm256_set1_epi32(srcfmt->Gmask);
+	__m256i bm = _mm256_set1_epi32(srcfmt->Bmask);
+	__m128i rs = _mm_cvtsi32_si128(srcfmt->Rshift);
+	__m128i gs = _mm_cvtsi32_si128(srcfmt->Gshift);
+	__m128i bs = _mm_cvtsi32_si128(srcfmt->Bshift);
+	__m128i rl = _mm_cvtsi32_si128(srcfmt->Rloss);
+	__m128i gl = _mm_cvtsi32_si128(srcfmt->Gloss);
+	__m128i bl = _mm_cvtsi32_si128(srcfmt->Bloss);
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 8 ) {
+				__m256i p = _mm256_cvtepu16_epi32(
+					_mm_loadu_si128((__m128i *)src));
+				__m256i r = _mm256_and_si256(_mm256_sll_epi32(
+					_mm256_srl_epi32(_mm256_and_si256(p, rm), rs), rl), byte);
+				__m256i g = _mm256_and_si256(_mm256_sll_epi32(
+					_mm256_srl_epi32(_mm256_and_si256(p, gm), gs), gl), byte);
+				__m256i b = _mm256_and_si256(_mm256_sll_epi32(
+					_mm256_srl_epi32(_mm256_and_si256(p, bm), bs), bl), byte);
+				p = _mm256_or_si256(_mm256_or_si256(
+					_mm256_slli_epi32(r, 16), _mm256_slli_epi32(g, 8)), b);
+				Store24AVX2(dst, _mm256_shuffle_epi8(p, shuffle));
+				src += 16;
+				dst += 24;
+			}
+			src += srcskip;
+			dst += dstskip;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, Blit16to24);
+}
+#endif /* SDL_AVX2_BLITTERS */
+
+#if SDL_SSE2_BLITTERS
+#include <emmintrin.h>
+
+/* These work on any channel layout, moving each channel with a shift and
+   mask exactly like BlitNtoN does, four or eight pixels at a time.  Each
+   is built with and without aligned loads and stores, see
+   SDL_BlitIsAligned(). */
+
+/* Pack the low 16 bits of each 32-bit lane of two vectors */
+static __inline__ __m128i Pack32to16SSE2(__m128i lo, __m128i hi)
+{
+	lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+	hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+	return _mm_packs_epi32(lo, hi);
+}
+
+/* 32-bit 8888 --> any 16-bit RGB.  If keyed, pixels matching the source
+   colorkey are left alone, selected with a compare mask rather than a
+   branch per pixel. */
+static __inline__ void Convert32to16SSE2(SDL_BlitInfo *info, int keyed,
+                                         int aligned)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~7;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip + info->d_width * 4;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip + info->d_width * 2;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	__m128i rs = _mm_cvtsi32_si128(srcfmt->Rshift + dstfmt->Rloss);
+	__m128i gs = _mm_cvtsi32_si128(srcfmt->Gshift + dstfmt->Gloss);
+	__m128i bs = _mm_cvtsi32_si128(srcfmt->Bshift + dstfmt->Bloss);
+	__m128i rm = _mm_set1_epi32(dstfmt->Rmask >> dstfmt->Rshift);
+	__m128i gm = _mm_set1_epi32(dstfmt->Gmask >> dstfmt->Gshift);
+	__m128i bm = _mm_set1_epi32(dstfmt->Bmask >> dstfmt->Bshift);
+	__m128i rd = _mm_cvtsi32_si128(dstfmt->Rshift);
+	__m128i gd = _mm_cvtsi32_si128(dstfmt->Gshift);
+	__m128i bd = _mm_cvtsi32_si128(dstfmt->Bshift);
+	Uint32 rgbmask = ~srcfmt->Amask;
+	__m128i km = _mm_set1_epi32(rgbmask);
+	__m128i kv = _mm_set1_epi32(srcfmt->colorkey & rgbmask);
+
+#define CONVERT_4(p) \
+	_mm_or_si128(_mm_or_si128( \
+		_mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(p, rs), rm), rd), \
+		_mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(p, gs), gm), gd)), \
+		_mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(p, bs), bm), bd))
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 8 ) {
+				__m128i p0 = SDL_LOAD_SSE2(aligned, src);
+				__m128i p1 = SDL_LOAD_SSE2(aligned, src + 16);
+				__m128i out = Pack32to16SSE2(CONVERT_4(p0),
+				                             CONVERT_4(p1));
+				if ( keyed ) {
+					__m128i skip = _mm_packs_epi32(
+						_mm_cmpeq_epi32(_mm_and_si128(p0, km), kv),
+						_mm_cmpeq_epi32(_mm_and_si128(p1, km), kv));
+					out = _mm_or_si128(
+						_mm_and_si128(skip, SDL_LOAD_SSE2(aligned, dst)),
+						_mm_andnot_si128(skip, out));
+				}
+				SDL_STORE_SSE2(aligned, dst, out);
+				src += 32;
+				dst += 16;
+			}
+			src += srcskip - vwidth * 4;
+			dst += dstskip - vwidth * 2;
+		}
+	}
+#undef CONVERT_4
+	SDL_BlitRemainder(info, vwidth, keyed ? BlitNtoNKey : BlitNtoN);
+}
+static void Blit32to16SSE2(SDL_BlitInfo *info)
+{
+	if ( SDL_BlitIsAligned(info, 16) ) {
+		Convert32to16SSE2(info, 0, 1);
+	} else {
+		Convert32to16SSE2(info, 0, 0);
+	}
+}
+static void Blit32to16KeySSE2(SDL_BlitInfo *info)
+{
+	if ( SDL_BlitIsAligned(info, 16) ) {
+		Convert32to16SSE2(info, 1, 1);
+	} else {
+		Convert32to16SSE2(info, 1, 0);
+	}
+}
+
+/* Any 16-bit RGB --> 32-bit 8888, setting alpha if there is one */
+static __inline__ void Convert16to32SSE2(SDL_BlitInfo *info, int aligned)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~7;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip + info->d_width * 2;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip + info->d_width * 4;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	__m128i zero = _mm_setzero_si128();
+	__m128i rs = _mm_cvtsi32_si128(srcfmt->Rshift);
+	__m128i gs = _mm_cvtsi32_si128(srcfmt->Gshift);
+	__m128i bs = _mm_cvtsi32_si128(srcfmt->Bshift);
+	__m128i rm = _mm_set1_epi32(srcfmt->Rmask >> srcfmt->Rshift);
+	__m128i gm = _mm_set1_epi32(srcfmt->Gmask >> srcfmt->Gshift);
+	__m128i bm = _mm_set1_epi32(srcfmt->Bmask >> srcfmt->Bshift);
+	__m128i rd = _mm_cvtsi32_si128(srcfmt->Rloss + dstfmt->Rshift);
+	__m128i gd = _mm_cvtsi32_si128(srcfmt->Gloss + dstfmt->Gshift);
+	__m128i bd = _mm_cvtsi32_si128(srcfmt->Bloss + dstfmt->Bshift);
+	__m128i alpha = _mm_set1_epi32(dstfmt->Amask ?
+		(srcfmt->alpha >> dstfmt->Aloss) << dstfmt->Ashift : 0);
+
+#define CONVERT_4(p) \
+	_mm_or_si128(_mm_or_si128(_mm_or_si128( \
+		_mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(p, rs), rm), rd), \
+		_mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(p, gs), gm), gd)), \
+		_mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(p, bs), bm), bd)), \
+		alpha)
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 8 ) {
+				__m128i p = SDL_LOAD_SSE2(aligned, src);
+				__m128i p0 = _mm_unpacklo_epi16(p, zero);
+				__m128i p1 = _mm_unpackhi_epi16(p, zero);
+				SDL_STORE_SSE2(aligned, dst, CONVERT_4(p0));
+				SDL_STORE_SSE2(aligned, dst + 16, CONVERT_4(p1));
+				src += 16;
+				dst += 32;
+			}
+			src += srcskip - vwidth * 2;
+			dst += dstskip - vwidth * 4;
+		}
+	}
+#undef CONVERT_4
+	SDL_BlitRemainder(info, vwidth, BlitNtoN);
+}
+static void Blit16to32SSE2(SDL_BlitInfo *info)
+{
+	if ( SDL_BlitIsAligned(info, 16) ) {
+		Convert16to32SSE2(info, 1);
+	} else {
+		Convert16to32SSE2(info, 0);
+	}
+}
+
+/* Any 8888 --> 8888 channel swizzle, with alpha copied, set or cleared */
+static __inline__ void Convert32to32SSE2(SDL_BlitInfo *info, int aligned)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~3;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip + info->d_width * 4;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip + info->d_width * 4;
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	int copy_alpha = (srcfmt->Amask && dstfmt->Amask);
+	__m128i byte = _mm_set1_epi32(0xFF);
+	__m128i rs = _mm_cvtsi32_si128(srcfmt->Rshift);
+	__m128i gs = _mm_cvtsi32_si128(srcfmt->Gshift);
+	__m128i bs = _mm_cvtsi32_si128(srcfmt->Bshift);
+	__m128i as = _mm_cvtsi32_si128(srcfmt->Ashift);
+	__m128i rd = _mm_cvtsi32_si128(dstfmt->Rshift);
+	__m128i gd = _mm_cvtsi32_si128(dstfmt->Gshift);
+	__m128i bd = _mm_cvtsi32_si128(dstfmt->Bshift);
+	__m128i ad = _mm_cvtsi32_si128(dstfmt->Ashift);
+	__m128i amask = _mm_set1_epi32(copy_alpha ? dstfmt->Amask : 0);
+	__m128i alpha = _mm_set1_epi32((dstfmt->Amask && !copy_alpha) ?
+		(srcfmt->alpha >> dstfmt->Aloss) << dstfmt->Ashift : 0);
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 4 ) {
+				__m128i p = SDL_LOAD_SSE2(aligned, src);
+				__m128i out = _mm_or_si128(_mm_or_si128(
+					_mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(p, rs), byte), rd),
+					_mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(p, gs), byte), gd)),
+					_mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(p, bs), byte), bd));
+				out = _mm_or_si128(out, _mm_and_si128(
+					_mm_sll_epi32(_mm_srl_epi32(p, as), ad), amask));
+				SDL_STORE_SSE2(aligned, dst, _mm_or_si128(out, alpha));
+				src += 16;
+				dst += 16;
+			}
+			src += srcskip - vwidth * 4;
+			dst += dstskip - vwidth * 4;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth,
+	                  copy_alpha ? BlitNtoNCopyAlpha : BlitNtoN);
+}
+static void Blit32to32SSE2(SDL_BlitInfo *info)
+{
+	if ( SDL_BlitIsAligned(info, 16) ) {
+		Convert32to32SSE2(info, 1);
+	} else {
+		Convert32to32SSE2(info, 0);
+	}
+}
+
+/* Same format 16-bit colorkey, eight pixels at a time */
+static __inline__ void Key2to2SSE2(SDL_BlitInfo *info, int aligned)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~7;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip + info->d_width * 2;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip + info->d_width * 2;
+	Uint32 rgbmask = ~info->src->Amask;
+	Uint32 ckey = info->src->colorkey & rgbmask;
+	__m128i km = _mm_set1_epi16((short)rgbmask);
+	__m128i kv = _mm_set1_epi16((short)ckey);
+
+	/* A key wider than the pixel never matches */
+	if ( ckey > 0xFFFF ) {
+		vwidth = 0;
+	}
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 8 ) {
+				__m128i s = SDL_LOAD_SSE2(aligned, src);
+				__m128i d = SDL_LOAD_SSE2(aligned, dst);
+				__m128i skip = _mm_cmpeq_epi16(_mm_and_si128(s, km), kv);
+				SDL_STORE_SSE2(aligned, dst,
+				               _mm_or_si128(_mm_and_si128(skip, d),
+				                            _mm_andnot_si128(skip, s)));
+				src += 16;
+				dst += 16;
+			}
+			src += srcskip - vwidth * 2;
+			dst += dstskip - vwidth * 2;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, Blit2to2Key);
+}
+static void Blit2to2KeySSE2(SDL_BlitInfo *info)
+{
+	if ( SDL_BlitIsAligned(info, 16) ) {
+		Key2to2SSE2(info, 1);
+	} else {
+		Key2to2SSE2(info, 0);
+	}
+}
+
+/* Same format 8888 colorkey, four pixels at a time.  Bits outside the
+   format masks are cleared, as BlitNtoNKey does. */
+static __inline__ void Key4to4SSE2(SDL_BlitInfo *info, int aligned)
+{
+	int width;
+	int height = info->d_height;
+	int vwidth = info->d_width & ~3;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip + info->d_width * 4;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip + info->d_width * 4;
+	SDL_PixelFormat *srcfmt = info->src;
+	Uint32 rgbmask = ~srcfmt->Amask;
+	__m128i km = _mm_set1_epi32(rgbmask);
+	__m128i kv = _mm_set1_epi32(srcfmt->colorkey & rgbmask);
+	__m128i keep = _mm_set1_epi32(srcfmt->Rmask | srcfmt->Gmask |
+	                              srcfmt->Bmask | srcfmt->Amask);
+
+	if ( vwidth ) {
+		while ( height-- ) {
+			for ( width = vwidth; width; width -= 4 ) {
+				__m128i s = SDL_LOAD_SSE2(aligned, src);
+				__m128i d = SDL_LOAD_SSE2(aligned, dst);
+				__m128i skip = _mm_cmpeq_epi32(_mm_and_si128(s, km), kv);
+				SDL_STORE_SSE2(aligned, dst,
+				               _mm_or_si128(_mm_and_si128(skip, d),
+				                            _mm_andnot_si128(skip,
+				                              _mm_and_si128(s, keep))));
+				src += 16;
+				dst += 16;
+			}
+			src += srcskip - vwidth * 4;
+			dst += dstskip - vwidth * 4;
+		}
+	}
+	SDL_BlitRemainder(info, vwidth, srcfmt->Amask ?
+	                  BlitNtoNKeyCopyAlpha : BlitNtoNKey);
+}
+static void Blit4to4KeySSE2(SDL_BlitInfo *info)
+{
+	if ( SDL_BlitIsAligned(info, 16) ) {
+		Key4to4SSE2(info, 1);
+	} else {
+		Key4to4SSE2(info, 0);
+	}
+}
+#endif /* SDL_SSE2_BLITTERS */
+
+/* Normal N to N optimized blitters */
+struct blit_table {
+	Uint32 srcR, srcG, srcB;
+	int dstbpp;
+	Uint32 dstR, dstG, dstB;
+	Uint32 blit_features;
+	void *aux_data;
+	SDL_loblit blitfunc;
+	enum { NO_ALPHA=1, SET_ALPHA=2, COPY_ALPHA=4 } alpha;
+};
+static const struct blit_table normal_blit_1[] = {
+	/* Default for 8-bit RGB source, an invalid combination */
+	{ 0,0,0, 0, 0,0,0, 0, NULL, NULL },
+};
+static const struct blit_table normal_blit_2[] = {
+#if SDL_HERMES_BLITTERS
+    { 0x0000F800,0x000007E0,0x0000001F, 2, 0x0000001F,0x000007E0,0x0000F800,
+      0, ConvertX86p16_16BGR565, ConvertX86, NO_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 2, 0x00007C00,0x000003E0,0x0000001F,
+      0, ConvertX86p16_16RGB555, ConvertX86, NO_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 2, 0x0000001F,0x000003E0,0x00007C00,
+      0, ConvertX86p16_16BGR555, ConvertX86, NO_ALPHA },
+#elif SDL_ALTIVEC_BLITTERS
+    /* has-altivec */
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x00000000,0x00000000,0x00000000,
+      2, NULL, Blit_RGB565_32Altivec, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x00007C00,0x000003E0,0x0000001F, 4, 0x00000000,0x00000000,0x00000000,
+      2, NULL, Blit_RGB555_32Altivec, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+#endif
+#if SDL_ARM_NEON_BLITTERS
+    /* has-NEON */
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      8, NULL, Blit_RGB565_ARGB8888NEON, NO_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      8, NULL, Blit_RGB565_ABGR8888NEON, NO_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0xFF000000,0x00FF0000,0x0000FF00,
+      8, NULL, Blit_RGB565_RGBA8888NEON, NO_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x0000FF00,0x00FF0000,0xFF000000,
+      8, NULL, Blit_RGB565_BGRA8888NEON, NO_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 2, 0x00007C00,0x000003E0,0x0000001F,
+      8, NULL, Blit_RGB565_RGB555NEON, NO_ALPHA },
+    { 0x00007C00,0x000003E0,0x0000001F, 2, 0x0000F800,0x000007E0,0x0000001F,
+      8, NULL, Blit_RGB555_RGB565NEON, NO_ALPHA },
+#endif
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      0, NULL, Blit_RGB565_ARGB8888, SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      0, NULL, Blit_RGB565_ABGR8888, SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0xFF000000,0x00FF0000,0x0000FF00,
+      0, NULL, Blit_RGB565_RGBA8888, SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x0000FF00,0x00FF0000,0xFF000000,
+      0, NULL, Blit_RGB565_BGRA8888, SET_ALPHA },
+#if SDL_SSE2_BLITTERS
+    /* has-SSE2, only used for 8-bit channels (see SDL_CalculateBlitN) */
+    { 0x00000000,0x00000000,0x00000000, 4, 0x00000000,0x00000000,0x00000000,
+      16, NULL, Blit16to32SSE2, NO_ALPHA | SET_ALPHA },
+#endif
+#if SDL_ARM_NEON_BLITTERS
+    /* has-NEON */
+    { 0x0000F800,0x000007E0,0x0000001F, 3, 0x00000000,0x00000000,0x00000000,
+      8, NULL, Blit_RGB565_24NEON, NO_ALPHA },
+    { 0x00007C00,0x000003E0,0x0000001F, 3, 0x00000000,0x00000000,0x00000000,
+      8, NULL, Blit_RGB555_24NEON, NO_ALPHA },
+#endif
+#if SDL_AVX2_BLITTERS
+    /* has-AVX2 */
+    { 0x00000000,0x00000000,0x00000000, 3, 0x00000000,0x00000000,0x00000000,
+      32, NULL, Blit16to24AVX2, NO_ALPHA },
+#endif
+    { 0x00000000,0x00000000,0x00000000, 3, 0x00000000,0x00000000,0x00000000,
+      0, NULL, Blit16to24, NO_ALPHA },
+
+    /* Default for 16-bit RGB source, used if no other blitter matches */
+    { 0,0,0, 0, 0,0,0, 0, NULL, BlitNtoN, 0 }
+};
+static const struct blit_table normal_blit_3[] = {
+#if SDL_ARM_NEON_BLITTERS
+    /* has-NEON, only used for 8-bit channels (see SDL_CalculateBlitN) */
+    { 0x00000000,0x00000000,0x00000000, 4, 0x00000000,0x00000000,0x00000000,
+      8, NULL, Blit24to32NEON, NO_ALPHA | SET_ALPHA },
+    { 0x00000000,0x00000000,0x00000000, 3, 0x00000000,0x00000000,0x00000000,
+      8, NULL, Blit24to24NEON, NO_ALPHA },
+    { 0x00000000,0x00000000,0x00000000, 2, 0x0000F800,0x000007E0,0x0000001F,
+      8, NULL, Blit24_RGB565NEON, NO_ALPHA },
+    { 0x00000000,0x00000000,0x00000000, 2, 0x00007C00,0x000003E0,0x0000001F,
+      8, NULL, Blit24_RGB555NEON, NO_ALPHA },
+#endif
+#if SDL_AVX2_BLITTERS
+    /* has-AVX2, only used for 8-bit channels (see SDL_CalculateBlitN) */
+    { 0x00000000,0x00000000,0x00000000, 4, 0x00000000,0x00000000,0x00000000,
+      32, NULL, Blit24to32AVX2, NO_ALPHA | SET_ALPHA },
+    { 0x00000000,0x00000000,0x00000000, 3, 0x00000000,0x00000000,0x00000000,
+      32, NULL, Blit24to24AVX2, NO_ALPHA },
+    { 0x00000000,0x00000000,0x00000000, 2, 0x00000000,0x00000000,0x00000000,
+      32, NULL, Blit24to16AVX2, NO_ALPHA | SET_ALPHA },
+#endif
+    { 0x00000000,0x00000000,0x00000000, 4, 0x00000000,0x00000000,0x00000000,
+      0, NULL, Blit24to32, NO_ALPHA | SET_ALPHA },
+    { 0x00000000,0x00000000,0x00000000, 3, 0x00000000,0x00000000,0x00000000,
+      0, NULL, Blit24to24, NO_ALPHA },
+    { 0x00000000,0x00000000,0x00000000, 2, 0x00000000,0x00000000,0x00000000,
+      0, NULL, Blit24to16, NO_ALPHA | SET_ALPHA },
+
+	/* Default for 24-bit RGB source, used if no other blitter matches */
+    { 0,0,0, 0, 0,0,0, 0, NULL, BlitNtoN, 0 }
+};
+static const struct blit_table normal_blit_4[] = {
+#if SDL_HERMES_BLITTERS
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000F800,0x000007E0,0x0000001F,
+      1, ConvertMMXpII32_16RGB565, ConvertMMX, NO_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000F800,0x000007E0,0x0000001F,
+      0, ConvertX86p32_16RGB565, ConvertX86, NO_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000001F,0x000007E0,0x0000F800,
+      1, ConvertMMXpII32_16BGR565, ConvertMMX, NO_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000001F,0x000007E0,0x0000F800,
+      0, ConvertX86p32_16BGR565, ConvertX86, NO_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x00007C00,0x000003E0,0x0000001F,
+      1, ConvertMMXpII32_16RGB555, ConvertMMX, NO_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x00007C00,0x000003E0,0x0000001F,
+      0, ConvertX86p32_16RGB555, ConvertX86, NO_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000001F,0x000003E0,0x00007C00,
+      1, ConvertMMXpII32_16BGR555, ConvertMMX, NO_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000001F,0x000003E0,0x00007C00,
+      0, ConvertX86p32_16BGR555, ConvertX86, NO_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 3, 0x00FF0000,0x0000FF00,0x000000FF,
+      1, ConvertMMXpII32_24RGB888, ConvertMMX, NO_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 3, 0x00FF0000,0x0000FF00,0x000000FF,
+      0, ConvertX86p32_24RGB888, ConvertX86, NO_ALPHA },
     { 0x00FF0000,0x0000FF00,0x000000FF, 3, 0x000000FF,0x0000FF00,0x00FF0000,
       0, ConvertX86p32_24BGR888, ConvertX86, NO_ALPHA },
     { 0x00FF0000,0x0000FF00,0x000000FF, 4, 0x000000FF,0x0000FF00,0x00FF0000,
@@ -2355,12 +3810,45 @@ static const struct blit_table normal_blit_4[] = {
     /* has-altivec */
     { 0x00000000,0x00000000,0x00000000, 2, 0x0000F800,0x000007E0,0x0000001F,
       2, NULL, Blit_RGB888_RGB565Altivec, NO_ALPHA },
+#endif
+#if SDL_ARM_NEON_BLITTERS
+    /* has-NEON */
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000F800,0x000007E0,0x0000001F,
+      8, NULL, Blit_RGB888_RGB565NEON, NO_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 2, 0x0000F800,0x000007E0,0x0000001F,
+      8, NULL, Blit_BGR888_RGB565NEON, NO_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x00007C00,0x000003E0,0x0000001F,
+      8, NULL, Blit_RGB888_RGB555NEON, NO_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 2, 0x00007C00,0x000003E0,0x0000001F,
+      8, NULL, Blit_BGR888_RGB555NEON, NO_ALPHA },
+    /* has-NEON, only used for 8-bit channels (see SDL_CalculateBlitN) */
+    { 0x00000000,0x00000000,0x00000000, 4, 0x00000000,0x00000000,0x00000000,
+      8, NULL, ConvertNEON32to32, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+#endif
+#if SDL_SSE2_BLITTERS
+    /* has-SSE2, only used for 8-bit channels (see SDL_CalculateBlitN) */
+    { 0x00000000,0x00000000,0x00000000, 2, 0x00000000,0x00000000,0x00000000,
+      16, NULL, Blit32to16SSE2, NO_ALPHA },
+    { 0x00000000,0x00000000,0x00000000, 4, 0x00000000,0x00000000,0x00000000,
+      16, NULL, Blit32to32SSE2, NO_ALPHA | COPY_ALPHA | SET_ALPHA },
 #endif
     { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000F800,0x000007E0,0x0000001F,
       0, NULL, Blit_RGB888_RGB565, NO_ALPHA },
     { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x00007C00,0x000003E0,0x0000001F,
       0, NULL, Blit_RGB888_RGB555, NO_ALPHA },
 #endif
+#if SDL_ARM_NEON_BLITTERS
+    /* has-NEON, only used for 8-bit channels (see SDL_CalculateBlitN) */
+    { 0x00000000,0x00000000,0x00000000, 3, 0x00000000,0x00000000,0x00000000,
+      8, NULL, Blit32to24NEON, NO_ALPHA },
+#endif
+#if SDL_AVX2_BLITTERS
+    /* has-AVX2, only used for 8-bit channels (see SDL_CalculateBlitN) */
+    { 0x00000000,0x00000000,0x00000000, 3, 0x00000000,0x00000000,0x00000000,
+      32, NULL, Blit32to24AVX2, NO_ALPHA },
+#endif
+    { 0x00000000,0x00000000,0x00000000, 3, 0x00000000,0x00000000,0x00000000,
+      0, NULL, Blit32to24, NO_ALPHA },
 	/* Default for 32-bit RGB source, used if no other blitter matches */
 	{ 0,0,0, 0, 0,0,0, 0, NULL, BlitNtoN, 0 }
 };
@@ -2371,6 +3859,224 @@ static const struct blit_table *normal_blit[] = {
 /* Mask matches table, or table entry is zero */
 #define MASKOK(x, y) (((x) == (y)) || ((y) == 0x00000000))
 
+#if SDL_ARM_NEON_BLITTERS || SDL_SSE2_BLITTERS || SDL_AVX2_BLITTERS
+/* Returns true if every channel of a 32-bit format is a whole byte */
+static int Is8888(const SDL_PixelFormat *fmt)
+{
+	return ( fmt->BytesPerPixel == 4 &&
+	         fmt->Rmask == (0xFFu << fmt->Rshift) && !(fmt->Rshift & 7) &&
+	         fmt->Gmask == (0xFFu << fmt->Gshift) && !(fmt->Gshift & 7) &&
+	         fmt->Bmask == (0xFFu << fmt->Bshift) && !(fmt->Bshift & 7) &&
+	         (!fmt->Amask ||
+	          (fmt->Amask == (0xFFu << fmt->Ashift) && !(fmt->Ashift & 7))) );
+}
+#endif
+
+/* Returns true if every channel of a 24-bit format is a whole byte */
+static int Is888(const SDL_PixelFormat *fmt)
+{
+	return ( fmt->BytesPerPixel == 3 && !fmt->Amask &&
+	         fmt->Rmask == (0xFFu << fmt->Rshift) && !(fmt->Rshift & 7) &&
+	         fmt->Gmask == (0xFFu << fmt->Gshift) && !(fmt->Gshift & 7) &&
+	         fmt->Bmask == (0xFFu << fmt->Bshift) && !(fmt->Bshift & 7) );
+}
+
+/* The entries with zero masks only handle byte-sized channels */
+static int BlitFormatsOK(SDL_loblit blitfunc,
+                         SDL_PixelFormat *srcfmt, SDL_PixelFormat *dstfmt)
+{
+#if SDL_ARM_NEON_BLITTERS
+	if ( blitfunc == ConvertNEON32to32 ) {
+		return (Is8888(srcfmt) && Is8888(dstfmt));
+	}
+	if ( blitfunc == Blit24to32NEON ) {
+		return (Is888(srcfmt) && Is8888(dstfmt));
+	}
+	if ( blitfunc == Blit32to24NEON ) {
+		return (Is8888(srcfmt) && Is888(dstfmt));
+	}
+#endif
+#if SDL_AVX2_BLITTERS
+	if ( blitfunc == Blit24to32AVX2 ) {
+		return (Is888(srcfmt) && Is8888(dstfmt));
+	}
+	if ( blitfunc == Blit32to24AVX2 ) {
+		return (Is8888(srcfmt) && Is888(dstfmt));
+	}
+#endif
+#if SDL_SSE2_BLITTERS
+	if ( blitfunc == Blit32to16SSE2 ) {
+		return Is8888(srcfmt);
+	}
+	if ( blitfunc == Blit16to32SSE2 ) {
+		return Is8888(dstfmt);
+	}
+	if ( blitfunc == Blit32to32SSE2 ) {
+		/* Matching RGB layouts are left to Blit4to4MaskAlpha */
+		return (Is8888(srcfmt) && Is8888(dstfmt) &&
+		        (srcfmt->Rmask != dstfmt->Rmask ||
+		         srcfmt->Gmask != dstfmt->Gmask ||
+		         srcfmt->Bmask != dstfmt->Bmask));
+	}
+#endif
+	/* The other 24-bit conversions work on any 16 or 32-bit layout */
+	if ( blitfunc != BlitNtoN ) {
+		if ( srcfmt->BytesPerPixel == 3 && !Is888(srcfmt) ) {
+			return 0;
+		}
+		if ( dstfmt->BytesPerPixel == 3 && !Is888(dstfmt) ) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+#if SDL_ARM_NEON_BLITTERS || SDL_SSE2_BLITTERS
+/* SIMD colorkey blits, for same format 16 and 32-bit surfaces and for
+   8888 to 16-bit RGB without alpha, or NULL if there is none */
+static SDL_loblit CalculateKeyBlitSIMD(SDL_Surface *surface)
+{
+	SDL_PixelFormat *srcfmt = surface->format;
+	SDL_PixelFormat *dstfmt = surface->map->dst->format;
+	Uint32 features = GetBlitFeatures();
+	int identity = surface->map->identity;
+	int to16 = (!identity && Is8888(srcfmt) &&
+	            dstfmt->BytesPerPixel == 2 && !dstfmt->Amask);
+
+	/* BlitNtoNKey truncates channels wider than 8 bits */
+	if ( identity && srcfmt->BytesPerPixel == 4 && !Is8888(srcfmt) ) {
+		return NULL;
+	}
+
+#if SDL_SSE2_BLITTERS
+	if ( features & 16 ) {
+		if ( identity && srcfmt->BytesPerPixel == 2 ) {
+			return Blit2to2KeySSE2;
+		}
+		if ( identity && srcfmt->BytesPerPixel == 4 ) {
+			return Blit4to4KeySSE2;
+		}
+		if ( to16 ) {
+			return Blit32to16KeySSE2;
+		}
+	}
+#endif
+#if SDL_ARM_NEON_BLITTERS
+	if ( features & 8 ) {
+		if ( identity && srcfmt->BytesPerPixel == 2 ) {
+			return Blit2to2KeyNEON;
+		}
+		if ( identity && srcfmt->BytesPerPixel == 4 ) {
+			return Blit4to4KeyNEON;
+		}
+		if ( to16 && dstfmt->Bmask == 0x001F &&
+		     ((dstfmt->Rmask == 0xF800 && dstfmt->Gmask == 0x07E0) ||
+		      (dstfmt->Rmask == 0x7C00 && dstfmt->Gmask == 0x03E0)) ) {
+			return Blit32to16KeyNEON;
+		}
+	}
+#endif
+	return NULL;
+}
+#endif
+
+/* Returns true if the blitter is one of the SIMD colorkey kernels, which
+   SDL_CalculateBlit() may prefer over RLE acceleration */
+int SDL_IsKeyBlitSIMD(SDL_loblit blit)
+{
+#if SDL_SSE2_BLITTERS
+	if ( blit == Blit2to2KeySSE2 || blit == Blit4to4KeySSE2 ||
+	     blit == Blit32to16KeySSE2 ) {
+		return 1;
+	}
+#endif
+#if SDL_ARM_NEON_BLITTERS
+	if ( blit == Blit2to2KeyNEON || blit == Blit4to4KeyNEON ||
+	     blit == Blit32to16KeyNEON ) {
+		return 1;
+	}
+#endif
+	return 0;
+}
+
+const SDL_BlitterName SDL_BlitterNamesN[] = {
+#if SDL_ALTIVEC_BLITTERS
+	SDL_BLITTER_NAME(Blit_RGB888_RGB565Altivec),
+	SDL_BLITTER_NAME(Blit_RGB565_32Altivec),
+	SDL_BLITTER_NAME(Blit_RGB555_32Altivec),
+	SDL_BLITTER_NAME(Blit32to32KeyAltivec),
+	SDL_BLITTER_NAME(ConvertAltivec32to32_noprefetch),
+	SDL_BLITTER_NAME(ConvertAltivec32to32_prefetch),
+#endif
+#if SDL_ARM_NEON_BLITTERS
+	SDL_BLITTER_NAME(Blit_RGB888_RGB565NEON),
+	SDL_BLITTER_NAME(Blit_BGR888_RGB565NEON),
+	SDL_BLITTER_NAME(Blit_RGB888_RGB555NEON),
+	SDL_BLITTER_NAME(Blit_BGR888_RGB555NEON),
+	SDL_BLITTER_NAME(Blit_RGB565_ARGB8888NEON),
+	SDL_BLITTER_NAME(Blit_RGB565_ABGR8888NEON),
+	SDL_BLITTER_NAME(Blit_RGB565_RGBA8888NEON),
+	SDL_BLITTER_NAME(Blit_RGB565_BGRA8888NEON),
+	SDL_BLITTER_NAME(Blit_RGB555_RGB565NEON),
+	SDL_BLITTER_NAME(Blit_RGB565_RGB555NEON),
+	SDL_BLITTER_NAME(ConvertNEON32to32),
+	SDL_BLITTER_NAME(Blit24to32NEON),
+	SDL_BLITTER_NAME(Blit32to24NEON),
+	SDL_BLITTER_NAME(Blit24to24NEON),
+	SDL_BLITTER_NAME(Blit24_RGB565NEON),
+	SDL_BLITTER_NAME(Blit24_RGB555NEON),
+	SDL_BLITTER_NAME(Blit_RGB565_24NEON),
+	SDL_BLITTER_NAME(Blit_RGB555_24NEON),
+	SDL_BLITTER_NAME(Blit32to16KeyNEON),
+	SDL_BLITTER_NAME(Blit2to2KeyNEON),
+	SDL_BLITTER_NAME(Blit4to4KeyNEON),
+#endif
+#if SDL_SSE2_BLITTERS
+	SDL_BLITTER_NAME(Blit32to16SSE2),
+	SDL_BLITTER_NAME(Blit16to32SSE2),
+	SDL_BLITTER_NAME(Blit32to32SSE2),
+	SDL_BLITTER_NAME(Blit32to16KeySSE2),
+	SDL_BLITTER_NAME(Blit2to2KeySSE2),
+	SDL_BLITTER_NAME(Blit4to4KeySSE2),
+#endif
+#if SDL_AVX2_BLITTERS
+	SDL_BLITTER_NAME(Blit24to32AVX2),
+	SDL_BLITTER_NAME(Blit32to24AVX2),
+	SDL_BLITTER_NAME(Blit24to24AVX2),
+	SDL_BLITTER_NAME(Blit24to16AVX2),
+	SDL_BLITTER_NAME(Blit16to24AVX2),
+#endif
+#if SDL_HERMES_BLITTERS
+	SDL_BLITTER_NAME(ConvertMMX),
+	SDL_BLITTER_NAME(ConvertX86),
+#else
+	SDL_BLITTER_NAME(Blit_RGB888_index8),
+	SDL_BLITTER_NAME(Blit_RGB888_RGB555),
+	SDL_BLITTER_NAME(Blit_RGB888_RGB565),
+#endif
+	SDL_BLITTER_NAME(Blit_RGB565_ARGB8888),
+	SDL_BLITTER_NAME(Blit_RGB565_ABGR8888),
+	SDL_BLITTER_NAME(Blit_RGB565_RGBA8888),
+	SDL_BLITTER_NAME(Blit_RGB565_BGRA8888),
+	SDL_BLITTER_NAME(Blit_RGB888_index8_map),
+	SDL_BLITTER_NAME(BlitNto1),
+	SDL_BLITTER_NAME(Blit4to4MaskAlpha),
+	SDL_BLITTER_NAME(Blit24to16),
+	SDL_BLITTER_NAME(Blit24to32),
+	SDL_BLITTER_NAME(Blit16to24),
+	SDL_BLITTER_NAME(Blit32to24),
+	SDL_BLITTER_NAME(Blit24to24),
+	SDL_BLITTER_NAME(BlitNtoN),
+	SDL_BLITTER_NAME(BlitNtoNCopyAlpha),
+	SDL_BLITTER_NAME(BlitNto1Key),
+	SDL_BLITTER_NAME(BlitNto1Dither),
+	SDL_BLITTER_NAME(BlitNto1DitherKey),
+	SDL_BLITTER_NAME(Blit2to2Key),
+	SDL_BLITTER_NAME(BlitNtoNKey),
+	SDL_BLITTER_NAME(BlitNtoNKeyCopyAlpha),
+	{ NULL, NULL }
+};
+
 SDL_loblit SDL_CalculateBlitN(SDL_Surface *surface, int blit_index)
 {
 	struct private_swaccel *sdata;
@@ -2394,12 +4100,24 @@ SDL_loblit SDL_CalculateBlitN(SDL_Surface *surface, int blit_index)
 	if ( dstfmt->BitsPerPixel < 8 ) {
 		return(NULL);
 	}
+
+	if ( palette_dither < 0 ) {
+		InitPaletteDither();
+	}
+	if ( palette_dither && dstfmt->BytesPerPixel == 1 &&
+	     surface->map->table ) {
+		return (blit_index == 1) ? BlitNto1DitherKey : BlitNto1Dither;
+	}
 	
 	if(blit_index == 1) {
-	    /* colorkey blit: Here we don't have too many options, mostly
-	       because RLE is the preferred fast way to deal with this.
-	       If a particular case turns out to be useful we'll add it. */
+	    /* colorkey blit: RLE is usually the fast way to deal with this,
+	       but the SIMD kernels win for small or often changed surfaces
+	       (see SDL_CalculateBlit) and for blits RLE doesn't handle. */
 
+#if SDL_ARM_NEON_BLITTERS || SDL_SSE2_BLITTERS
+	    if((blitfun = CalculateKeyBlitSIMD(surface)) != NULL)
+		return blitfun;
+#endif
 	    if(srcfmt->BytesPerPixel == 2
 	       && surface->map->identity)
 		return Blit2to2Key;
@@ -2411,8 +4129,10 @@ SDL_loblit SDL_CalculateBlitN(SDL_Surface *surface, int blit_index)
             return Blit32to32KeyAltivec;
         } else
 #endif
-
-		if(srcfmt->Amask && dstfmt->Amask)
+		if((blitfun = SDL_CalculateBlitAuto(srcfmt, dstfmt,
+		                                    SDL_BLIT_AUTO_KEY)) != NULL)
+		    return blitfun;
+		else if(srcfmt->Amask && dstfmt->Amask)
 		    return BlitNtoNKeyCopyAlpha;
 		else
 		    return BlitNtoNKey;
@@ -2454,7 +4174,8 @@ SDL_loblit SDL_CalculateBlitN(SDL_Surface *surface, int blit_index)
 			    MASKOK(dstfmt->Bmask, table[which].dstB) &&
 			    dstfmt->BytesPerPixel == table[which].dstbpp &&
 			    (a_need & table[which].alpha) == a_need &&
-			    ((table[which].blit_features & GetBlitFeatures()) == table[which].blit_features) )
+			    ((table[which].blit_features & GetBlitFeatures()) == table[which].blit_features) &&
+			    BlitFormatsOK(table[which].blitfunc, srcfmt, dstfmt) )
 				break;
 		}
 		sdata->aux_data = table[which].aux_data;
@@ -2467,8 +4188,15 @@ SDL_loblit SDL_CalculateBlitN(SDL_Surface *surface, int blit_index)
 			     srcfmt->Gmask == dstfmt->Gmask &&
 			     srcfmt->Bmask == dstfmt->Bmask ) {
 				blitfun = Blit4to4MaskAlpha;
-			} else if ( a_need == COPY_ALPHA ) {
-			    blitfun = BlitNtoNCopyAlpha;
+			} else {
+				/* Generated kernel for the format pair, if any */
+				SDL_loblit autoblit = SDL_CalculateBlitAuto(
+					srcfmt, dstfmt, SDL_BLIT_AUTO_COPY);
+				if ( autoblit ) {
+					blitfun = autoblit;
+				} else if ( a_need == COPY_ALPHA ) {
+					blitfun = BlitNtoNCopyAlpha;
+				}
 			}
 		}
 	}
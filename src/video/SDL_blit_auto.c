@@ -0,0 +1,418 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+#include "SDL_video.h"
+#include "SDL_blit.h"
+
+/*
+ * Specialized versions of the generic BlitNtoN, BlitNtoNCopyAlpha,
+ * BlitNtoNKey, BlitNtoNKeyCopyAlpha, BlitNtoNSurfaceAlpha,
+ * BlitNtoNSurfaceAlphaKey and BlitNtoNPixelAlpha blitters, generated
+ * below by the preprocessor for every pair of the common 16 and 32-bit
+ * formats.  The masks, shifts and losses are constants here, so each
+ * pixel is converted with a handful of immediate operations instead of
+ * loading them from the SDL_PixelFormat, and the simple loops are left
+ * for the compiler to unroll or vectorize.  The arithmetic is exactly
+ * that of the generic blitters, so the results are identical.
+ */
+
+/* The formats, with the names testblitmatrix uses for them */
+#define AUTO_RGB555_TYPE	Uint16
+#define AUTO_RGB555_RMASK	0x7C00
+#define AUTO_RGB555_RSHIFT	10
+#define AUTO_RGB555_RLOSS	3
+#define AUTO_RGB555_GMASK	0x03E0
+#define AUTO_RGB555_GSHIFT	5
+#define AUTO_RGB555_GLOSS	3
+#define AUTO_RGB555_BMASK	0x001F
+#define AUTO_RGB555_BSHIFT	0
+#define AUTO_RGB555_BLOSS	3
+#define AUTO_RGB555_AMASK	0
+#define AUTO_RGB555_ASHIFT	0
+#define AUTO_RGB555_ALOSS	8
+
+#define AUTO_RGB565_TYPE	Uint16
+#define AUTO_RGB565_RMASK	0xF800
+#define AUTO_RGB565_RSHIFT	11
+#define AUTO_RGB565_RLOSS	3
+#define AUTO_RGB565_GMASK	0x07E0
+#define AUTO_RGB565_GSHIFT	5
+#define AUTO_RGB565_GLOSS	2
+#define AUTO_RGB565_BMASK	0x001F
+#define AUTO_RGB565_BSHIFT	0
+#define AUTO_RGB565_BLOSS	3
+#define AUTO_RGB565_AMASK	0
+#define AUTO_RGB565_ASHIFT	0
+#define AUTO_RGB565_ALOSS	8
+
+#define AUTO_XRGB8888_TYPE	Uint32
+#define AUTO_XRGB8888_RMASK	0x00FF0000
+#define AUTO_XRGB8888_RSHIFT	16
+#define AUTO_XRGB8888_RLOSS	0
+#define AUTO_XRGB8888_GMASK	0x0000FF00
+#define AUTO_XRGB8888_GSHIFT	8
+#define AUTO_XRGB8888_GLOSS	0
+#define AUTO_XRGB8888_BMASK	0x000000FF
+#define AUTO_XRGB8888_BSHIFT	0
+#define AUTO_XRGB8888_BLOSS	0
+#define AUTO_XRGB8888_AMASK	0
+#define AUTO_XRGB8888_ASHIFT	0
+#define AUTO_XRGB8888_ALOSS	8
+
+#define AUTO_XBGR8888_TYPE	Uint32
+#define AUTO_XBGR8888_RMASK	0x000000FF
+#define AUTO_XBGR8888_RSHIFT	0
+#define AUTO_XBGR8888_RLOSS	0
+#define AUTO_XBGR8888_GMASK	0x0000FF00
+#define AUTO_XBGR8888_GSHIFT	8
+#define AUTO_XBGR8888_GLOSS	0
+#define AUTO_XBGR8888_BMASK	0x00FF0000
+#define AUTO_XBGR8888_BSHIFT	16
+#define AUTO_XBGR8888_BLOSS	0
+#define AUTO_XBGR8888_AMASK	0
+#define AUTO_XBGR8888_ASHIFT	0
+#define AUTO_XBGR8888_ALOSS	8
+
+#define AUTO_ARGB8888_TYPE	Uint32
+#define AUTO_ARGB8888_RMASK	0x00FF0000
+#define AUTO_ARGB8888_RSHIFT	16
+#define AUTO_ARGB8888_RLOSS	0
+#define AUTO_ARGB8888_GMASK	0x0000FF00
+#define AUTO_ARGB8888_GSHIFT	8
+#define AUTO_ARGB8888_GLOSS	0
+#define AUTO_ARGB8888_BMASK	0x000000FF
+#define AUTO_ARGB8888_BSHIFT	0
+#define AUTO_ARGB8888_BLOSS	0
+#define AUTO_ARGB8888_AMASK	0xFF000000
+#define AUTO_ARGB8888_ASHIFT	24
+#define AUTO_ARGB8888_ALOSS	0
+
+#define AUTO_ABGR8888_TYPE	Uint32
+#define AUTO_ABGR8888_RMASK	0x000000FF
+#define AUTO_ABGR8888_RSHIFT	0
+#define AUTO_ABGR8888_RLOSS	0
+#define AUTO_ABGR8888_GMASK	0x0000FF00
+#define AUTO_ABGR8888_GSHIFT	8
+#define AUTO_ABGR8888_GLOSS	0
+#define AUTO_ABGR8888_BMASK	0x00FF0000
+#define AUTO_ABGR8888_BSHIFT	16
+#define AUTO_ABGR8888_BLOSS	0
+#define AUTO_ABGR8888_AMASK	0xFF000000
+#define AUTO_ABGR8888_ASHIFT	24
+#define AUTO_ABGR8888_ALOSS	0
+
+#define AUTO_RGBA8888_TYPE	Uint32
+#define AUTO_RGBA8888_RMASK	0xFF000000
+#define AUTO_RGBA8888_RSHIFT	24
+#define AUTO_RGBA8888_RLOSS	0
+#define AUTO_RGBA8888_GMASK	0x00FF0000
+#define AUTO_RGBA8888_GSHIFT	16
+#define AUTO_RGBA8888_GLOSS	0
+#define AUTO_RGBA8888_BMASK	0x0000FF00
+#define AUTO_RGBA8888_BSHIFT	8
+#define AUTO_RGBA8888_BLOSS	0
+#define AUTO_RGBA8888_AMASK	0x000000FF
+#define AUTO_RGBA8888_ASHIFT	0
+#define AUTO_RGBA8888_ALOSS	0
+
+#define AUTO_BGRA8888_TYPE	Uint32
+#define AUTO_BGRA8888_RMASK	0x0000FF00
+#define AUTO_BGRA8888_RSHIFT	8
+#define AUTO_BGRA8888_RLOSS	0
+#define AUTO_BGRA8888_GMASK	0x00FF0000
+#define AUTO_BGRA8888_GSHIFT	16
+#define AUTO_BGRA8888_GLOSS	0
+#define AUTO_BGRA8888_BMASK	0xFF000000
+#define AUTO_BGRA8888_BSHIFT	24
+#define AUTO_BGRA8888_BLOSS	0
+#define AUTO_BGRA8888_AMASK	0x000000FF
+#define AUTO_BGRA8888_ASHIFT	0
+#define AUTO_BGRA8888_ALOSS	0
+
+/* Call X(S, D, ...) with every format as D.  The sources are listed
+   separately, since a macro can't expand itself.  The order of these
+   lists is the order of auto_formats[] and auto_blits[] below. */
+#define AUTO_FOR_EACH_DST(X, S)						\
+	X(S, RGB555) X(S, RGB565) X(S, XRGB8888) X(S, XBGR8888)		\
+	X(S, ARGB8888) X(S, ABGR8888) X(S, RGBA8888) X(S, BGRA8888)
+#define AUTO_FOR_EACH_OPAQUE_SRC(X)					\
+	X(RGB555) X(RGB565) X(XRGB8888) X(XBGR8888)
+#define AUTO_FOR_EACH_ALPHA_SRC(X)					\
+	X(ARGB8888) X(ABGR8888) X(RGBA8888) X(BGRA8888)
+
+/* The same operations as RGB_FROM_PIXEL, RGBA_FROM_PIXEL and
+   PIXEL_FROM_RGBA */
+#define AUTO_RGB_FROM_PIXEL(F, Pixel, r, g, b)				\
+{									\
+	r = ((Pixel&AUTO_##F##_RMASK)>>AUTO_##F##_RSHIFT)<<AUTO_##F##_RLOSS; \
+	g = ((Pixel&AUTO_##F##_GMASK)>>AUTO_##F##_GSHIFT)<<AUTO_##F##_GLOSS; \
+	b = ((Pixel&AUTO_##F##_BMASK)>>AUTO_##F##_BSHIFT)<<AUTO_##F##_BLOSS; \
+}
+#define AUTO_RGBA_FROM_PIXEL(F, Pixel, r, g, b, a)			\
+{									\
+	AUTO_RGB_FROM_PIXEL(F, Pixel, r, g, b);				\
+	a = ((Pixel&AUTO_##F##_AMASK)>>AUTO_##F##_ASHIFT)<<AUTO_##F##_ALOSS; \
+}
+#ifdef __NDS__ /* FIXME */
+#define AUTO_NDS_BIT	(1<<15)
+#else
+#define AUTO_NDS_BIT	0
+#endif
+#define AUTO_PIXEL_FROM_RGBA(F, r, g, b, a)				\
+	(AUTO_##F##_TYPE)(((r>>AUTO_##F##_RLOSS)<<AUTO_##F##_RSHIFT)|	\
+	                  ((g>>AUTO_##F##_GLOSS)<<AUTO_##F##_GSHIFT)|	\
+	                  ((b>>AUTO_##F##_BLOSS)<<AUTO_##F##_BSHIFT)|	\
+	                  ((a>>AUTO_##F##_ALOSS)<<AUTO_##F##_ASHIFT)|	\
+	                  AUTO_NDS_BIT)
+
+/* Alpha is copied only when both formats have it, like BlitNtoNCopyAlpha */
+#define AUTO_COPY_ALPHA(S, D)	(AUTO_##S##_AMASK && AUTO_##D##_AMASK)
+
+#define AUTO_BLIT_SETUP(S, D)						\
+	int width = info->d_width;					\
+	int height = info->d_height;					\
+	const AUTO_##S##_TYPE *src = (const AUTO_##S##_TYPE *)info->s_pixels; \
+	int srcskip = info->s_skip;					\
+	AUTO_##D##_TYPE *dst = (AUTO_##D##_TYPE *)info->d_pixels;	\
+	int dstskip = info->d_skip;					\
+	int n;
+
+#define AUTO_NEXT_ROW()							\
+	src = (const void *)((const Uint8 *)(src + width) + srcskip);	\
+	dst = (void *)((Uint8 *)(dst + width) + dstskip);
+
+/* BlitNtoN and BlitNtoNCopyAlpha */
+#define AUTO_BLIT_COPY(S, D)						\
+static void Blit_##S##_to_##D(SDL_BlitInfo *info)			\
+{									\
+	AUTO_BLIT_SETUP(S, D)						\
+	unsigned alpha = AUTO_##D##_AMASK ? info->src->alpha : 0;	\
+									\
+	while ( height-- ) {						\
+		for ( n = 0; n < width; ++n ) {				\
+			Uint32 Pixel = src[n];				\
+			unsigned sR, sG, sB, sA;			\
+			AUTO_RGBA_FROM_PIXEL(S, Pixel, sR, sG, sB, sA);	\
+			if ( !AUTO_COPY_ALPHA(S, D) ) {			\
+				sA = alpha;				\
+			}						\
+			dst[n] = AUTO_PIXEL_FROM_RGBA(D, sR, sG, sB, sA); \
+		}							\
+		AUTO_NEXT_ROW()						\
+	}								\
+}
+
+/* BlitNtoNKey and BlitNtoNKeyCopyAlpha */
+#define AUTO_BLIT_KEY(S, D)						\
+static void Blit_##S##_to_##D##_Key(SDL_BlitInfo *info)			\
+{									\
+	AUTO_BLIT_SETUP(S, D)						\
+	Uint32 rgbmask = ~(Uint32)AUTO_##S##_AMASK;			\
+	Uint32 ckey = info->src->colorkey & rgbmask;			\
+	unsigned alpha = AUTO_##D##_AMASK ? info->src->alpha : 0;	\
+									\
+	while ( height-- ) {						\
+		for ( n = 0; n < width; ++n ) {				\
+			Uint32 Pixel = src[n];				\
+			unsigned sR, sG, sB, sA;			\
+			if ( (Pixel & rgbmask) == ckey ) {		\
+				continue;				\
+			}						\
+			AUTO_RGBA_FROM_PIXEL(S, Pixel, sR, sG, sB, sA);	\
+			if ( !AUTO_COPY_ALPHA(S, D) ) {			\
+				sA = alpha;				\
+			}						\
+			dst[n] = AUTO_PIXEL_FROM_RGBA(D, sR, sG, sB, sA); \
+		}							\
+		AUTO_NEXT_ROW()						\
+	}								\
+}
+
+/* BlitNtoNSurfaceAlpha */
+#define AUTO_BLIT_ALPHA(S, D)						\
+static void Blit_##S##_to_##D##_Alpha(SDL_BlitInfo *info)		\
+{									\
+	AUTO_BLIT_SETUP(S, D)						\
+	unsigned sA = info->src->alpha;					\
+	unsigned dA = AUTO_##D##_AMASK ? SDL_ALPHA_OPAQUE : 0;		\
+									\
+	if ( !sA ) {							\
+		return;							\
+	}								\
+	while ( height-- ) {						\
+		for ( n = 0; n < width; ++n ) {				\
+			Uint32 Pixel = src[n];				\
+			unsigned sR, sG, sB, dR, dG, dB;		\
+			AUTO_RGB_FROM_PIXEL(S, Pixel, sR, sG, sB);	\
+			Pixel = dst[n];					\
+			AUTO_RGB_FROM_PIXEL(D, Pixel, dR, dG, dB);	\
+			ALPHA_BLEND(sR, sG, sB, sA, dR, dG, dB);	\
+			dst[n] = AUTO_PIXEL_FROM_RGBA(D, dR, dG, dB, dA); \
+		}							\
+		AUTO_NEXT_ROW()						\
+	}								\
+}
+
+/* BlitNtoNSurfaceAlphaKey */
+#define AUTO_BLIT_ALPHA_KEY(S, D)					\
+static void Blit_##S##_to_##D##_AlphaKey(SDL_BlitInfo *info)		\
+{									\
+	AUTO_BLIT_SETUP(S, D)						\
+	Uint32 ckey = info->src->colorkey;				\
+	unsigned sA = info->src->alpha;					\
+	unsigned dA = AUTO_##D##_AMASK ? SDL_ALPHA_OPAQUE : 0;		\
+									\
+	if ( !sA ) {							\
+		return;							\
+	}								\
+	while ( height-- ) {						\
+		for ( n = 0; n < width; ++n ) {				\
+			Uint32 Pixel = src[n];				\
+			unsigned sR, sG, sB, dR, dG, dB;		\
+			if ( Pixel == ckey ) {				\
+				continue;				\
+			}						\
+			AUTO_RGB_FROM_PIXEL(S, Pixel, sR, sG, sB);	\
+			Pixel = dst[n];					\
+			AUTO_RGB_FROM_PIXEL(D, Pixel, dR, dG, dB);	\
+			ALPHA_BLEND(sR, sG, sB, sA, dR, dG, dB);	\
+			dst[n] = AUTO_PIXEL_FROM_RGBA(D, dR, dG, dB, dA); \
+		}							\
+		AUTO_NEXT_ROW()						\
+	}								\
+}
+
+/* BlitNtoNPixelAlpha */
+#define AUTO_BLIT_PIXEL_ALPHA(S, D)					\
+static void Blit_##S##_to_##D##_PixelAlpha(SDL_BlitInfo *info)		\
+{									\
+	AUTO_BLIT_SETUP(S, D)						\
+									\
+	while ( height-- ) {						\
+		for ( n = 0; n < width; ++n ) {				\
+			Uint32 Pixel = src[n];				\
+			unsigned sR, sG, sB, sA, dR, dG, dB, dA;	\
+			AUTO_RGBA_FROM_PIXEL(S, Pixel, sR, sG, sB, sA);	\
+			if ( !sA ) {					\
+				continue;				\
+			}						\
+			Pixel = dst[n];					\
+			AUTO_RGBA_FROM_PIXEL(D, Pixel, dR, dG, dB, dA);	\
+			ALPHA_BLEND(sR, sG, sB, sA, dR, dG, dB);	\
+			dst[n] = AUTO_PIXEL_FROM_RGBA(D, dR, dG, dB, dA); \
+		}							\
+		AUTO_NEXT_ROW()						\
+	}								\
+}
+
+/* Opaque sources get surface alpha blitters, the others pixel alpha */
+#define AUTO_OPAQUE_BLITS(S, D)						\
+	AUTO_BLIT_COPY(S, D)						\
+	AUTO_BLIT_KEY(S, D)						\
+	AUTO_BLIT_ALPHA(S, D)						\
+	AUTO_BLIT_ALPHA_KEY(S, D)
+#define AUTO_ALPHA_BLITS(S, D)						\
+	AUTO_BLIT_COPY(S, D)						\
+	AUTO_BLIT_KEY(S, D)						\
+	AUTO_BLIT_PIXEL_ALPHA(S, D)
+#define AUTO_OPAQUE_SRC_BLITS(S)	AUTO_FOR_EACH_DST(AUTO_OPAQUE_BLITS, S)
+#define AUTO_ALPHA_SRC_BLITS(S)		AUTO_FOR_EACH_DST(AUTO_ALPHA_BLITS, S)
+
+AUTO_FOR_EACH_OPAQUE_SRC(AUTO_OPAQUE_SRC_BLITS)
+AUTO_FOR_EACH_ALPHA_SRC(AUTO_ALPHA_SRC_BLITS)
+
+/* The kernels of each pair, indexed by SDL_BLIT_AUTO_* */
+#define AUTO_OPAQUE_ENTRY(S, D)						\
+	{ Blit_##S##_to_##D, Blit_##S##_to_##D##_Key,			\
+	  Blit_##S##_to_##D##_Alpha, Blit_##S##_to_##D##_AlphaKey, NULL },
+#define AUTO_ALPHA_ENTRY(S, D)						\
+	{ Blit_##S##_to_##D, Blit_##S##_to_##D##_Key,			\
+	  NULL, NULL, Blit_##S##_to_##D##_PixelAlpha },
+#define AUTO_OPAQUE_ROW(S)	{ AUTO_FOR_EACH_DST(AUTO_OPAQUE_ENTRY, S) },
+#define AUTO_ALPHA_ROW(S)	{ AUTO_FOR_EACH_DST(AUTO_ALPHA_ENTRY, S) },
+
+#define AUTO_NUM_FORMATS	8
+
+static const SDL_loblit auto_blits[AUTO_NUM_FORMATS][AUTO_NUM_FORMATS][SDL_BLIT_AUTO_OPS] = {
+	AUTO_FOR_EACH_OPAQUE_SRC(AUTO_OPAQUE_ROW)
+	AUTO_FOR_EACH_ALPHA_SRC(AUTO_ALPHA_ROW)
+};
+
+#define AUTO_FORMAT(F)							\
+	{ sizeof(AUTO_##F##_TYPE), AUTO_##F##_RMASK, AUTO_##F##_GMASK,	\
+	  AUTO_##F##_BMASK, AUTO_##F##_AMASK },
+
+static const struct {
+	Uint8 bpp;
+	Uint32 Rmask, Gmask, Bmask, Amask;
+} auto_formats[AUTO_NUM_FORMATS] = {
+	AUTO_FOR_EACH_OPAQUE_SRC(AUTO_FORMAT)
+	AUTO_FOR_EACH_ALPHA_SRC(AUTO_FORMAT)
+};
+
+static int AutoFormatIndex(SDL_PixelFormat *fmt)
+{
+	int i;
+
+	for ( i = 0; i < AUTO_NUM_FORMATS; ++i ) {
+		if ( fmt->BytesPerPixel == auto_formats[i].bpp &&
+		     fmt->Rmask == auto_formats[i].Rmask &&
+		     fmt->Gmask == auto_formats[i].Gmask &&
+		     fmt->Bmask == auto_formats[i].Bmask &&
+		     fmt->Amask == auto_formats[i].Amask ) {
+			return(i);
+		}
+	}
+	return(-1);
+}
+
+SDL_loblit SDL_CalculateBlitAuto(SDL_PixelFormat *srcfmt,
+                                 SDL_PixelFormat *dstfmt, int op)
+{
+	int s, d;
+
+	s = AutoFormatIndex(srcfmt);
+	d = AutoFormatIndex(dstfmt);
+	if ( s < 0 || d < 0 ) {
+		return(NULL);
+	}
+	return(auto_blits[s][d][op]);
+}
+
+#define AUTO_OPAQUE_NAMES(S, D)						\
+	SDL_BLITTER_NAME(Blit_##S##_to_##D),				\
+	SDL_BLITTER_NAME(Blit_##S##_to_##D##_Key),			\
+	SDL_BLITTER_NAME(Blit_##S##_to_##D##_Alpha),			\
+	SDL_BLITTER_NAME(Blit_##S##_to_##D##_AlphaKey),
+#define AUTO_ALPHA_NAMES(S, D)						\
+	SDL_BLITTER_NAME(Blit_##S##_to_##D),				\
+	SDL_BLITTER_NAME(Blit_##S##_to_##D##_Key),			\
+	SDL_BLITTER_NAME(Blit_##S##_to_##D##_PixelAlpha),
+#define AUTO_OPAQUE_SRC_NAMES(S)	AUTO_FOR_EACH_DST(AUTO_OPAQUE_NAMES, S)
+#define AUTO_ALPHA_SRC_NAMES(S)		AUTO_FOR_EACH_DST(AUTO_ALPHA_NAMES, S)
+
+const SDL_BlitterName SDL_BlitterNamesAuto[] = {
+	AUTO_FOR_EACH_OPAQUE_SRC(AUTO_OPAQUE_SRC_NAMES)
+	AUTO_FOR_EACH_ALPHA_SRC(AUTO_ALPHA_SRC_NAMES)
+	{ NULL, NULL }
+};
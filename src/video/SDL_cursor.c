@@ -582,9 +582,12 @@ static void SDL_ConvertCursorSave(SDL_Surface *screen, int w, int h)
 	info.d_width = w;
 	info.d_height = h;
 	info.d_skip = 0;
+	info.d_x = 0;
+	info.d_y = 0;
 	info.aux_data = screen->map->sw_data->aux_data;
 	info.src = screen->format;
 	info.table = screen->map->table;
+	info.pair_table = screen->map->pair_table;
 	info.dst = SDL_VideoSurface->format;
 	RunBlit = screen->map->sw_data->blit;
 
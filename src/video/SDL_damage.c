@@ -0,0 +1,495 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Screen damage tracking for SDL_UpdateRects()
+
+   Applications that update lots of small sprites tend to pass hundreds of
+   overlapping rectangles, and each one costs a blit from the shadow
+   surface plus a driver call (XShmPutImage, a framebuffer copy...).
+   When SDL_VIDEO_COALESCE_RECTS is set the rectangles are rasterized onto
+   a grid of tiles, the dirty tiles are gathered into spans and merged
+   vertically, and then rectangles are greedily joined whenever the extra
+   pixels cost less than the per-rectangle overhead:
+
+	SDL_VIDEO_COALESCE_TILE    tile size in pixels (default 16)
+	SDL_VIDEO_COALESCE_COST    cost of one rectangle, in pixels (default 2048)
+
+   The merged set is only used if it is cheaper than the original one.
+
+   Other applications redraw and flip the whole screen every frame even
+   when almost nothing changed.  When SDL_VIDEO_FRAME_DIFF is set, a copy
+   of every tile that was last sent to the driver is kept, costing the
+   memory of another screen, and tiles that are byte for byte the same
+   are dropped from the update:
+
+	SDL_VIDEO_FRAME_DIFF_TILE  tile size in pixels (default 32)
+
+   Both stages run before the shadow surface blit, so the blit and the
+   driver (X11 MIT-SHM, fbcon shadow copies...) only see what changed.
+*/
+
+#include "SDL_video.h"
+#include "SDL_damage_c.h"
+
+#define DEFAULT_TILE_SIZE	16
+#define DEFAULT_RECT_COST	2048
+#define DEFAULT_DIFF_TILE_SIZE	32
+/* Past this many spans the pairwise merge isn't worth the time */
+#define MAX_MERGE_RECTS		256
+
+/* A rectangle in tile units, right and bottom exclusive */
+typedef struct {
+	int x1, y1, x2, y2;
+} SDL_TileRect;
+
+/* A grid of tiles covering the screen */
+typedef struct {
+	int size;
+	int w, h;
+	Uint8 *dirty;
+	SDL_TileRect *spans;
+	SDL_Rect *rects;
+} SDL_TileGrid;
+
+SDL_UpdateStats SDL_update_stats;
+
+static int coalesce = 0;
+static int rect_cost = DEFAULT_RECT_COST;
+static SDL_TileGrid merge_grid;
+
+static int framediff = 0;
+static volatile int diff_valid = 0;
+static SDL_TileGrid diff_grid;
+static Uint8 *diff_pixels = NULL;	/* the screen as last sent */
+static Uint8 *diff_saved = NULL;	/* the tiles diff_pixels holds */
+static SDL_Surface *diff_surface = NULL;
+static int diff_surface_w, diff_surface_h, diff_surface_bpp;
+
+static int GetTileSize(const char *name, int defsize)
+{
+	const char *env = SDL_getenv(name);
+	int size = env ? SDL_atoi(env) : defsize;
+
+	return (size < 1) ? defsize : size;
+}
+
+static void FreeTileGrid(SDL_TileGrid *grid)
+{
+	if ( grid->dirty ) {
+		SDL_free(grid->dirty);
+	}
+	if ( grid->spans ) {
+		SDL_free(grid->spans);
+	}
+	if ( grid->rects ) {
+		SDL_free(grid->rects);
+	}
+	grid->dirty = NULL;
+	grid->spans = NULL;
+	grid->rects = NULL;
+	grid->w = grid->h = 0;
+}
+
+static void FreeDiffPixels(void)
+{
+	if ( diff_pixels ) {
+		SDL_free(diff_pixels);
+	}
+	if ( diff_saved ) {
+		SDL_free(diff_saved);
+	}
+	diff_pixels = NULL;
+	diff_saved = NULL;
+}
+
+/* Size the grid for a w x h screen and clear it, returns 0 on success */
+static int ResetTileGrid(SDL_TileGrid *grid, int w, int h)
+{
+	const int tw = (w + grid->size - 1) / grid->size;
+	const int th = (h + grid->size - 1) / grid->size;
+
+	if ( tw != grid->w || th != grid->h ) {
+		FreeTileGrid(grid);
+		grid->dirty = (Uint8 *)SDL_malloc(tw * th);
+		grid->spans = (SDL_TileRect *)SDL_malloc(tw * th *
+		                                         sizeof(SDL_TileRect));
+		grid->rects = (SDL_Rect *)SDL_malloc(tw * th * sizeof(SDL_Rect));
+		if ( !grid->dirty || !grid->spans || !grid->rects ) {
+			FreeTileGrid(grid);
+			return(-1);
+		}
+		grid->w = tw;
+		grid->h = th;
+	}
+	SDL_memset(grid->dirty, 0, tw * th);
+	return(0);
+}
+
+/* Clip a rectangle to the screen, returns 0 if nothing is left */
+static int ClipRect(int w, int h, const SDL_Rect *rect,
+                    int *x1, int *y1, int *x2, int *y2)
+{
+	*x1 = rect->x < 0 ? 0 : rect->x;
+	*y1 = rect->y < 0 ? 0 : rect->y;
+	*x2 = rect->x + rect->w > w ? w : rect->x + rect->w;
+	*y2 = rect->y + rect->h > h ? h : rect->y + rect->h;
+	return (*x1 < *x2) && (*y1 < *y2);
+}
+
+/* Mark the tiles touched by the rectangles, returns 0 if there are none.
+   The bounds of the rectangles on screen are returned in pixels.
+ */
+static int MarkTiles(SDL_TileGrid *grid, int w, int h,
+                     int numrects, const SDL_Rect *rects, SDL_Rect *bounds)
+{
+	int bx1 = w, by1 = h, bx2 = 0, by2 = 0;
+	int x1, y1, x2, y2;
+	int i, ty;
+
+	for ( i = 0; i < numrects; ++i ) {
+		if ( !ClipRect(w, h, &rects[i], &x1, &y1, &x2, &y2) ) {
+			continue;
+		}
+		if ( x1 < bx1 ) bx1 = x1;
+		if ( y1 < by1 ) by1 = y1;
+		if ( x2 > bx2 ) bx2 = x2;
+		if ( y2 > by2 ) by2 = y2;
+		x1 /= grid->size;
+		y1 /= grid->size;
+		x2 = (x2 + grid->size - 1) / grid->size;
+		y2 = (y2 + grid->size - 1) / grid->size;
+		for ( ty = y1; ty < y2; ++ty ) {
+			SDL_memset(&grid->dirty[ty*grid->w + x1], 1, x2 - x1);
+		}
+	}
+	if ( bx1 >= bx2 ) {
+		return(0);
+	}
+	bounds->x = bx1;
+	bounds->y = by1;
+	bounds->w = bx2 - bx1;
+	bounds->h = by2 - by1;
+	return(1);
+}
+
+/* Collect runs of dirty tiles, extending identical runs downwards */
+static int CollectSpans(SDL_TileGrid *grid)
+{
+	SDL_TileRect *spans = grid->spans;
+	int numspans = 0, prevstart = 0, rowstart;
+	int tx, ty, x1, j, found;
+
+	for ( ty = 0; ty < grid->h; ++ty ) {
+		const Uint8 *row = &grid->dirty[ty*grid->w];
+		rowstart = numspans;
+		for ( tx = 0; tx < grid->w; ) {
+			if ( !row[tx] ) {
+				++tx;
+				continue;
+			}
+			x1 = tx;
+			while ( tx < grid->w && row[tx] ) {
+				++tx;
+			}
+			found = 0;
+			for ( j = prevstart; j < rowstart; ++j ) {
+				if ( spans[j].x1 == x1 && spans[j].x2 == tx &&
+				     spans[j].y2 == ty ) {
+					spans[j].y2 = ty + 1;
+					found = 1;
+					break;
+				}
+			}
+			if ( !found ) {
+				spans[numspans].x1 = x1;
+				spans[numspans].y1 = ty;
+				spans[numspans].x2 = tx;
+				spans[numspans].y2 = ty + 1;
+				++numspans;
+			}
+		}
+		/* Skip spans that ended above this row */
+		while ( prevstart < numspans && spans[prevstart].y2 <= ty ) {
+			++prevstart;
+		}
+	}
+	return numspans;
+}
+
+/* Convert spans back to pixels, clipped to the given bounds */
+static void SpansToRects(SDL_TileGrid *grid, int numspans,
+                         const SDL_Rect *bounds)
+{
+	const SDL_TileRect *spans = grid->spans;
+	int x1, y1, x2, y2;
+	int i;
+
+	for ( i = 0; i < numspans; ++i ) {
+		x1 = SDL_max(spans[i].x1 * grid->size, bounds->x);
+		y1 = SDL_max(spans[i].y1 * grid->size, bounds->y);
+		x2 = SDL_min(spans[i].x2 * grid->size, bounds->x + bounds->w);
+		y2 = SDL_min(spans[i].y2 * grid->size, bounds->y + bounds->h);
+		grid->rects[i].x = x1;
+		grid->rects[i].y = y1;
+		grid->rects[i].w = x2 - x1;
+		grid->rects[i].h = y2 - y1;
+	}
+}
+
+static Uint32 RectsArea(int numrects, const SDL_Rect *rects)
+{
+	Uint32 area = 0;
+	int i;
+
+	for ( i = 0; i < numrects; ++i ) {
+		area += (Uint32)rects[i].w * rects[i].h;
+	}
+	return area;
+}
+
+static int TileArea(const SDL_TileRect *r)
+{
+	return (r->x2 - r->x1) * (r->y2 - r->y1);
+}
+
+static int CoalesceRects(int w, int h, int numrects, SDL_Rect *rects,
+                         SDL_Rect **out)
+{
+	SDL_TileRect *spans;
+	SDL_TileRect u;
+	SDL_Rect bounds;
+	Uint32 cost_in, cost_out;
+	int numspans, i, j, found;
+
+	*out = rects;
+	if ( numrects < 2 || ResetTileGrid(&merge_grid, w, h) < 0 ||
+	     !MarkTiles(&merge_grid, w, h, numrects, rects, &bounds) ) {
+		return numrects;
+	}
+	spans = merge_grid.spans;
+	numspans = CollectSpans(&merge_grid);
+
+	/* Greedily join rectangles when one bigger rectangle is cheaper */
+	if ( numspans <= MAX_MERGE_RECTS ) {
+		const int cost = rect_cost / (merge_grid.size * merge_grid.size);
+		do {
+			found = 0;
+			for ( i = 0; i < numspans; ++i ) {
+				for ( j = i+1; j < numspans; ++j ) {
+					u.x1 = SDL_min(spans[i].x1, spans[j].x1);
+					u.y1 = SDL_min(spans[i].y1, spans[j].y1);
+					u.x2 = SDL_max(spans[i].x2, spans[j].x2);
+					u.y2 = SDL_max(spans[i].y2, spans[j].y2);
+					if ( TileArea(&u) > TileArea(&spans[i]) +
+					                    TileArea(&spans[j]) + cost ) {
+						continue;
+					}
+					spans[i] = u;
+					spans[j] = spans[--numspans];
+					found = 1;
+					--j;
+				}
+			}
+		} while ( found );
+	}
+
+	/* Trim the tiles back to the dirty area */
+	SpansToRects(&merge_grid, numspans, &bounds);
+
+	/* Only use the new set if the cost model says it's better */
+	cost_in = RectsArea(numrects, rects) + numrects * rect_cost;
+	cost_out = RectsArea(numspans, merge_grid.rects) + numspans * rect_cost;
+	if ( cost_out >= cost_in ) {
+		return numrects;
+	}
+	*out = merge_grid.rects;
+	return numspans;
+}
+
+/* Compare 'rows' rows of 'len' bytes with the copy in 'saved', bringing
+   the copy up to date.  Returns 1 if they differed. */
+static int DiffTile(const Uint8 *p, int pitch, Uint8 *saved, int savedpitch,
+                    int len, int rows, int changed)
+{
+	while ( rows-- ) {
+		if ( changed || SDL_memcmp(saved, p, len) != 0 ) {
+			SDL_memcpy(saved, p, len);
+			changed = 1;
+		}
+		p += pitch;
+		saved += savedpitch;
+	}
+	return changed;
+}
+
+/* Drop the tiles that haven't changed since they were last updated */
+static int DiffRects(SDL_Surface *screen, int numrects, SDL_Rect *rects,
+                     SDL_Rect **out)
+{
+	const int bpp = screen->format->BytesPerPixel;
+	const int size = diff_grid.size;
+	const int savedpitch = screen->w * bpp;
+	SDL_Rect bounds;
+	int tx, ty, w, h, numspans, offset;
+	Uint8 *dirty, *saved;
+
+	*out = rects;
+	if ( SDL_MUSTLOCK(screen) || (screen->flags & SDL_HWSURFACE) ) {
+		return numrects;
+	}
+
+	/* A new video mode means nothing is known about the screen */
+	if ( screen != diff_surface ||
+	     screen->w != diff_surface_w || screen->h != diff_surface_h ||
+	     bpp != diff_surface_bpp ) {
+		diff_surface = screen;
+		diff_surface_w = screen->w;
+		diff_surface_h = screen->h;
+		diff_surface_bpp = bpp;
+		diff_valid = 0;
+	}
+	if ( ResetTileGrid(&diff_grid, screen->w, screen->h) < 0 ) {
+		return numrects;
+	}
+	if ( !diff_valid ) {
+		FreeDiffPixels();
+		diff_pixels = (Uint8 *)SDL_malloc(savedpitch * screen->h);
+		diff_saved = (Uint8 *)SDL_calloc(diff_grid.w * diff_grid.h, 1);
+		if ( !diff_pixels || !diff_saved ) {
+			FreeDiffPixels();
+			return numrects;
+		}
+	}
+	if ( !MarkTiles(&diff_grid, screen->w, screen->h,
+	                numrects, rects, &bounds) ) {
+		return numrects;
+	}
+
+	/* Compare the touched tiles and keep the ones that changed */
+	dirty = diff_grid.dirty;
+	saved = diff_saved;
+	for ( ty = 0; ty < diff_grid.h; ++ty ) {
+		h = SDL_min(size, screen->h - ty*size);
+		for ( tx = 0; tx < diff_grid.w; ++tx, ++dirty, ++saved ) {
+			if ( !*dirty ) {
+				continue;
+			}
+			w = SDL_min(size, screen->w - tx*size);
+			offset = ty*size*savedpitch + tx*size*bpp;
+			++SDL_update_stats.tiles_checked;
+			if ( !DiffTile((Uint8 *)screen->pixels +
+			               ty*size*screen->pitch + tx*size*bpp,
+			               screen->pitch, diff_pixels + offset,
+			               savedpitch, w*bpp, h, !*saved) ) {
+				*dirty = 0;
+				continue;
+			}
+			*saved = 1;
+			++SDL_update_stats.tiles_changed;
+		}
+	}
+	diff_valid = 1;
+
+	/* Whole tiles are sent so the saved copy matches the screen */
+	numspans = CollectSpans(&diff_grid);
+	bounds.x = 0;
+	bounds.y = 0;
+	bounds.w = screen->w;
+	bounds.h = screen->h;
+	SpansToRects(&diff_grid, numspans, &bounds);
+	*out = diff_grid.rects;
+	return numspans;
+}
+
+void SDL_DamageInit(void)
+{
+	const char *env;
+
+	SDL_memset(&SDL_update_stats, 0, sizeof(SDL_update_stats));
+
+	env = SDL_getenv("SDL_VIDEO_COALESCE_RECTS");
+	coalesce = (env && SDL_atoi(env));
+	merge_grid.size = GetTileSize("SDL_VIDEO_COALESCE_TILE",
+	                              DEFAULT_TILE_SIZE);
+	env = SDL_getenv("SDL_VIDEO_COALESCE_COST");
+	rect_cost = env ? SDL_atoi(env) : DEFAULT_RECT_COST;
+	if ( rect_cost < 0 ) {
+		rect_cost = 0;
+	}
+
+	env = SDL_getenv("SDL_VIDEO_FRAME_DIFF");
+	framediff = (env && SDL_atoi(env));
+	diff_grid.size = GetTileSize("SDL_VIDEO_FRAME_DIFF_TILE",
+	                             DEFAULT_DIFF_TILE_SIZE);
+	diff_valid = 0;
+}
+
+void SDL_DamageQuit(void)
+{
+	FreeTileGrid(&merge_grid);
+	FreeTileGrid(&diff_grid);
+	FreeDiffPixels();
+	diff_surface = NULL;
+	diff_valid = 0;
+	coalesce = 0;
+	framediff = 0;
+}
+
+void SDL_DamageReset(void)
+{
+	diff_valid = 0;
+}
+
+int SDL_DamageRects(SDL_Surface *screen, int numrects, SDL_Rect *rects,
+                    SDL_Rect **out)
+{
+	SDL_Rect *inrects = rects;
+	int numinrects = numrects;
+
+	if ( framediff ) {
+		numrects = DiffRects(screen, numrects, rects, &rects);
+	}
+	if ( coalesce ) {
+		numrects = CoalesceRects(screen->w, screen->h,
+		                         numrects, rects, &rects);
+	}
+
+	++SDL_update_stats.updates;
+	SDL_update_stats.rects_in += numinrects;
+	SDL_update_stats.rects_out += numrects;
+	SDL_update_stats.pixels_in += RectsArea(numinrects, inrects);
+	SDL_update_stats.pixels_out += RectsArea(numrects, rects);
+
+	*out = rects;
+	return numrects;
+}
+
+void SDL_GetUpdateStats(SDL_UpdateStats *out, int reset)
+{
+	if ( out ) {
+		*out = SDL_update_stats;
+	}
+	if ( reset ) {
+		SDL_memset(&SDL_update_stats, 0, sizeof(SDL_update_stats));
+	}
+}
@@ -0,0 +1,44 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Screen damage tracking for SDL_UpdateRects(), in SDL_damage.c */
+
+extern void SDL_DamageInit(void);
+extern void SDL_DamageQuit(void);
+
+/* The counters reported by SDL_GetUpdateStats() */
+extern SDL_UpdateStats SDL_update_stats;
+
+/* Forget what is on the screen, so the next update sends everything.
+   Call this when the screen contents are lost or the palette changes.
+ */
+extern void SDL_DamageReset(void);
+
+/* Reduce a list of rectangles to update on the screen, dropping tiles
+   that didn't change and merging nearby rectangles as configured, and
+   count them in the update statistics.  Returns the number of rectangles
+   in *out, which points either to the original rectangles or to a buffer
+   owned by SDL_damage.c that is valid until the next call.
+ */
+extern int SDL_DamageRects(SDL_Surface *screen, int numrects, SDL_Rect *rects,
+                           SDL_Rect **out);
@@ -25,6 +25,7 @@
 
 #include "SDL_endian.h"
 #include "SDL_video.h"
+#include "SDL_thread.h"
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
 #include "SDL_pixels_c.h"
@@ -235,7 +236,7 @@ SDL_PixelFormat *SDL_ReallocFormat(SDL_Surface *surface, int bpp,
 /*
  * Change any previous mappings from/to the new surface format
  */
-void SDL_FormatChanged(SDL_Surface *surface)
+static void NextFormatVersion(SDL_Surface *surface)
 {
 	static int format_version = 0;
 	++format_version;
@@ -243,8 +244,28 @@ void SDL_FormatChanged(SDL_Surface *surface)
 		format_version = 1;
 	}
 	surface->format_version = format_version;
+}
+void SDL_FormatChanged(SDL_Surface *surface)
+{
+	NextFormatVersion(surface);
 	SDL_InvalidateMap(surface->map);
 }
+/*
+ * Colors [firstcolor, firstcolor+ncolors) of the surface palette changed.
+ * Mappings to the surface are dropped as for SDL_FormatChanged(), but the
+ * surface's own mapping is patched for just those colors when it can be.
+ * 'mapcolors' are the colors that mapping translates from, normally the
+ * palette itself, or NULL if the change doesn't affect them.
+ */
+void SDL_PaletteChanged(SDL_Surface *surface, SDL_Color *mapcolors,
+                        int firstcolor, int ncolors)
+{
+	NextFormatVersion(surface);
+	if ( mapcolors &&
+	     !SDL_PatchMap(surface, mapcolors, firstcolor, ncolors) ) {
+		SDL_InvalidateMap(surface->map);
+	}
+}
 /*
  * Free a previously allocated format structure
  */
@@ -290,7 +311,7 @@ void SDL_DitherColors(SDL_Color *colors, int bpp)
  */
 Uint16 SDL_CalculatePitch(SDL_Surface *surface)
 {
-	Uint16 pitch;
+	int pitch;
 
 	/* Surface should be 4-byte aligned for speed */
 	pitch = surface->w*surface->format->BytesPerPixel;
@@ -305,12 +326,223 @@ Uint16 SDL_CalculatePitch(SDL_Surface *surface)
 			break;
 	}
 	pitch = (pitch + 3) & ~3;	/* 4-byte aligning */
-	return(pitch);
+	if ( surface->flags & SDL_SIMDALIGNED ) {
+		int aligned = (pitch + SDL_SURFACE_ALIGNMENT-1) &
+		              ~(SDL_SURFACE_ALIGNMENT-1);
+		/* The widest surfaces can't be padded and still fit a Uint16 */
+		if ( aligned <= 0xFFFF ) {
+			pitch = aligned;
+		} else {
+			surface->flags &= ~SDL_SIMDALIGNED;
+		}
+	}
+	return((Uint16)pitch);
 }
+
 /*
- * Match an RGB value to a particular palette index
+ * Allocate 'len' bytes of pixels for a software surface, which are
+ * released with SDL_free().  Surfaces with SDL_SIMDALIGNED get a block
+ * starting on an SDL_SURFACE_ALIGNMENT boundary when the C library has
+ * a way to make one that free() accepts.
  */
-Uint8 SDL_FindColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b)
+void *SDL_AllocPixels(SDL_Surface *surface, size_t len)
+{
+	if ( surface->flags & SDL_SIMDALIGNED ) {
+#if defined(HAVE_POSIX_MEMALIGN) && defined(HAVE_MALLOC) && defined(HAVE_FREE)
+		void *pixels;
+		if ( posix_memalign(&pixels, SDL_SURFACE_ALIGNMENT, len) != 0 ) {
+			return(NULL);
+		}
+		return(pixels);
+#elif !defined(HAVE_MALLOC) && !defined(HAVE_FREE)
+		return(SDL_memalign(SDL_SURFACE_ALIGNMENT, len));
+#endif
+	}
+	return(SDL_malloc(len));
+}
+/*
+ * Nearest color searches in big palettes go through an index that splits
+ * RGB space into 8x8x8 boxes.  Each box lists, in palette order, only the
+ * colors that can be the nearest one to some point inside it, so a search
+ * gives exactly the answer a search of the whole palette would, usually
+ * after a dozen or so comparisons instead of 256.  Indexes are cached by
+ * palette contents and only built once a palette has been searched a few
+ * times, so palettes that change every frame don't pay for them.  Any
+ * thread can replace a cached index, so an index is only used with
+ * SDL_LockMapCache() held.
+ */
+#define SDL_PALETTE_INDEX_CACHE		4
+#define SDL_PALETTE_INDEX_COLORS	32	/* Smaller palettes are scanned */
+#define SDL_PALETTE_INDEX_USES		8
+
+typedef struct {
+	Uint8 *candidates;		/* NULL until the index is built */
+	Uint32 start[8*8*8+1];
+	int uses;
+	Uint32 stamp;
+	int ncolors;
+	SDL_Color colors[256];
+} SDL_PaletteIndex;
+
+static SDL_PaletteIndex palette_indexes[SDL_PALETTE_INDEX_CACHE];
+static Uint32 palette_index_stamp = 0;
+
+/* Squared distances along one channel from each color to the nearest and
+   furthest points of each of the 8 box slices of that channel */
+typedef struct {
+	Uint16 mindist[3][8][256];
+	Uint16 maxdist[3][8][256];
+} SDL_BoxDistances;
+
+static void CalculateBoxDistances(SDL_BoxDistances *dist,
+                                  const SDL_Color *colors, int ncolors)
+{
+	int c, slice, i;
+
+	for ( c = 0; c < 3; ++c ) {
+		for ( slice = 0; slice < 8; ++slice ) {
+			int lo = slice << 5;
+			int hi = lo + 31;
+			for ( i = 0; i < ncolors; ++i ) {
+				int v, dmin, dmax;
+				v = (c == 0) ? colors[i].r :
+				    (c == 1) ? colors[i].g : colors[i].b;
+				if ( v < lo ) {
+					dmin = lo - v;
+					dmax = hi - v;
+				} else if ( v > hi ) {
+					dmin = v - hi;
+					dmax = v - lo;
+				} else {
+					dmin = 0;
+					dmax = (v-lo > hi-v) ? v-lo : hi-v;
+				}
+				dist->mindist[c][slice][i] = dmin*dmin;
+				dist->maxdist[c][slice][i] = dmax*dmax;
+			}
+		}
+	}
+}
+
+static int BuildPaletteIndex(SDL_PaletteIndex *index)
+{
+	SDL_BoxDistances *dist;
+	Uint32 mindist[256];
+	Uint32 maxdist, nearest;
+	Uint8 *candidates;
+	Uint32 n, size;
+	int box, i;
+
+	/* Most boxes have a few dozen candidates at most */
+	size = 8*8*8*32;
+	dist = (SDL_BoxDistances *)SDL_malloc(sizeof(*dist));
+	candidates = (Uint8 *)SDL_malloc(size);
+	if ( dist == NULL || candidates == NULL ) {
+		SDL_free(dist);
+		SDL_free(candidates);
+		return(0);
+	}
+	CalculateBoxDistances(dist, index->colors, index->ncolors);
+
+	n = 0;
+	for ( box = 0; box < 8*8*8; ++box ) {
+		const Uint16 *rmin = dist->mindist[0][box >> 6];
+		const Uint16 *gmin = dist->mindist[1][(box >> 3) & 7];
+		const Uint16 *bmin = dist->mindist[2][box & 7];
+		const Uint16 *rmax = dist->maxdist[0][box >> 6];
+		const Uint16 *gmax = dist->maxdist[1][(box >> 3) & 7];
+		const Uint16 *bmax = dist->maxdist[2][box & 7];
+
+		/* Every point in the box is at most 'nearest' from some color */
+		nearest = ~0;
+		for ( i = 0; i < index->ncolors; ++i ) {
+			mindist[i] = (Uint32)rmin[i] + gmin[i] + bmin[i];
+			maxdist = (Uint32)rmax[i] + gmax[i] + bmax[i];
+			if ( maxdist < nearest ) {
+				nearest = maxdist;
+			}
+		}
+		/* ... so colors further away than that can't be the nearest */
+		index->start[box] = n;
+		if ( n + index->ncolors > size ) {
+			Uint8 *more;
+			size *= 2;
+			more = (Uint8 *)SDL_realloc(candidates, size);
+			if ( more == NULL ) {
+				SDL_free(dist);
+				SDL_free(candidates);
+				return(0);
+			}
+			candidates = more;
+		}
+		for ( i = 0; i < index->ncolors; ++i ) {
+			if ( mindist[i] <= nearest ) {
+				candidates[n++] = (Uint8)i;
+			}
+		}
+	}
+	index->start[box] = n;
+	SDL_free(dist);
+	index->candidates = (Uint8 *)SDL_realloc(candidates, n);
+	if ( index->candidates == NULL ) {
+		index->candidates = candidates;
+	}
+	return(1);
+}
+
+/* Find the index of a palette, building it if 'build' is set or the
+   palette has been searched often enough.  Returns NULL if there isn't
+   one, and the palette should be scanned instead. */
+static SDL_PaletteIndex *GetPaletteIndex(SDL_Palette *pal, int build)
+{
+	SDL_PaletteIndex *index = NULL;
+	int i;
+
+	if ( pal->ncolors < SDL_PALETTE_INDEX_COLORS || pal->ncolors > 256 ) {
+		return(NULL);
+	}
+	for ( i = 0; i < SDL_PALETTE_INDEX_CACHE; ++i ) {
+		SDL_PaletteIndex *entry = &palette_indexes[i];
+		if ( entry->ncolors == pal->ncolors &&
+		     SDL_memcmp(entry->colors, pal->colors,
+		                pal->ncolors*sizeof(SDL_Color)) == 0 ) {
+			index = entry;
+			break;
+		}
+	}
+	if ( index == NULL ) {
+		/* Reuse the least recently searched slot */
+		index = &palette_indexes[0];
+		for ( i = 1; i < SDL_PALETTE_INDEX_CACHE; ++i ) {
+			if ( palette_indexes[i].stamp < index->stamp ) {
+				index = &palette_indexes[i];
+			}
+		}
+		if ( index->candidates ) {
+			SDL_free(index->candidates);
+			index->candidates = NULL;
+		}
+		index->uses = 0;
+		index->ncolors = pal->ncolors;
+		SDL_memcpy(index->colors, pal->colors,
+		           pal->ncolors*sizeof(SDL_Color));
+	}
+	index->stamp = ++palette_index_stamp;
+
+	if ( index->candidates == NULL ) {
+		if ( !build && ++index->uses < SDL_PALETTE_INDEX_USES ) {
+			return(NULL);
+		}
+		if ( !BuildPaletteIndex(index) ) {
+			return(NULL);
+		}
+	}
+	return(index);
+}
+
+/* Search a palette, through its index if it has one */
+static Uint8 LookupColor(SDL_PaletteIndex *index, SDL_Palette *pal,
+                         Uint8 r, Uint8 g, Uint8 b)
 {
 	/* Do colorspace distance matching */
 	unsigned int smallest;
@@ -320,6 +552,26 @@ Uint8 SDL_FindColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b)
 	Uint8 pixel=0;
 		
 	smallest = ~0;
+	if ( index ) {
+		int box = ((r >> 5) << 6) | ((g >> 5) << 3) | (b >> 5);
+		Uint32 n;
+
+		for ( n = index->start[box]; n < index->start[box+1]; ++n ) {
+			i = index->candidates[n];
+			rd = index->colors[i].r - r;
+			gd = index->colors[i].g - g;
+			bd = index->colors[i].b - b;
+			distance = (rd*rd)+(gd*gd)+(bd*bd);
+			if ( distance < smallest ) {
+				pixel = i;
+				if ( distance == 0 ) { /* Perfect match! */
+					break;
+				}
+				smallest = distance;
+			}
+		}
+		return(pixel);
+	}
 	for ( i=0; i<pal->ncolors; ++i ) {
 		rd = pal->colors[i].r - r;
 		gd = pal->colors[i].g - g;
@@ -336,6 +588,98 @@ Uint8 SDL_FindColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b)
 	return(pixel);
 }
 
+/*
+ * Fill the 4x4x4 entries of an inverse palette (see MapNto1()) that lie in
+ * one box of the index, from the box's candidates.  Gives the same colors
+ * as searching for each entry, but checks each candidate against the
+ * whole box at once.
+ */
+static void FillInverseBox(Uint8 *map, int box, const SDL_Color *colors,
+                           const Uint8 *candidates, int ncandidates)
+{
+	Uint32 smallest[4*4*4];
+	Uint8 pixel[4*4*4];
+	int values[3][4];
+	int origin[3];
+	int c, k, i, r, g, b, j;
+
+	origin[0] = (box >> 6) << 2;
+	origin[1] = ((box >> 3) & 7) << 2;
+	origin[2] = (box & 7) << 2;
+	for ( c = 0; c < 3; ++c ) {
+		for ( k = 0; k < 4; ++k ) {
+			/* Match the values the 5 bits stand for */
+			int v = (origin[c] + k) << 3;
+			values[c][k] = v | (v >> 5);
+		}
+	}
+	for ( j = 0; j < 4*4*4; ++j ) {
+		smallest[j] = ~0;
+		pixel[j] = 0;
+	}
+	for ( i = 0; i < ncandidates; ++i ) {
+		const SDL_Color *color = &colors[candidates[i]];
+		Uint32 rd[4], gd[4], bd[4];
+
+		for ( k = 0; k < 4; ++k ) {
+			rd[k] = (values[0][k]-color->r)*(values[0][k]-color->r);
+			gd[k] = (values[1][k]-color->g)*(values[1][k]-color->g);
+			bd[k] = (values[2][k]-color->b)*(values[2][k]-color->b);
+		}
+		j = 0;
+		for ( r = 0; r < 4; ++r ) {
+			for ( g = 0; g < 4; ++g ) {
+				for ( b = 0; b < 4; ++b, ++j ) {
+					Uint32 distance = rd[r] + gd[g] + bd[b];
+					if ( distance < smallest[j] ) {
+						smallest[j] = distance;
+						pixel[j] = candidates[i];
+					}
+				}
+			}
+		}
+	}
+	j = 0;
+	for ( r = 0; r < 4; ++r ) {
+		for ( g = 0; g < 4; ++g ) {
+			for ( b = 0; b < 4; ++b ) {
+				map[((origin[0]+r) << 10) |
+				    ((origin[1]+g) << 5) |
+				     (origin[2]+b)] = pixel[j++];
+			}
+		}
+	}
+}
+
+static void FreePaletteIndexes(void)
+{
+	int i;
+
+	for ( i = 0; i < SDL_PALETTE_INDEX_CACHE; ++i ) {
+		if ( palette_indexes[i].candidates ) {
+			SDL_free(palette_indexes[i].candidates);
+		}
+	}
+	SDL_memset(palette_indexes, 0, sizeof(palette_indexes));
+}
+
+/*
+ * Match an RGB value to a particular palette index
+ */
+Uint8 SDL_FindColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b)
+{
+	Uint8 pixel;
+
+	if ( pal->ncolors < SDL_PALETTE_INDEX_COLORS || pal->ncolors > 256 ) {
+		/* Never indexed, no need to lock */
+		return LookupColor(NULL, pal, r, g, b);
+	}
+	SDL_LockMapCache();
+	pixel = LookupColor(GetPaletteIndex(pal, 0), pal, r, g, b);
+	SDL_UnlockMapCache();
+	return pixel;
+}
+
 /* Find the opaque pixel value corresponding to an RGB triple */
 Uint32 SDL_MapRGB
 (const SDL_PixelFormat * const format,
@@ -432,9 +776,199 @@ void SDL_ApplyGamma(Uint16 *gamma, SDL_Color *colors, SDL_Color *output,
 	}
 }
 
+/*
+ * Translation tables are shared through a small cache, keyed by the
+ * palettes and pixel format they were built from, so surfaces that flip
+ * between a few palettes or get remapped after a colorkey change don't
+ * rebuild them.  Maps hold a reference to a cached table while they use
+ * it; unreferenced tables are kept for reuse until newer ones push them
+ * out, and tables built while every slot is in use aren't cached at all.
+ */
+#define SDL_MAP_TABLE_CACHE	16
+
+/*
+ * Surfaces are mapped from any thread, so the caches shared between them
+ * (these tables, the palette indexes and the blit functions in SDL_blit.c)
+ * are only looked at or changed with this held.
+ */
+#if !SDL_THREADS_DISABLED
+static SDL_mutex *map_cache_lock = NULL;
+#endif
+
+void SDL_MapCacheInit(void)
+{
+#if !SDL_THREADS_DISABLED
+	if ( !map_cache_lock ) {
+		map_cache_lock = SDL_CreateMutex();
+	}
+#endif
+}
+
+void SDL_LockMapCache(void)
+{
+#if !SDL_THREADS_DISABLED
+	/* WARNING:
+	   Video initialization creates the lock, so this only races when
+	   several threads map their very first surfaces at the same time
+	   without SDL_Init(SDL_INIT_VIDEO) having been called.
+	*/
+	if ( !map_cache_lock ) {
+		SDL_MapCacheInit();
+	}
+	if ( map_cache_lock ) {
+		SDL_mutexP(map_cache_lock);
+	}
+#endif
+}
+
+void SDL_UnlockMapCache(void)
+{
+#if !SDL_THREADS_DISABLED
+	if ( map_cache_lock ) {
+		SDL_mutexV(map_cache_lock);
+	}
+#endif
+}
+
+typedef struct {
+	Uint8 *table;
+	int refcount;
+	Uint32 stamp;
+	Uint32 format[6];
+	int ncolors[2];
+	SDL_Color colors[2][256];
+} SDL_MapTableEntry;
+
+static SDL_MapTableEntry map_tables[SDL_MAP_TABLE_CACHE];
+static Uint32 map_table_stamp = 0;
+
+static int MatchMapTable(SDL_MapTableEntry *entry, const Uint32 *format,
+                         SDL_Palette *src, SDL_Palette *dst)
+{
+	if ( SDL_memcmp(entry->format, format, sizeof(entry->format)) != 0 ) {
+		return 0;
+	}
+	if ( entry->ncolors[0] != src->ncolors ||
+	     SDL_memcmp(entry->colors[0], src->colors,
+	                src->ncolors*sizeof(SDL_Color)) != 0 ) {
+		return 0;
+	}
+	if ( dst && (entry->ncolors[1] != dst->ncolors ||
+	             SDL_memcmp(entry->colors[1], dst->colors,
+	                        dst->ncolors*sizeof(SDL_Color)) != 0) ) {
+		return 0;
+	}
+	return 1;
+}
+
+/* Look up a table built from 'src' and either 'dst' or 'format' */
+static Uint8 *FindMapTable(const Uint32 *format,
+                           SDL_Palette *src, SDL_Palette *dst)
+{
+	Uint8 *table = NULL;
+	int i;
+
+	SDL_LockMapCache();
+	for ( i = 0; i < SDL_MAP_TABLE_CACHE; ++i ) {
+		SDL_MapTableEntry *entry = &map_tables[i];
+		if ( entry->table && MatchMapTable(entry, format, src, dst) ) {
+			++entry->refcount;
+			entry->stamp = ++map_table_stamp;
+			table = entry->table;
+			break;
+		}
+	}
+	if ( table ) {
+		++SDL_blit_cache_stats.table_hits;
+	} else {
+		++SDL_blit_cache_stats.table_misses;
+	}
+	SDL_UnlockMapCache();
+	return table;
+}
+
+static void AddMapTable(const Uint32 *format,
+                        SDL_Palette *src, SDL_Palette *dst, Uint8 *table)
+{
+	SDL_MapTableEntry *entry = NULL;
+	int i;
+
+	if ( src->ncolors > 256 || (dst && dst->ncolors > 256) ) {
+		return;
+	}
+	SDL_LockMapCache();
+	/* Use a free slot, or push out the least recently used table */
+	for ( i = 0; i < SDL_MAP_TABLE_CACHE; ++i ) {
+		if ( map_tables[i].refcount == 0 &&
+		     (!entry || !map_tables[i].table ||
+		      (entry->table && map_tables[i].stamp < entry->stamp)) ) {
+			entry = &map_tables[i];
+		}
+	}
+	if ( entry == NULL ) {
+		SDL_UnlockMapCache();
+		return;
+	}
+	if ( entry->table ) {
+		SDL_free(entry->table);
+	}
+	entry->table = table;
+	entry->refcount = 1;
+	entry->stamp = ++map_table_stamp;
+	SDL_memcpy(entry->format, format, sizeof(entry->format));
+	entry->ncolors[0] = src->ncolors;
+	SDL_memcpy(entry->colors[0], src->colors, src->ncolors*sizeof(SDL_Color));
+	entry->ncolors[1] = dst ? dst->ncolors : 0;
+	if ( dst ) {
+		SDL_memcpy(entry->colors[1], dst->colors,
+		           dst->ncolors*sizeof(SDL_Color));
+	}
+	SDL_UnlockMapCache();
+}
+
+static void ReleaseMapTable(Uint8 *table)
+{
+	int i;
+
+	SDL_LockMapCache();
+	for ( i = 0; i < SDL_MAP_TABLE_CACHE; ++i ) {
+		if ( map_tables[i].table == table ) {
+			--map_tables[i].refcount;
+			SDL_UnlockMapCache();
+			return;
+		}
+	}
+	SDL_UnlockMapCache();
+	SDL_free(table);
+}
+
+/* Free the cached tables that no surface is using, and the lock */
+void SDL_MapCacheQuit(void)
+{
+	int i;
+
+	SDL_LockMapCache();
+	for ( i = 0; i < SDL_MAP_TABLE_CACHE; ++i ) {
+		if ( map_tables[i].table && map_tables[i].refcount == 0 ) {
+			SDL_free(map_tables[i].table);
+			map_tables[i].table = NULL;
+		}
+	}
+	FreePaletteIndexes();
+	SDL_UnlockMapCache();
+#if !SDL_THREADS_DISABLED
+	if ( map_cache_lock ) {
+		SDL_DestroyMutex(map_cache_lock);
+		map_cache_lock = NULL;
+	}
+#endif
+}
+
 /* Map from Palette to Palette */
 static Uint8 *Map1to1(SDL_Palette *src, SDL_Palette *dst, int *identical)
 {
+	static const Uint32 format[6] = { 1, 0, 0, 0, 0, 0 };
+	SDL_PaletteIndex *index;
 	Uint8 *map;
 	int i;
 
@@ -449,15 +983,23 @@ static Uint8 *Map1to1(SDL_Palette *src, SDL_Palette *dst, int *identical)
 		}
 		*identical = 0;
 	}
+	map = FindMapTable(format, src, dst);
+	if ( map ) {
+		return(map);
+	}
 	map = (Uint8 *)SDL_malloc(src->ncolors);
 	if ( map == NULL ) {
 		SDL_OutOfMemory();
 		return(NULL);
 	}
+	SDL_LockMapCache();
+	index = GetPaletteIndex(dst, (src->ncolors > SDL_PALETTE_INDEX_COLORS));
 	for ( i=0; i<src->ncolors; ++i ) {
-		map[i] = SDL_FindColor(dst,
+		map[i] = LookupColor(index, dst,
 			src->colors[i].r, src->colors[i].g, src->colors[i].b);
 	}
+	SDL_UnlockMapCache();
+	AddMapTable(format, src, dst, map);
 	return(map);
 }
 /* Map from Palette to BitField */
@@ -468,6 +1010,19 @@ static Uint8 *Map1toN(SDL_PixelFormat *src, SDL_PixelFormat *dst)
 	int  bpp;
 	unsigned alpha;
 	SDL_Palette *pal = src->palette;
+	Uint32 format[6];
+
+	alpha = dst->Amask ? src->alpha : 0;
+	format[0] = 2 | (dst->BytesPerPixel << 8) | (alpha << 16);
+	format[1] = dst->Rmask;
+	format[2] = dst->Gmask;
+	format[3] = dst->Bmask;
+	format[4] = dst->Amask;
+	format[5] = 0;
+	map = FindMapTable(format, pal, NULL);
+	if ( map ) {
+		return(map);
+	}
 
 	bpp = ((dst->BytesPerPixel == 3) ? 4 : dst->BytesPerPixel);
 	map = (Uint8 *)SDL_malloc(pal->ncolors*bpp);
@@ -476,31 +1031,106 @@ static Uint8 *Map1toN(SDL_PixelFormat *src, SDL_PixelFormat *dst)
 		return(NULL);
 	}
 
-	alpha = dst->Amask ? src->alpha : 0;
 	/* We memory copy to the pixel map so the endianness is preserved */
 	for ( i=0; i<pal->ncolors; ++i ) {
 		ASSEMBLE_RGBA(&map[i*bpp], dst->BytesPerPixel, dst,
 			      pal->colors[i].r, pal->colors[i].g,
 			      pal->colors[i].b, alpha);
 	}
+	AddMapTable(format, pal, NULL, map);
 	return(map);
 }
-/* Map from BitField to Dithered-Palette to Palette */
+/*
+ * Big 8-bit surfaces blitted to 16-bit surfaces also get a table that
+ * translates two pixels per lookup, indexed by (first<<8)|second.  It
+ * takes 256K, so it's only built for surfaces large enough to pay for
+ * building it, and only for full palettes since every entry reads the
+ * translation table, which has just one entry per palette color.  At 32
+ * bits the 512K table measured slower than single lookups in the 1K one.
+ */
+#define SDL_PAIR_TABLE_PIXELS	(256*256)
+
+static void SetPairs(Uint8 *pairs, const Uint8 *map,
+                     int row, int col, int step, int count)
+{
+	Uint16 *p = (Uint16 *)pairs;
+	const Uint16 *m = (const Uint16 *)map;
+	int i = (row << 8) | col;
+
+	/* Entries hold both pixels in memory order, so no byte swapping */
+	for ( ; count--; i += step ) {
+		p[2*i] = m[i >> 8];
+		p[2*i+1] = m[i & 0xFF];
+	}
+}
+static Uint8 *MapPairs(Uint8 *map)
+{
+	Uint8 *pairs;
+
+	pairs = (Uint8 *)SDL_malloc(256*256*4);
+	if ( pairs ) {
+		SetPairs(pairs, map, 0, 0, 1, 256*256);
+	}
+	return(pairs);
+}
+/*
+ * Map from BitField to Palette through an inverse palette, a table of the
+ * nearest color to each 5-5-5 bit RGB value, indexed with RGB_INDEX555().
+ * Destinations with the 3-3-2 dithered palette need no table at all.
+ */
 static Uint8 *MapNto1(SDL_PixelFormat *src, SDL_PixelFormat *dst, int *identical)
 {
-	/* Generate a 256 color dither palette */
-	SDL_Palette dithered;
+	static const Uint32 format[6] = { 3, 0, 0, 0, 0, 0 };
 	SDL_Color colors[256];
 	SDL_Palette *pal = dst->palette;
+	SDL_PaletteIndex *index;
+	Uint8 *map;
+	int box, i;
 	
 	/* SDL_DitherColors does not initialize the 'unused' component of colors,
-	   but Map1to1 compares it against pal, so we should initialize it. */  
+	   but the palette's may be set, so we should initialize it. */  
 	SDL_memset(colors, 0, sizeof(colors));
-
-	dithered.ncolors = 256;
 	SDL_DitherColors(colors, 8);
-	dithered.colors = colors;
-	return(Map1to1(&dithered, pal, identical));
+	if ( pal->ncolors >= 256 &&
+	     SDL_memcmp(colors, pal->colors, sizeof(colors)) == 0 ) {
+		*identical = 1;
+		return(NULL);
+	}
+	*identical = 0;
+
+	map = FindMapTable(format, pal, NULL);
+	if ( map ) {
+		return(map);
+	}
+	map = (Uint8 *)SDL_malloc(32*32*32);
+	if ( map == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	SDL_LockMapCache();
+	index = GetPaletteIndex(pal, 1);
+	if ( index ) {
+		for ( box = 0; box < 8*8*8; ++box ) {
+			FillInverseBox(map, box, index->colors,
+				&index->candidates[index->start[box]],
+				index->start[box+1] - index->start[box]);
+		}
+		SDL_UnlockMapCache();
+	} else {
+		/* A small palette, every color is a candidate */
+		Uint8 all[256];
+		int n = (pal->ncolors < 256) ? pal->ncolors : 256;
+
+		SDL_UnlockMapCache();
+		for ( i = 0; i < n; ++i ) {
+			all[i] = (Uint8)i;
+		}
+		for ( box = 0; box < 8*8*8; ++box ) {
+			FillInverseBox(map, box, pal->colors, all, n);
+		}
+	}
+	AddMapTable(format, pal, NULL, map);
+	return(map);
 }
 
 SDL_BlitMap *SDL_AllocBlitMap(void)
@@ -532,12 +1162,19 @@ void SDL_InvalidateMap(SDL_BlitMap *map)
 	if ( ! map ) {
 		return;
 	}
+	if ( map->rle_job ) {
+		SDL_RLECancel(map);
+	}
 	map->dst = NULL;
 	map->format_version = (unsigned int)-1;
 	if ( map->table ) {
-		SDL_free(map->table);
+		ReleaseMapTable(map->table);
 		map->table = NULL;
 	}
+	if ( map->pair_table ) {
+		SDL_free(map->pair_table);
+		map->pair_table = NULL;
+	}
 }
 int SDL_MapSurface (SDL_Surface *src, SDL_Surface *dst)
 {
@@ -584,6 +1221,13 @@ int SDL_MapSurface (SDL_Surface *src, SDL_Surface *dst)
 			if ( map->table == NULL ) {
 				return(-1);
 			}
+			if ( srcfmt->BitsPerPixel == 8 &&
+			     srcfmt->palette->ncolors == 256 &&
+			     dstfmt->BytesPerPixel == 2 &&
+			     src->w * src->h >= SDL_PAIR_TABLE_PIXELS ) {
+				/* Optional, the blitters work without it */
+				map->pair_table = MapPairs(map->table);
+			}
 			break;
 		}
 		break;
@@ -614,6 +1258,97 @@ int SDL_MapSurface (SDL_Surface *src, SDL_Surface *dst)
 	/* Choose your blitters wisely */
 	return(SDL_CalculateBlit(src));
 }
+/*
+ * Make the map's translation table private to it, so it can be changed.
+ * A cached table that nothing else uses is taken out of the cache, a
+ * shared one is copied.
+ */
+static int UnshareMapTable(SDL_BlitMap *map, int size)
+{
+	Uint8 *table;
+	int i, retval = 1;
+
+	SDL_LockMapCache();
+	for ( i = 0; i < SDL_MAP_TABLE_CACHE; ++i ) {
+		if ( map_tables[i].table == map->table ) {
+			break;
+		}
+	}
+	if ( i == SDL_MAP_TABLE_CACHE ) {
+		/* Already private */
+	} else if ( map_tables[i].refcount == 1 ) {
+		map_tables[i].table = NULL;
+		map_tables[i].refcount = 0;
+	} else {
+		table = (Uint8 *)SDL_malloc(size);
+		if ( table ) {
+			SDL_memcpy(table, map->table, size);
+			--map_tables[i].refcount;
+			map->table = table;
+		} else {
+			retval = 0;
+		}
+	}
+	SDL_UnlockMapCache();
+	return(retval);
+}
+/*
+ * Update the translation table of a valid palette mapping after colors
+ * [firstcolor, firstcolor+ncolors) of 'colors' changed.  Returns 0 if the
+ * mapping has no table to patch, so it has to be rebuilt instead.
+ */
+int SDL_PatchMap(SDL_Surface *src, SDL_Color *colors,
+                 int firstcolor, int ncolors)
+{
+	SDL_BlitMap *map = src->map;
+	SDL_PixelFormat *srcfmt = src->format;
+	SDL_PixelFormat *dstfmt;
+	SDL_Palette *pal = srcfmt->palette;
+	int i, bpp;
+	unsigned alpha;
+
+	if ( !map || !map->dst || !map->table || map->identity ||
+	     map->format_version != map->dst->format_version ||
+	     srcfmt->BytesPerPixel != 1 || !pal ||
+	     (src->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
+		return(0);
+	}
+	if ( firstcolor < 0 || firstcolor+ncolors > pal->ncolors ) {
+		return(0);
+	}
+	dstfmt = map->dst->format;
+
+	if ( dstfmt->BytesPerPixel == 1 ) {
+		/* Palette --> Palette */
+		if ( !dstfmt->palette || !UnshareMapTable(map, pal->ncolors) ) {
+			return(0);
+		}
+		for ( i = firstcolor; i < firstcolor+ncolors; ++i ) {
+			map->table[i] = SDL_FindColor(dstfmt->palette,
+				colors[i].r, colors[i].g, colors[i].b);
+		}
+		return(1);
+	}
+
+	/* Palette --> BitField, as built by Map1toN() */
+	bpp = ((dstfmt->BytesPerPixel == 3) ? 4 : dstfmt->BytesPerPixel);
+	if ( !UnshareMapTable(map, pal->ncolors*bpp) ) {
+		return(0);
+	}
+	alpha = dstfmt->Amask ? srcfmt->alpha : 0;
+	for ( i = firstcolor; i < firstcolor+ncolors; ++i ) {
+		ASSEMBLE_RGBA(&map->table[i*bpp], dstfmt->BytesPerPixel, dstfmt,
+			      colors[i].r, colors[i].g, colors[i].b, alpha);
+	}
+	if ( map->pair_table ) {
+		/* Each color is in one row and one column of pairs */
+		for ( i = firstcolor; i < firstcolor+ncolors; ++i ) {
+			SetPairs(map->pair_table, map->table, i, 0, 1, 256);
+			SetPairs(map->pair_table, map->table, 0, i, 256, 256);
+		}
+	}
+	return(1);
+}
 void SDL_FreeBlitMap(SDL_BlitMap *map)
 {
 	if ( map ) {
@@ -31,16 +31,31 @@ extern SDL_PixelFormat *SDL_AllocFormat(int bpp,
 extern SDL_PixelFormat *SDL_ReallocFormat(SDL_Surface *surface, int bpp,
 		Uint32 Rmask, Uint32 Gmask, Uint32 Bmask, Uint32 Amask);
 extern void SDL_FormatChanged(SDL_Surface *surface);
+extern void SDL_PaletteChanged(SDL_Surface *surface, SDL_Color *mapcolors,
+		int firstcolor, int ncolors);
 extern void SDL_FreeFormat(SDL_PixelFormat *format);
 
 /* Blit mapping functions */
 extern SDL_BlitMap *SDL_AllocBlitMap(void);
 extern void SDL_InvalidateMap(SDL_BlitMap *map);
 extern int SDL_MapSurface (SDL_Surface *src, SDL_Surface *dst);
+extern int SDL_PatchMap(SDL_Surface *src, SDL_Color *colors,
+		int firstcolor, int ncolors);
 extern void SDL_FreeBlitMap(SDL_BlitMap *map);
 
+/* The caches shared by all mapped surfaces, see SDL_pixels.c */
+extern void SDL_MapCacheInit(void);
+extern void SDL_MapCacheQuit(void);
+extern void SDL_LockMapCache(void);
+extern void SDL_UnlockMapCache(void);
+
 /* Miscellaneous functions */
 extern Uint16 SDL_CalculatePitch(SDL_Surface *surface);
+extern void *SDL_AllocPixels(SDL_Surface *surface, size_t len);
+#if !defined(HAVE_MALLOC) && !defined(HAVE_FREE)
+/* memalign() from the dlmalloc in SDL_malloc.c */
+extern void *SDL_memalign(size_t alignment, size_t len);
+#endif
 extern void SDL_DitherColors(SDL_Color *colors, int bpp);
 extern Uint8 SDL_FindColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b);
 extern void SDL_ApplyGamma(Uint16 *gamma, SDL_Color *colors, SDL_Color *output, int ncolors);
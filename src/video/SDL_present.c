@@ -0,0 +1,346 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Presenting the shadow surface on a separate thread
+
+   When the application draws on a shadow surface, SDL_Flip() converts it
+   onto the video surface and calls the driver, which on fbcon and
+   dispmanx can mean waiting for the display to let go of a page.  When
+   SDL_VIDEO_PRESENT_THREAD is set, SDL_Flip() copies the shadow surface
+   (cursor included) into one of three frames and returns, and a present
+   thread does the conversion and the driver update:
+
+	SDL_VIDEO_PRESENT_THREAD=block  SDL_Flip() waits for a free frame
+	                                when two are already queued
+	SDL_VIDEO_PRESENT_THREAD=drop   SDL_Flip() replaces the oldest
+	                                queued frame instead of waiting
+
+   The driver is called from the present thread, so this is only done for
+   drivers that set present_any_thread, like fbcon, dispmanx and dummy;
+   with any other driver SDL_Flip() presents the frame itself as usual.
+   SDL_UpdateRects() and anything else that goes to the video surface
+   waits for the queued frames to be shown first.  Palettized and
+   OpenGL modes are always presented by SDL_Flip() itself.
+*/
+
+#include "SDL_video.h"
+#include "SDL_thread.h"
+#include "SDL_sysvideo.h"
+#include "SDL_blit.h"
+#include "SDL_pixels_c.h"
+#include "SDL_cursor_c.h"
+#include "SDL_damage_c.h"
+#include "SDL_present_c.h"
+#include "SDL_timing_c.h"
+
+#if !SDL_THREADS_DISABLED
+
+#define PRESENT_FRAMES	3
+
+enum {
+	PRESENT_OFF,
+	PRESENT_BLOCK,
+	PRESENT_DROP
+};
+
+enum {
+	FRAME_FREE,
+	FRAME_FILLING,
+	FRAME_QUEUED,
+	FRAME_SHOWING
+};
+
+typedef struct {
+	SDL_Surface *surface;
+	int state;
+	Uint32 seq;
+} SDL_QueuedFrame;
+
+static int present_policy = PRESENT_OFF;
+static SDL_Thread *present_thread = NULL;
+static Uint32 present_thread_id = 0;
+static SDL_mutex *present_lock = NULL;
+static SDL_cond *present_cond = NULL;
+static SDL_QueuedFrame frames[PRESENT_FRAMES];
+static Uint32 present_seq = 0;
+static int present_quit = 0;
+
+/* Convert a frame onto the video surface and show it */
+static void ShowFrame(SDL_Surface *frame)
+{
+	SDL_VideoDevice *this = current_video;
+	int drawcursor = SHOULD_DRAWCURSOR(SDL_cursorstate);
+	SDL_Rect rect;
+	SDL_TimingStamp step;
+
+	rect.x = 0;
+	rect.y = 0;
+	rect.w = frame->w;
+	rect.h = frame->h;
+
+	/* The cursor code draws on the video surface and calls the driver
+	   from the application and event threads */
+	if ( drawcursor ) {
+		SDL_LockCursor();
+	}
+	step = SDL_TimingStart();
+	SDL_LowerBlit(frame, &rect, SDL_VideoSurface, &rect);
+	SDL_TimingEnd(SDL_TIMING_CONVERT, step);
+	if ( (SDL_VideoSurface->flags & SDL_DOUBLEBUF) == SDL_DOUBLEBUF ) {
+		step = SDL_TimingStart();
+		this->FlipHWSurface(this, SDL_VideoSurface);
+		SDL_TimingEnd(SDL_TIMING_DRIVER_FLIP, step);
+	} else {
+		SDL_UpdateRect(SDL_VideoSurface, 0, 0, 0, 0);
+	}
+	if ( drawcursor ) {
+		SDL_UnlockCursor();
+	}
+}
+
+/* The oldest frame in the given state, or NULL */
+static SDL_QueuedFrame *OldestFrame(int state)
+{
+	SDL_QueuedFrame *oldest = NULL;
+	int i;
+
+	for ( i = 0; i < PRESENT_FRAMES; ++i ) {
+		if ( frames[i].state == state &&
+		     (!oldest || (Sint32)(frames[i].seq - oldest->seq) < 0) ) {
+			oldest = &frames[i];
+		}
+	}
+	return(oldest);
+}
+
+static int SDLCALL PresentThread(void *unused)
+{
+	SDL_QueuedFrame *frame;
+
+	SDL_mutexP(present_lock);
+	for ( ; ; ) {
+		while ( !(frame = OldestFrame(FRAME_QUEUED)) && !present_quit ) {
+			SDL_CondWait(present_cond, present_lock);
+		}
+		/* Show the queued frames before quitting */
+		if ( !frame ) {
+			break;
+		}
+		frame->state = FRAME_SHOWING;
+		SDL_mutexV(present_lock);
+
+		ShowFrame(frame->surface);
+
+		SDL_mutexP(present_lock);
+		frame->state = FRAME_FREE;
+		SDL_CondBroadcast(present_cond);
+	}
+	SDL_mutexV(present_lock);
+	return(0);
+}
+
+static int PresentStart(SDL_Surface *shadow)
+{
+	SDL_PixelFormat *fmt = shadow->format;
+	int i;
+
+	present_quit = 0;
+	present_lock = SDL_CreateMutex();
+	present_cond = SDL_CreateCond();
+	if ( !present_lock || !present_cond ) {
+		goto failed;
+	}
+	for ( i = 0; i < PRESENT_FRAMES; ++i ) {
+		frames[i].surface = SDL_CreateRGBSurface(
+			SDL_SWSURFACE | (shadow->flags & SDL_SIMDALIGNED),
+			shadow->w, shadow->h, fmt->BitsPerPixel,
+			fmt->Rmask, fmt->Gmask, fmt->Bmask, fmt->Amask);
+		if ( !frames[i].surface ) {
+			goto failed;
+		}
+		frames[i].state = FRAME_FREE;
+	}
+	present_thread = SDL_CreateThread(PresentThread, NULL);
+	if ( !present_thread ) {
+		goto failed;
+	}
+	present_thread_id = SDL_GetThreadID(present_thread);
+	return(0);
+
+failed:
+	SDL_PresentQuit();
+	return(-1);
+}
+
+static void CopyFrame(SDL_Surface *shadow, SDL_Surface *frame)
+{
+	Uint8 *src = (Uint8 *)shadow->pixels;
+	Uint8 *dst = (Uint8 *)frame->pixels;
+	int len = shadow->w * shadow->format->BytesPerPixel;
+	int h;
+
+	if ( shadow->pitch == frame->pitch ) {
+		SDL_memcpy(dst, src, shadow->h * shadow->pitch);
+		return;
+	}
+	for ( h = shadow->h; h; --h ) {
+		SDL_memcpy(dst, src, len);
+		src += shadow->pitch;
+		dst += frame->pitch;
+	}
+}
+
+void SDL_PresentInit(void)
+{
+	const char *env = SDL_getenv("SDL_VIDEO_PRESENT_THREAD");
+
+	present_policy = PRESENT_OFF;
+	if ( env && current_video->present_any_thread ) {
+		if ( SDL_strcasecmp(env, "drop") == 0 ) {
+			present_policy = PRESENT_DROP;
+		} else if ( SDL_strcasecmp(env, "block") == 0 ||
+		            SDL_atoi(env) ) {
+			present_policy = PRESENT_BLOCK;
+		}
+	}
+}
+
+void SDL_PresentQuit(void)
+{
+	int i;
+
+	if ( present_thread ) {
+		SDL_mutexP(present_lock);
+		present_quit = 1;
+		SDL_CondBroadcast(present_cond);
+		SDL_mutexV(present_lock);
+		SDL_WaitThread(present_thread, NULL);
+		present_thread = NULL;
+		present_thread_id = 0;
+	}
+	for ( i = 0; i < PRESENT_FRAMES; ++i ) {
+		if ( frames[i].surface ) {
+			SDL_FreeSurface(frames[i].surface);
+			frames[i].surface = NULL;
+		}
+	}
+	if ( present_cond ) {
+		SDL_DestroyCond(present_cond);
+		present_cond = NULL;
+	}
+	if ( present_lock ) {
+		SDL_DestroyMutex(present_lock);
+		present_lock = NULL;
+	}
+}
+
+int SDL_PresentFrame(SDL_Surface *shadow)
+{
+	SDL_QueuedFrame *frame;
+	SDL_Surface *surface;
+
+	/* The physical palette and OpenGL can't be left to another thread */
+	if ( present_policy == PRESENT_OFF || shadow->format->palette ||
+	     (shadow->flags & (SDL_SRCALPHA|SDL_SRCCOLORKEY)) ||
+	     (SDL_VideoSurface->flags & SDL_OPENGL) ) {
+		return(-1);
+	}
+	if ( !present_thread && PresentStart(shadow) < 0 ) {
+		/* Don't try again every frame */
+		present_policy = PRESENT_OFF;
+		return(-1);
+	}
+
+	SDL_mutexP(present_lock);
+	frame = OldestFrame(FRAME_FREE);
+	if ( !frame && present_policy == PRESENT_DROP ) {
+		frame = OldestFrame(FRAME_QUEUED);
+		if ( frame ) {
+			++SDL_update_stats.frames_dropped;
+		}
+	}
+	if ( !frame ) {
+		++SDL_update_stats.frames_waited;
+		while ( !(frame = OldestFrame(FRAME_FREE)) ) {
+			SDL_CondWait(present_cond, present_lock);
+		}
+	}
+	frame->state = FRAME_FILLING;
+	SDL_mutexV(present_lock);
+
+	/* Map it here, so the present thread only ever blits */
+	surface = frame->surface;
+	if ( (surface->map->dst != SDL_VideoSurface) ||
+	     (SDL_VideoSurface->format_version != surface->map->format_version) ) {
+		SDL_MapSurface(surface, SDL_VideoSurface);
+	}
+
+	if ( SHOULD_DRAWCURSOR(SDL_cursorstate) ) {
+		SDL_LockCursor();
+		SDL_DrawCursor(shadow);
+		CopyFrame(shadow, surface);
+		SDL_EraseCursor(shadow);
+		SDL_UnlockCursor();
+	} else {
+		CopyFrame(shadow, surface);
+	}
+
+	SDL_mutexP(present_lock);
+	frame->state = FRAME_QUEUED;
+	frame->seq = ++present_seq;
+	++SDL_update_stats.frames_queued;
+	SDL_CondBroadcast(present_cond);
+	SDL_mutexV(present_lock);
+	return(0);
+}
+
+void SDL_PresentWait(void)
+{
+	if ( !present_thread || SDL_ThreadID() == present_thread_id ) {
+		return;
+	}
+	SDL_mutexP(present_lock);
+	while ( OldestFrame(FRAME_QUEUED) || OldestFrame(FRAME_SHOWING) ) {
+		SDL_CondWait(present_cond, present_lock);
+	}
+	SDL_mutexV(present_lock);
+}
+
+#else
+void SDL_PresentInit(void)
+{
+}
+
+void SDL_PresentQuit(void)
+{
+}
+
+int SDL_PresentFrame(SDL_Surface *shadow)
+{
+	return(-1);
+}
+
+void SDL_PresentWait(void)
+{
+}
+#endif /* !SDL_THREADS_DISABLED */
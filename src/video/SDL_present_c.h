@@ -0,0 +1,44 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Presenting the shadow surface on a separate thread, in SDL_present.c */
+
+extern void SDL_PresentInit(void);
+
+/* Stop the present thread and free its frames, after showing the ones
+   that are queued.  This is called on video mode changes too; the thread
+   starts again with the next SDL_Flip().
+ */
+extern void SDL_PresentQuit(void);
+
+/* Queue a copy of the shadow surface to be converted and shown by the
+   present thread.  Returns 0 if it was queued, or -1 if SDL_Flip() has
+   to show it itself.
+ */
+extern int SDL_PresentFrame(SDL_Surface *shadow);
+
+/* Wait until the queued frames have been shown.  Call this before
+   touching the video surface or calling the driver from the application
+   thread.  Does nothing when called from the present thread itself.
+ */
+extern void SDL_PresentWait(void);
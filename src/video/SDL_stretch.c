@@ -28,8 +28,16 @@
 */
 
 #include "SDL_video.h"
+#include "SDL_cpuinfo.h"
 #include "SDL_blit.h"
 
+#if SDL_SSE2_BLITTERS
+#include <emmintrin.h>
+#endif
+#if SDL_ARM_NEON_BLITTERS
+#include <arm_neon.h>
+#endif
+
 /* This isn't ready for general consumption yet - it should be folded
    into the general blitting mechanism.
 */
@@ -173,34 +181,428 @@ DEFINE_COPY_ROW(copy_row1, Uint8)
 DEFINE_COPY_ROW(copy_row2, Uint16)
 DEFINE_COPY_ROW(copy_row4, Uint32)
 
-/* The ASM code doesn't handle 24-bpp stretch blits */
+/* The ASM code doesn't handle 24-bpp stretch blits, so once the
+   destination is aligned this packs 4 pixels into 3 32-bit stores.
+   The source pixel for output column i is ((i * inc) >> 16), the same
+   one the stepping loop in the copy_row functions above would pick.
+ */
+#define NEXT_PIXEL3()					\
+	pixel = src + (pos >> 16) * 3;			\
+	pos += inc;
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#define PACK_PIXEL3(p)	((Uint32)p[0] | ((Uint32)p[1] << 8) | ((Uint32)p[2] << 16))
+#else
+#define PACK_PIXEL3(p)	(((Uint32)p[0] << 16) | ((Uint32)p[1] << 8) | (Uint32)p[2])
+#endif
+
 void copy_row3(Uint8 *src, int src_w, Uint8 *dst, int dst_w)
 {
 	int i;
 	int pos, inc;
-	Uint8 pixel[3] = { 0, 0, 0 };
+	Uint8 *pixel;
+	Uint32 p0, p1, p2, p3;
+	Uint32 *dst32;
 
-	pos = 0x10000;
+	pos = 0;
 	inc = (src_w << 16) / dst_w;
-	for ( i=dst_w; i>0; --i ) {
-		while ( pos >= 0x10000L ) {
-			pixel[0] = *src++;
-			pixel[1] = *src++;
-			pixel[2] = *src++;
-			pos -= 0x10000L;
-		}
+	for ( i=dst_w; (i > 0) && ((uintptr_t)dst & 3); --i ) {
+		NEXT_PIXEL3();
+		*dst++ = pixel[0];
+		*dst++ = pixel[1];
+		*dst++ = pixel[2];
+	}
+	dst32 = (Uint32 *)dst;
+	for ( ; i >= 4; i -= 4 ) {
+		NEXT_PIXEL3();
+		p0 = PACK_PIXEL3(pixel);
+		NEXT_PIXEL3();
+		p1 = PACK_PIXEL3(pixel);
+		NEXT_PIXEL3();
+		p2 = PACK_PIXEL3(pixel);
+		NEXT_PIXEL3();
+		p3 = PACK_PIXEL3(pixel);
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+		dst32[0] = p0 | (p1 << 24);
+		dst32[1] = (p1 >> 8) | (p2 << 16);
+		dst32[2] = (p2 >> 16) | (p3 << 8);
+#else
+		dst32[0] = (p0 << 8) | (p1 >> 16);
+		dst32[1] = (p1 << 16) | (p2 >> 8);
+		dst32[2] = (p2 << 24) | p3;
+#endif
+		dst32 += 3;
+	}
+	dst = (Uint8 *)dst32;
+	for ( ; i > 0; --i ) {
+		NEXT_PIXEL3();
 		*dst++ = pixel[0];
 		*dst++ = pixel[1];
 		*dst++ = pixel[2];
-		pos += inc;
 	}
 }
 
-/* Perform a stretch blit between two surfaces of the same format.
-   NOTE:  This function is not safe to call from multiple threads!
+#undef NEXT_PIXEL3
+#undef PACK_PIXEL3
+
+/*
+ * Integer factor scaling
+ *
+ * When the destination is an exact multiple of the source each source
+ * pixel is simply replicated, so the first output row of each source row
+ * is widened with SIMD shuffles and the rest are copied from it.
+ */
+typedef void (*SDL_ScaleRowFunc)(const Uint8 *src, Uint8 *dst, int width);
+
+#define DEFINE_SCALE_ROW(name, type)					\
+static void name(const Uint8 *srcp, Uint8 *dstp, int width, int factor)	\
+{									\
+	const type *src = (const type *)srcp;				\
+	type *dst = (type *)dstp;					\
+	type pixel;							\
+	int i, j;							\
+									\
+	for ( i = width; i > 0; --i ) {					\
+		pixel = *src++;						\
+		for ( j = factor; j > 0; --j ) {			\
+			*dst++ = pixel;					\
+		}							\
+	}								\
+}
+DEFINE_SCALE_ROW(scale_row1, Uint8)
+DEFINE_SCALE_ROW(scale_row2, Uint16)
+DEFINE_SCALE_ROW(scale_row4, Uint32)
+
+static void scale_row3(const Uint8 *src, Uint8 *dst, int width, int factor)
+{
+	int i, j;
+
+	for ( i = width; i > 0; --i ) {
+		for ( j = factor; j > 0; --j ) {
+			dst[0] = src[0];
+			dst[1] = src[1];
+			dst[2] = src[2];
+			dst += 3;
+		}
+		src += 3;
+	}
+}
+
+static void ScaleRowC(const Uint8 *src, Uint8 *dst,
+                      int width, int bpp, int factor)
+{
+	switch (bpp) {
+	    case 1:
+		scale_row1(src, dst, width, factor);
+		break;
+	    case 2:
+		scale_row2(src, dst, width, factor);
+		break;
+	    case 3:
+		scale_row3(src, dst, width, factor);
+		break;
+	    case 4:
+		scale_row4(src, dst, width, factor);
+		break;
+	}
+}
+
+#if SDL_SSE2_BLITTERS
+static void Scale8x2SSE2(const Uint8 *src, Uint8 *dst, int width)
+{
+	int i;
+
+	for ( i = 0; i+16 <= width; i += 16 ) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src+i));
+		__m128i *d = (__m128i *)(dst+i*2);
+		_mm_storeu_si128(d+0, _mm_unpacklo_epi8(v, v));
+		_mm_storeu_si128(d+1, _mm_unpackhi_epi8(v, v));
+	}
+	scale_row1(src+i, dst+i*2, width-i, 2);
+}
+
+static void Scale8x4SSE2(const Uint8 *src, Uint8 *dst, int width)
+{
+	int i;
+
+	for ( i = 0; i+16 <= width; i += 16 ) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src+i));
+		__m128i lo = _mm_unpacklo_epi8(v, v);
+		__m128i hi = _mm_unpackhi_epi8(v, v);
+		__m128i *d = (__m128i *)(dst+i*4);
+		_mm_storeu_si128(d+0, _mm_unpacklo_epi16(lo, lo));
+		_mm_storeu_si128(d+1, _mm_unpackhi_epi16(lo, lo));
+		_mm_storeu_si128(d+2, _mm_unpacklo_epi16(hi, hi));
+		_mm_storeu_si128(d+3, _mm_unpackhi_epi16(hi, hi));
+	}
+	scale_row1(src+i, dst+i*4, width-i, 4);
+}
+
+static void Scale16x2SSE2(const Uint8 *src, Uint8 *dst, int width)
+{
+	int i;
+
+	for ( i = 0; i+8 <= width; i += 8 ) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src+i*2));
+		__m128i *d = (__m128i *)(dst+i*4);
+		_mm_storeu_si128(d+0, _mm_unpacklo_epi16(v, v));
+		_mm_storeu_si128(d+1, _mm_unpackhi_epi16(v, v));
+	}
+	scale_row2(src+i*2, dst+i*4, width-i, 2);
+}
+
+static void Scale16x4SSE2(const Uint8 *src, Uint8 *dst, int width)
+{
+	int i;
+
+	for ( i = 0; i+8 <= width; i += 8 ) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src+i*2));
+		__m128i lo = _mm_unpacklo_epi16(v, v);
+		__m128i hi = _mm_unpackhi_epi16(v, v);
+		__m128i *d = (__m128i *)(dst+i*8);
+		_mm_storeu_si128(d+0, _mm_unpacklo_epi32(lo, lo));
+		_mm_storeu_si128(d+1, _mm_unpackhi_epi32(lo, lo));
+		_mm_storeu_si128(d+2, _mm_unpacklo_epi32(hi, hi));
+		_mm_storeu_si128(d+3, _mm_unpackhi_epi32(hi, hi));
+	}
+	scale_row2(src+i*2, dst+i*8, width-i, 4);
+}
+
+static void Scale32x2SSE2(const Uint8 *src, Uint8 *dst, int width)
+{
+	int i;
+
+	for ( i = 0; i+4 <= width; i += 4 ) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src+i*4));
+		__m128i *d = (__m128i *)(dst+i*8);
+		_mm_storeu_si128(d+0, _mm_unpacklo_epi32(v, v));
+		_mm_storeu_si128(d+1, _mm_unpackhi_epi32(v, v));
+	}
+	scale_row4(src+i*4, dst+i*8, width-i, 2);
+}
+
+static void Scale32x3SSE2(const Uint8 *src, Uint8 *dst, int width)
+{
+	int i;
+
+	for ( i = 0; i+4 <= width; i += 4 ) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src+i*4));
+		__m128i *d = (__m128i *)(dst+i*12);
+		_mm_storeu_si128(d+0, _mm_shuffle_epi32(v, _MM_SHUFFLE(1,0,0,0)));
+		_mm_storeu_si128(d+1, _mm_shuffle_epi32(v, _MM_SHUFFLE(2,2,1,1)));
+		_mm_storeu_si128(d+2, _mm_shuffle_epi32(v, _MM_SHUFFLE(3,3,3,2)));
+	}
+	scale_row4(src+i*4, dst+i*12, width-i, 3);
+}
+
+static void Scale32x4SSE2(const Uint8 *src, Uint8 *dst, int width)
+{
+	int i;
+
+	for ( i = 0; i+4 <= width; i += 4 ) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src+i*4));
+		__m128i *d = (__m128i *)(dst+i*16);
+		_mm_storeu_si128(d+0, _mm_shuffle_epi32(v, _MM_SHUFFLE(0,0,0,0)));
+		_mm_storeu_si128(d+1, _mm_shuffle_epi32(v, _MM_SHUFFLE(1,1,1,1)));
+		_mm_storeu_si128(d+2, _mm_shuffle_epi32(v, _MM_SHUFFLE(2,2,2,2)));
+		_mm_storeu_si128(d+3, _mm_shuffle_epi32(v, _MM_SHUFFLE(3,3,3,3)));
+	}
+	scale_row4(src+i*4, dst+i*16, width-i, 4);
+}
+#endif /* SDL_SSE2_BLITTERS */
+
+#if SDL_ARM_NEON_BLITTERS
+/* The interleaving stores write each loaded pixel N times in a row */
+#define DEFINE_SCALE_NEON(name, type, vtype, vtypeN, load, store, lanes, \
+                          scalar, factor)				\
+static void name(const Uint8 *srcp, Uint8 *dstp, int width)		\
+{									\
+	const type *src = (const type *)srcp;				\
+	type *dst = (type *)dstp;					\
+	vtypeN v;							\
+	int i, j;							\
+									\
+	for ( i = 0; i+lanes <= width; i += lanes ) {			\
+		vtype p = load(src+i);					\
+		for ( j = 0; j < factor; ++j ) {			\
+			v.val[j] = p;					\
+		}							\
+		store(dst+i*factor, v);					\
+	}								\
+	scalar((const Uint8 *)(src+i), (Uint8 *)(dst+i*factor),	\
+	       width-i, factor);					\
+}
+DEFINE_SCALE_NEON(Scale8x2NEON, Uint8, uint8x16_t, uint8x16x2_t,
+                  vld1q_u8, vst2q_u8, 16, scale_row1, 2)
+DEFINE_SCALE_NEON(Scale8x3NEON, Uint8, uint8x16_t, uint8x16x3_t,
+                  vld1q_u8, vst3q_u8, 16, scale_row1, 3)
+DEFINE_SCALE_NEON(Scale8x4NEON, Uint8, uint8x16_t, uint8x16x4_t,
+                  vld1q_u8, vst4q_u8, 16, scale_row1, 4)
+DEFINE_SCALE_NEON(Scale16x2NEON, Uint16, uint16x8_t, uint16x8x2_t,
+                  vld1q_u16, vst2q_u16, 8, scale_row2, 2)
+DEFINE_SCALE_NEON(Scale16x3NEON, Uint16, uint16x8_t, uint16x8x3_t,
+                  vld1q_u16, vst3q_u16, 8, scale_row2, 3)
+DEFINE_SCALE_NEON(Scale16x4NEON, Uint16, uint16x8_t, uint16x8x4_t,
+                  vld1q_u16, vst4q_u16, 8, scale_row2, 4)
+DEFINE_SCALE_NEON(Scale32x2NEON, Uint32, uint32x4_t, uint32x4x2_t,
+                  vld1q_u32, vst2q_u32, 4, scale_row4, 2)
+DEFINE_SCALE_NEON(Scale32x3NEON, Uint32, uint32x4_t, uint32x4x3_t,
+                  vld1q_u32, vst3q_u32, 4, scale_row4, 3)
+DEFINE_SCALE_NEON(Scale32x4NEON, Uint32, uint32x4_t, uint32x4x4_t,
+                  vld1q_u32, vst4q_u32, 4, scale_row4, 4)
+#endif /* SDL_ARM_NEON_BLITTERS */
+
+/* Row scalers for 1, 2 and 4 bytes per pixel by factors 2, 3 and 4 */
+#if SDL_ARM_NEON_BLITTERS
+static const SDL_ScaleRowFunc scale_neon[3][3] = {
+	{ Scale8x2NEON, Scale8x3NEON, Scale8x4NEON },
+	{ Scale16x2NEON, Scale16x3NEON, Scale16x4NEON },
+	{ Scale32x2NEON, Scale32x3NEON, Scale32x4NEON }
+};
+#endif
+#if SDL_SSE2_BLITTERS
+static const SDL_ScaleRowFunc scale_sse2[3][3] = {
+	{ Scale8x2SSE2, NULL, Scale8x4SSE2 },
+	{ Scale16x2SSE2, NULL, Scale16x4SSE2 },
+	{ Scale32x2SSE2, Scale32x3SSE2, Scale32x4SSE2 }
+};
+#endif
+
+static SDL_ScaleRowFunc GetScaleRowFunc(int bpp, int factor)
+{
+	if ( (bpp == 3) || (factor < 2) || (factor > 4) ) {
+		return NULL;
+	}
+#if SDL_ARM_NEON_BLITTERS
+	if ( SDL_HasNEON() ) {
+		return scale_neon[bpp/2][factor-2];
+	}
+#endif
+#if SDL_SSE2_BLITTERS
+	if ( SDL_HasSSE2() ) {
+		return scale_sse2[bpp/2][factor-2];
+	}
+#endif
+	return NULL;
+}
+
+/* Replicate each source pixel xfactor times and each row yfactor times.
+   The surfaces must be locked and the rectangles already validated.
+ */
+static void ScaleInteger(SDL_Surface *src, SDL_Rect *srcrect,
+                         SDL_Surface *dst, SDL_Rect *dstrect,
+                         int xfactor, int yfactor)
+{
+	const int bpp = dst->format->BytesPerPixel;
+	const int rowlen = dstrect->w * bpp;
+	SDL_ScaleRowFunc scale = GetScaleRowFunc(bpp, xfactor);
+	Uint8 *srcp, *dstp;
+	int y, i;
+
+	srcp = (Uint8 *)src->pixels + srcrect->y*src->pitch + srcrect->x*bpp;
+	dstp = (Uint8 *)dst->pixels + dstrect->y*dst->pitch + dstrect->x*bpp;
+	for ( y = srcrect->h; y > 0; --y ) {
+		if ( xfactor == 1 ) {
+			SDL_memcpy(dstp, srcp, rowlen);
+		} else if ( scale ) {
+			scale(srcp, dstp, srcrect->w);
+		} else {
+			ScaleRowC(srcp, dstp, srcrect->w, bpp, xfactor);
+		}
+		for ( i = 1; i < yfactor; ++i ) {
+			SDL_memcpy(dstp + i*dst->pitch, dstp, rowlen);
+		}
+		srcp += src->pitch;
+		dstp += yfactor * dst->pitch;
+	}
+}
+
+int SDL_SoftScaleInteger(SDL_Surface *src, SDL_Rect *srcrect,
+                         SDL_Surface *dst, SDL_Rect *dstrect, int factor)
+{
+	int src_locked;
+	int dst_locked;
+	SDL_Rect full_src;
+	SDL_Rect full_dst;
+
+	if ( src->format->BitsPerPixel != dst->format->BitsPerPixel ) {
+		SDL_SetError("Only works with same format surfaces");
+		return(-1);
+	}
+	if ( factor < 1 ) {
+		SDL_SetError("Invalid scale factor");
+		return(-1);
+	}
+
+	/* Verify the blit rectangles */
+	if ( srcrect ) {
+		if ( (srcrect->x < 0) || (srcrect->y < 0) ||
+		     ((srcrect->x+srcrect->w) > src->w) ||
+		     ((srcrect->y+srcrect->h) > src->h) ) {
+			SDL_SetError("Invalid source blit rectangle");
+			return(-1);
+		}
+	} else {
+		full_src.x = 0;
+		full_src.y = 0;
+		full_src.w = src->w;
+		full_src.h = src->h;
+		srcrect = &full_src;
+	}
+	if ( !dstrect ) {
+		full_dst.x = 0;
+		full_dst.y = 0;
+		dstrect = &full_dst;
+	}
+	dstrect->w = srcrect->w * factor;
+	dstrect->h = srcrect->h * factor;
+	if ( (dstrect->x < 0) || (dstrect->y < 0) ||
+	     ((dstrect->x+dstrect->w) > dst->w) ||
+	     ((dstrect->y+dstrect->h) > dst->h) ) {
+		SDL_SetError("Invalid destination blit rectangle");
+		return(-1);
+	}
+
+	/* Lock the destination if it's in hardware */
+	dst_locked = 0;
+	if ( SDL_MUSTLOCK(dst) ) {
+		if ( SDL_LockSurface(dst) < 0 ) {
+			SDL_SetError("Unable to lock destination surface");
+			return(-1);
+		}
+		dst_locked = 1;
+	}
+	/* Lock the source if it's in hardware */
+	src_locked = 0;
+	if ( SDL_MUSTLOCK(src) ) {
+		if ( SDL_LockSurface(src) < 0 ) {
+			if ( dst_locked ) {
+				SDL_UnlockSurface(dst);
+			}
+			SDL_SetError("Unable to lock source surface");
+			return(-1);
+		}
+		src_locked = 1;
+	}
+
+	ScaleInteger(src, srcrect, dst, dstrect, factor, factor);
+
+	/* We need to unlock the surfaces if they're locked */
+	if ( dst_locked ) {
+		SDL_UnlockSurface(dst);
+	}
+	if ( src_locked ) {
+		SDL_UnlockSurface(src);
+	}
+	return(0);
+}
+
+/* Perform a stretch blit between two surfaces of the same format,
+   with the generated copy_row code if 'allow_asm' is set.
 */
-int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
-                    SDL_Surface *dst, SDL_Rect *dstrect)
+static int SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
+                       SDL_Surface *dst, SDL_Rect *dstrect,
+                       SDL_bool allow_asm)
 {
 	int src_locked;
 	int dst_locked;
@@ -212,7 +614,7 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 	SDL_Rect full_src;
 	SDL_Rect full_dst;
 #ifdef USE_ASM_STRETCH
-	SDL_bool use_asm = SDL_TRUE;
+	SDL_bool use_asm = allow_asm;
 #ifdef __GNUC__
 	int u1, u2;
 #endif
@@ -276,6 +678,26 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 		src_locked = 1;
 	}
 
+	/* Exact multiples of the source size just replicate pixels.  This
+	   gives every source pixel exactly the same width and height, where
+	   the 16.16 stepping below rounds the step down and drifts, so for
+	   factors that aren't powers of two (3x, 5x...) some pixels come out
+	   one row or column wider or narrower than the others.  The output
+	   differs from older SDL versions for those sizes.
+	 */
+	if ( srcrect->w && srcrect->h && dstrect->w && dstrect->h &&
+	     (dstrect->w % srcrect->w) == 0 && (dstrect->h % srcrect->h) == 0 ) {
+		ScaleInteger(src, srcrect, dst, dstrect,
+		             dstrect->w / srcrect->w, dstrect->h / srcrect->h);
+		if ( dst_locked ) {
+			SDL_UnlockSurface(dst);
+		}
+		if ( src_locked ) {
+			SDL_UnlockSurface(src);
+		}
+		return(0);
+	}
+
 	/* Set up the data... */
 	pos = 0x10000;
 	inc = (srcrect->h << 16) / dstrect->h;
@@ -284,8 +706,8 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 
 #ifdef USE_ASM_STRETCH
 	/* Write the opcodes for this stretch */
-	if ( (bpp == 3) ||
-	     (generate_rowbytes(srcrect->w, dstrect->w, bpp) < 0) ) {
+	if ( use_asm && ((bpp == 3) ||
+	     (generate_rowbytes(srcrect->w, dstrect->w, bpp) < 0)) ) {
 		use_asm = SDL_FALSE;
 	}
 #endif
@@ -356,3 +778,462 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 	return(0);
 }
 
+/* NOTE:  With USE_ASM_STRETCH this function is not safe to call from
+          multiple threads, use SDL_SoftStretchFilter() for that.
+*/
+int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
+                    SDL_Surface *dst, SDL_Rect *dstrect)
+{
+	return SoftStretch(src, srcrect, dst, dstrect, SDL_TRUE);
+}
+
+
+/*
+ * Filtered stretch blits
+ *
+ * Source rows are unpacked to 0xAARRGGBB, blended vertically into a row
+ * buffer, blended horizontally into a second row buffer, and then packed
+ * into the destination format.  All state lives on the stack or in a
+ * per-call allocation, so this is safe to use from multiple threads.
+ *
+ * Blends are computed per channel as (a*(256-f) + b*f) >> 8 with 8-bit
+ * weights, which the SIMD versions below reproduce exactly.
+ */
+
+typedef void (*SDL_StretchVBlend)(const Uint32 *a, const Uint32 *b,
+                                  Uint32 *dst, int width, int f);
+typedef void (*SDL_StretchHBlend)(const Uint32 *row, const int *x0,
+                                  const int *x1, const Uint16 *fx,
+                                  Uint32 *dst, int width);
+
+static __inline__ Uint32 LerpARGB(Uint32 a, Uint32 b, int f)
+{
+	Uint32 rb, ag;
+
+	rb = ((a & 0x00ff00ff) * (256-f) + (b & 0x00ff00ff) * f) >> 8;
+	ag = ((a >> 8) & 0x00ff00ff) * (256-f) + ((b >> 8) & 0x00ff00ff) * f;
+	return (rb & 0x00ff00ff) | (ag & 0xff00ff00);
+}
+
+static void VBlendC(const Uint32 *a, const Uint32 *b,
+                    Uint32 *dst, int width, int f)
+{
+	int i;
+
+	for ( i = 0; i < width; ++i ) {
+		dst[i] = LerpARGB(a[i], b[i], f);
+	}
+}
+
+static void HBlendC(const Uint32 *row, const int *x0, const int *x1,
+                    const Uint16 *fx, Uint32 *dst, int width)
+{
+	int i;
+
+	for ( i = 0; i < width; ++i ) {
+		dst[i] = LerpARGB(row[x0[i]], row[x1[i]], fx[i]);
+	}
+}
+
+#if SDL_SSE2_BLITTERS
+static void VBlendSSE2(const Uint32 *a, const Uint32 *b,
+                       Uint32 *dst, int width, int f)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i wa = _mm_set1_epi16((short)(256-f));
+	const __m128i wb = _mm_set1_epi16((short)f);
+	int i;
+
+	for ( i = 0; i+4 <= width; i += 4 ) {
+		__m128i va = _mm_loadu_si128((const __m128i *)(a+i));
+		__m128i vb = _mm_loadu_si128((const __m128i *)(b+i));
+		__m128i lo = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+			_mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb));
+		__m128i hi = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+			_mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb));
+		lo = _mm_srli_epi16(lo, 8);
+		hi = _mm_srli_epi16(hi, 8);
+		_mm_storeu_si128((__m128i *)(dst+i), _mm_packus_epi16(lo, hi));
+	}
+	VBlendC(a+i, b+i, dst+i, width-i, f);
+}
+
+static void HBlendSSE2(const Uint32 *row, const int *x0, const int *x1,
+                       const Uint16 *fx, Uint32 *dst, int width)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i w256 = _mm_set1_epi16(256);
+	int i;
+
+	for ( i = 0; i+4 <= width; i += 4 ) {
+		__m128i va = _mm_set_epi32(row[x0[i+3]], row[x0[i+2]],
+		                           row[x0[i+1]], row[x0[i]]);
+		__m128i vb = _mm_set_epi32(row[x1[i+3]], row[x1[i+2]],
+		                           row[x1[i+1]], row[x1[i]]);
+		__m128i wlo = _mm_set_epi16(fx[i+1], fx[i+1], fx[i+1], fx[i+1],
+		                            fx[i], fx[i], fx[i], fx[i]);
+		__m128i whi = _mm_set_epi16(fx[i+3], fx[i+3], fx[i+3], fx[i+3],
+		                            fx[i+2], fx[i+2], fx[i+2], fx[i+2]);
+		__m128i lo = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero),
+			                _mm_sub_epi16(w256, wlo)),
+			_mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wlo));
+		__m128i hi = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero),
+			                _mm_sub_epi16(w256, whi)),
+			_mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), whi));
+		lo = _mm_srli_epi16(lo, 8);
+		hi = _mm_srli_epi16(hi, 8);
+		_mm_storeu_si128((__m128i *)(dst+i), _mm_packus_epi16(lo, hi));
+	}
+	HBlendC(row, x0+i, x1+i, fx+i, dst+i, width-i);
+}
+#endif /* SDL_SSE2_BLITTERS */
+
+#if SDL_ARM_NEON_BLITTERS
+static void VBlendNEON(const Uint32 *a, const Uint32 *b,
+                       Uint32 *dst, int width, int f)
+{
+	const uint16x8_t wa = vdupq_n_u16((uint16_t)(256-f));
+	const uint16x8_t wb = vdupq_n_u16((uint16_t)f);
+	int i;
+
+	for ( i = 0; i+4 <= width; i += 4 ) {
+		uint8x16_t va = vld1q_u8((const uint8_t *)(a+i));
+		uint8x16_t vb = vld1q_u8((const uint8_t *)(b+i));
+		uint16x8_t lo = vmulq_u16(vmovl_u8(vget_low_u8(va)), wa);
+		uint16x8_t hi = vmulq_u16(vmovl_u8(vget_high_u8(va)), wa);
+		lo = vmlaq_u16(lo, vmovl_u8(vget_low_u8(vb)), wb);
+		hi = vmlaq_u16(hi, vmovl_u8(vget_high_u8(vb)), wb);
+		vst1q_u8((uint8_t *)(dst+i),
+		         vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+	}
+	VBlendC(a+i, b+i, dst+i, width-i, f);
+}
+
+static void HBlendNEON(const Uint32 *row, const int *x0, const int *x1,
+                       const Uint16 *fx, Uint32 *dst, int width)
+{
+	const uint16x8_t w256 = vdupq_n_u16(256);
+	Uint32 pa[2], pb[2];
+	Uint16 w[8];
+	int i;
+
+	for ( i = 0; i+2 <= width; i += 2 ) {
+		uint16x8_t wv, va, vb;
+
+		pa[0] = row[x0[i]]; pa[1] = row[x0[i+1]];
+		pb[0] = row[x1[i]]; pb[1] = row[x1[i+1]];
+		w[0] = w[1] = w[2] = w[3] = fx[i];
+		w[4] = w[5] = w[6] = w[7] = fx[i+1];
+		wv = vld1q_u16(w);
+		va = vmovl_u8(vld1_u8((const uint8_t *)pa));
+		vb = vmovl_u8(vld1_u8((const uint8_t *)pb));
+		va = vmlaq_u16(vmulq_u16(va, vsubq_u16(w256, wv)), vb, wv);
+		vst1_u8((uint8_t *)(dst+i), vshrn_n_u16(va, 8));
+	}
+	HBlendC(row, x0+i, x1+i, fx+i, dst+i, width-i);
+}
+#endif /* SDL_ARM_NEON_BLITTERS */
+
+/* Unpack a row of source pixels to 0xAARRGGBB */
+static void UnpackRow(const Uint8 *src, int width,
+                      SDL_PixelFormat *fmt, Uint32 *dst)
+{
+	const int bpp = fmt->BytesPerPixel;
+	Uint32 Pixel;
+	unsigned r, g, b, a;
+	int i;
+
+	if ( bpp == 1 ) {
+		const SDL_Color *colors = fmt->palette->colors;
+		for ( i = 0; i < width; ++i ) {
+			const SDL_Color *c = &colors[src[i]];
+			dst[i] = 0xff000000 | (c->r << 16) | (c->g << 8) | c->b;
+		}
+		return;
+	}
+	if ( bpp == 4 && fmt->Rmask == 0x00ff0000 &&
+	     fmt->Gmask == 0x0000ff00 && fmt->Bmask == 0x000000ff ) {
+		const Uint32 *srcp = (const Uint32 *)src;
+		if ( fmt->Amask == 0xff000000 ) {
+			SDL_memcpy(dst, srcp, width*4);
+		} else {
+			for ( i = 0; i < width; ++i ) {
+				dst[i] = srcp[i] | 0xff000000;
+			}
+		}
+		return;
+	}
+	for ( i = 0; i < width; ++i ) {
+		DISEMBLE_RGBA(src, bpp, fmt, Pixel, r, g, b, a);
+		if ( !fmt->Amask ) {
+			a = 0xff;
+		}
+		dst[i] = (a << 24) | (r << 16) | (g << 8) | b;
+		src += bpp;
+	}
+}
+
+/* Pack a row of 0xAARRGGBB pixels into the destination format */
+static void PackRow(const Uint32 *src, int width,
+                    SDL_PixelFormat *fmt, Uint8 *dst)
+{
+	const int bpp = fmt->BytesPerPixel;
+	unsigned r, g, b, a;
+	int i;
+
+	if ( bpp == 4 && fmt->Rmask == 0x00ff0000 &&
+	     fmt->Gmask == 0x0000ff00 && fmt->Bmask == 0x000000ff &&
+	     (fmt->Amask == 0xff000000 || !fmt->Amask) ) {
+		Uint32 *dstp = (Uint32 *)dst;
+		const Uint32 mask = 0x00ffffff | fmt->Amask;
+		for ( i = 0; i < width; ++i ) {
+			dstp[i] = src[i] & mask;
+		}
+		return;
+	}
+	if ( bpp == 2 && fmt->Rmask == 0xf800 &&
+	     fmt->Gmask == 0x07e0 && fmt->Bmask == 0x001f ) {
+		Uint16 *dstp = (Uint16 *)dst;
+		for ( i = 0; i < width; ++i ) {
+			const Uint32 p = src[i];
+			dstp[i] = (Uint16)(((p >> 8) & 0xf800) |
+			                   ((p >> 5) & 0x07e0) |
+			                   ((p >> 3) & 0x001f));
+		}
+		return;
+	}
+	for ( i = 0; i < width; ++i ) {
+		a = src[i] >> 24;
+		r = (src[i] >> 16) & 0xff;
+		g = (src[i] >> 8) & 0xff;
+		b = src[i] & 0xff;
+		ASSEMBLE_RGBA(dst, bpp, fmt, r, g, b, a);
+		dst += bpp;
+	}
+}
+
+/* Work out the two source pixels and blend weight for each destination
+   pixel along one axis.
+ */
+static void BuildStretchTable(int src_len, int dst_len,
+                              SDL_StretchFilter filter,
+                              int *i0, int *i1, Uint16 *f)
+{
+	const double scale = (double)src_len / dst_len;
+	int factor = 1;
+	int i, j;
+	double u;
+
+	if ( filter == SDL_STRETCH_SHARP_BILINEAR && dst_len > src_len ) {
+		/* Replicate by the integer factor, then filter the rest */
+		factor = dst_len / src_len;
+	}
+	for ( i = 0; i < dst_len; ++i ) {
+		if ( filter == SDL_STRETCH_NEAREST ) {
+			i0[i] = i1[i] = (int)(i * scale);
+			f[i] = 0;
+			continue;
+		}
+		u = (i + 0.5) * scale * factor - 0.5;
+		if ( u < 0.0 ) {
+			u = 0.0;
+		}
+		j = (int)u;
+		i0[i] = j / factor;
+		i1[i] = (j + 1) / factor;
+		f[i] = (Uint16)((u - j) * 256.0);
+		if ( i1[i] >= src_len ) {
+			i1[i] = src_len - 1;
+		}
+		if ( i0[i] == i1[i] ) {
+			f[i] = 0;
+		}
+	}
+}
+
+int SDL_SoftStretchFilter(SDL_Surface *src, SDL_Rect *srcrect,
+                          SDL_Surface *dst, SDL_Rect *dstrect,
+                          SDL_StretchFilter filter)
+{
+	int src_locked;
+	int dst_locked;
+	SDL_Rect full_src;
+	SDL_Rect full_dst;
+	SDL_StretchVBlend vblend = VBlendC;
+	SDL_StretchHBlend hblend = HBlendC;
+	SDL_PixelFormat *srcfmt = src->format;
+	SDL_PixelFormat *dstfmt = dst->format;
+	Uint8 *mem;
+	Uint32 *rows[2], *vrow, *hrow;
+	int rowidx[2];
+	int *x0, *x1, *y0, *y1;
+	Uint16 *fx, *fy;
+	int x, y, i;
+
+	if ( (filter != SDL_STRETCH_NEAREST) &&
+	     (filter != SDL_STRETCH_BILINEAR) &&
+	     (filter != SDL_STRETCH_SHARP_BILINEAR) ) {
+		SDL_SetError("Unknown stretch filter");
+		return(-1);
+	}
+
+	/* Nearest neighbour between identical formats is a plain stretch,
+	   without the shared generated code SDL_SoftStretch() may use */
+	if ( filter == SDL_STRETCH_NEAREST &&
+	     srcfmt->BitsPerPixel == dstfmt->BitsPerPixel &&
+	     srcfmt->Rmask == dstfmt->Rmask && srcfmt->Gmask == dstfmt->Gmask &&
+	     srcfmt->Bmask == dstfmt->Bmask && srcfmt->Amask == dstfmt->Amask ) {
+		return SoftStretch(src, srcrect, dst, dstrect, SDL_FALSE);
+	}
+	if ( dstfmt->BytesPerPixel == 1 ) {
+		SDL_SetError("Filtered stretch to 8-bit surfaces isn't supported");
+		return(-1);
+	}
+
+	/* Verify the blit rectangles */
+	if ( srcrect ) {
+		if ( (srcrect->x < 0) || (srcrect->y < 0) ||
+		     ((srcrect->x+srcrect->w) > src->w) ||
+		     ((srcrect->y+srcrect->h) > src->h) ) {
+			SDL_SetError("Invalid source blit rectangle");
+			return(-1);
+		}
+	} else {
+		full_src.x = 0;
+		full_src.y = 0;
+		full_src.w = src->w;
+		full_src.h = src->h;
+		srcrect = &full_src;
+	}
+	if ( dstrect ) {
+		if ( (dstrect->x < 0) || (dstrect->y < 0) ||
+		     ((dstrect->x+dstrect->w) > dst->w) ||
+		     ((dstrect->y+dstrect->h) > dst->h) ) {
+			SDL_SetError("Invalid destination blit rectangle");
+			return(-1);
+		}
+	} else {
+		full_dst.x = 0;
+		full_dst.y = 0;
+		full_dst.w = dst->w;
+		full_dst.h = dst->h;
+		dstrect = &full_dst;
+	}
+	if ( !srcrect->w || !srcrect->h || !dstrect->w || !dstrect->h ) {
+		return(0);
+	}
+
+	/* Allocate the row buffers and filter tables */
+	mem = (Uint8 *)SDL_malloc(
+		(2*srcrect->w + srcrect->w + dstrect->w) * sizeof(Uint32) +
+		(2*dstrect->w + 2*dstrect->h) * sizeof(int) +
+		(dstrect->w + dstrect->h) * sizeof(Uint16));
+	if ( !mem ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	rows[0] = (Uint32 *)mem;
+	rows[1] = rows[0] + srcrect->w;
+	vrow = rows[1] + srcrect->w;
+	hrow = vrow + srcrect->w;
+	x0 = (int *)(hrow + dstrect->w);
+	x1 = x0 + dstrect->w;
+	y0 = x1 + dstrect->w;
+	y1 = y0 + dstrect->h;
+	fx = (Uint16 *)(y1 + dstrect->h);
+	fy = fx + dstrect->w;
+	BuildStretchTable(srcrect->w, dstrect->w, filter, x0, x1, fx);
+	BuildStretchTable(srcrect->h, dstrect->h, filter, y0, y1, fy);
+	rowidx[0] = rowidx[1] = -1;
+
+#if SDL_SSE2_BLITTERS
+	if ( SDL_HasSSE2() ) {
+		vblend = VBlendSSE2;
+		hblend = HBlendSSE2;
+	}
+#endif
+#if SDL_ARM_NEON_BLITTERS
+	if ( SDL_HasNEON() ) {
+		vblend = VBlendNEON;
+		hblend = HBlendNEON;
+	}
+#endif
+
+	/* Lock the destination if it's in hardware */
+	dst_locked = 0;
+	if ( SDL_MUSTLOCK(dst) ) {
+		if ( SDL_LockSurface(dst) < 0 ) {
+			SDL_free(mem);
+			SDL_SetError("Unable to lock destination surface");
+			return(-1);
+		}
+		dst_locked = 1;
+	}
+	/* Lock the source if it's in hardware */
+	src_locked = 0;
+	if ( SDL_MUSTLOCK(src) ) {
+		if ( SDL_LockSurface(src) < 0 ) {
+			if ( dst_locked ) {
+				SDL_UnlockSurface(dst);
+			}
+			SDL_free(mem);
+			SDL_SetError("Unable to lock source surface");
+			return(-1);
+		}
+		src_locked = 1;
+	}
+
+	/* Perform the stretch blit */
+	for ( y = 0; y < dstrect->h; ++y ) {
+		const int sy[2] = { y0[y], y1[y] };
+		const int nrows = fy[y] ? 2 : 1;
+		Uint32 *row[2];
+		int slot, keep;
+
+		/* Unpack the source rows, reusing the ones we already have */
+		keep = -1;
+		if ( nrows == 2 && rowidx[0] == sy[1] ) {
+			keep = 0;
+		} else if ( nrows == 2 && rowidx[1] == sy[1] ) {
+			keep = 1;
+		}
+		for ( i = 0; i < nrows; ++i ) {
+			if ( rowidx[0] == sy[i] ) {
+				slot = 0;
+			} else if ( rowidx[1] == sy[i] ) {
+				slot = 1;
+			} else {
+				slot = (keep == 0) ? 1 : 0;
+				UnpackRow((Uint8 *)src->pixels +
+				          (srcrect->y+sy[i])*src->pitch +
+				          srcrect->x*srcfmt->BytesPerPixel,
+				          srcrect->w, srcfmt, rows[slot]);
+				rowidx[slot] = sy[i];
+			}
+			row[i] = rows[slot];
+			keep = slot;
+		}
+		if ( fy[y] ) {
+			vblend(row[0], row[1], vrow, srcrect->w, fy[y]);
+			row[0] = vrow;
+		}
+		hblend(row[0], x0, x1, fx, hrow, dstrect->w);
+		x = dstrect->x * dstfmt->BytesPerPixel;
+		PackRow(hrow, dstrect->w, dstfmt,
+		        (Uint8 *)dst->pixels + (dstrect->y+y)*dst->pitch + x);
+	}
+
+	/* We need to unlock the surfaces if they're locked */
+	if ( dst_locked ) {
+		SDL_UnlockSurface(dst);
+	}
+	if ( src_locked ) {
+		SDL_UnlockSurface(src);
+	}
+	SDL_free(mem);
+	return(0);
+}
@@ -22,13 +22,26 @@
 #include "SDL_config.h"
 
 #include "SDL_video.h"
+#include "SDL_cpuinfo.h"
 #include "SDL_sysvideo.h"
 #include "SDL_cursor_c.h"
 #include "SDL_blit.h"
 #include "SDL_RLEaccel_c.h"
 #include "SDL_pixels_c.h"
+#include "SDL_surfacepool_c.h"
+#include "SDL_timing_c.h"
 #include "SDL_leaks.h"
 
+#if SDL_SSE2_BLITTERS
+#include <emmintrin.h>
+#endif
+#if SDL_AVX2_BLITTERS
+#include <immintrin.h>
+#endif
+#if SDL_ARM_NEON_BLITTERS
+#include <arm_neon.h>
+#endif
+
 
 /* Public routines */
 /*
@@ -74,6 +87,18 @@ SDL_Surface * SDL_CreateRGBSurface (Uint32 flags,
 		flags &= ~SDL_HWSURFACE;
 	}
 
+	/* Recycle a freed software surface if there is one */
+	if ( (flags & SDL_HWSURFACE) == SDL_SWSURFACE ) {
+		surface = SDL_PoolSurface(flags, width, height, depth,
+		                          Rmask, Gmask, Bmask, Amask);
+		if ( surface != NULL ) {
+#ifdef CHECK_LEAKS
+			++surfaces_allocated;
+#endif
+			return(surface);
+		}
+	}
+
 	/* Allocate the surface */
 	surface = (SDL_Surface *)SDL_malloc(sizeof(*surface));
 	if ( surface == NULL ) {
@@ -107,6 +132,9 @@ SDL_Surface * SDL_CreateRGBSurface (Uint32 flags,
 	if ( Amask ) {
 		surface->flags |= SDL_SRCALPHA;
 	}
+	if ( (flags & (SDL_HWSURFACE|SDL_SIMDALIGNED)) == SDL_SIMDALIGNED ) {
+		surface->flags |= SDL_SIMDALIGNED;
+	}
 	surface->w = width;
 	surface->h = height;
 	surface->pitch = SDL_CalculatePitch(surface);
@@ -119,11 +147,18 @@ SDL_Surface * SDL_CreateRGBSurface (Uint32 flags,
 	SDL_SetClipRect(surface, NULL);
 	SDL_FormatChanged(surface);
 
+	/* Allocate an empty mapping */
+	surface->map = SDL_AllocBlitMap();
+	if ( surface->map == NULL ) {
+		SDL_FreeSurface(surface);
+		return(NULL);
+	}
+
 	/* Get the pixels */
 	if ( ((flags&SDL_HWSURFACE) == SDL_SWSURFACE) || 
 				(video->AllocHWSurface(this, surface) < 0) ) {
 		if ( surface->w && surface->h ) {
-			surface->pixels = SDL_malloc(surface->h*surface->pitch);
+			surface->pixels = SDL_PoolAllocPixels(surface);
 			if ( surface->pixels == NULL ) {
 				SDL_FreeSurface(surface);
 				SDL_OutOfMemory();
@@ -134,13 +169,6 @@ SDL_Surface * SDL_CreateRGBSurface (Uint32 flags,
 		}
 	}
 
-	/* Allocate an empty mapping */
-	surface->map = SDL_AllocBlitMap();
-	if ( surface->map == NULL ) {
-		SDL_FreeSurface(surface);
-		return(NULL);
-	}
-
 	/* The surface is ready to go */
 	surface->refcount = 1;
 #ifdef CHECK_LEAKS
@@ -410,6 +438,8 @@ int SDL_LowerBlit (SDL_Surface *src, SDL_Rect *srcrect,
 	SDL_blit do_blit;
 	SDL_Rect hw_srcrect;
 	SDL_Rect hw_dstrect;
+	SDL_TimingStamp start;
+	int retval;
 
 	/* Check to make sure the blit mapping is valid */
 	if ( (src->map->dst != dst) ||
@@ -419,6 +449,11 @@ int SDL_LowerBlit (SDL_Surface *src, SDL_Rect *srcrect,
 		}
 	}
 
+	/* Switch to an RLE encoding once it's done in the background */
+	if ( src->map->rle_job ) {
+		SDL_RLEFinish(src, 0);
+	}
+
 	/* Figure out which blitter to use */
 	if ( (src->flags & SDL_HWACCEL) == SDL_HWACCEL ) {
 		if ( src == SDL_VideoSurface ) {
@@ -437,7 +472,13 @@ int SDL_LowerBlit (SDL_Surface *src, SDL_Rect *srcrect,
 	} else {
 		do_blit = src->map->sw_blit;
 	}
-	return(do_blit(src, srcrect, dst, dstrect));
+	if ( !SDL_timing_enabled ) {
+		return(do_blit(src, srcrect, dst, dstrect));
+	}
+	start = SDL_TimingStart();
+	retval = do_blit(src, srcrect, dst, dstrect);
+	SDL_TimingEnd(SDL_TIMING_BLIT, start);
+	return(retval);
 }
 
 
@@ -533,6 +574,231 @@ int SDL_UpperBlit (SDL_Surface *src, SDL_Rect *srcrect,
 	return 0;
 }
 
+int SDL_PrepareSurface (SDL_Surface *src, SDL_Surface *dst, Uint32 flags)
+{
+	if ( ! src || ! dst ) {
+		SDL_SetError("SDL_PrepareSurface: passed a NULL surface");
+		return(-1);
+	}
+	if ( src->locked || dst->locked ) {
+		SDL_SetError("Surfaces must not be locked during blit");
+		return(-1);
+	}
+
+	/* New options take effect with a new mapping */
+	flags &= (SDL_PREPARE_ASYNC|SDL_PREPARE_KEEPRAW);
+	if ( flags != src->map->prepare_flags ) {
+		src->map->prepare_flags = flags;
+		SDL_InvalidateMap(src->map);
+	}
+	if ( (src->map->dst != dst) ||
+	     (src->map->dst->format_version != src->map->format_version) ) {
+		return(SDL_MapSurface(src, dst));
+	}
+	return(0);
+}
+
+/*
+ * SIMD rectangle fills
+ *
+ * The fill color is repeated into a byte pattern long enough to load a
+ * vector at any pixel phase, or three vectors for the 48 byte period of
+ * 24-bit pixels.  Each row gets unaligned stores at both ends and aligned
+ * stores in between.  Fills bigger than the last level cache should use
+ * non-temporal stores, so clearing a large back buffer doesn't evict
+ * everything else from the cache.  Below that size streaming is slower,
+ * since the next blit has to fetch the pixels back from memory, so the
+ * default threshold is high and can be tuned with the
+ * SDL_FILL_STREAM_THRESHOLD environment variable (in bytes, 0 disables).
+ */
+#define SDL_FILL_STREAM_BYTES	(16*1024*1024)
+#define SDL_FILL_PATTERN_BYTES	128
+
+typedef void (*SDL_FillRowFunc)(Uint8 *row, int len, const Uint8 *pattern,
+                                int bpp, int stream);
+
+#if SDL_SSE2_BLITTERS
+static void SDL_FillRowSSE2(Uint8 *row, int len, const Uint8 *pattern,
+                            int bpp, int stream)
+{
+	Uint8 *end = row + len;
+	Uint8 *p;
+	__m128i v[3];
+	int phase, i;
+
+	_mm_storeu_si128((__m128i *)row,
+	                 _mm_loadu_si128((const __m128i *)pattern));
+	p = (Uint8 *)(((uintptr_t)row + 16) & ~(uintptr_t)15);
+	phase = (int)(p - row) % bpp;
+	for ( i = 0; i < 3; ++i ) {
+		v[i] = _mm_loadu_si128((const __m128i *)(pattern+phase+16*i));
+	}
+	i = 0;
+	if ( stream ) {
+		for ( ; p+16 <= end; p += 16 ) {
+			_mm_stream_si128((__m128i *)p, v[i]);
+			if ( ++i == 3 ) i = 0;
+		}
+	} else {
+		for ( ; p+16 <= end; p += 16 ) {
+			_mm_store_si128((__m128i *)p, v[i]);
+			if ( ++i == 3 ) i = 0;
+		}
+	}
+	if ( p < end ) {
+		_mm_storeu_si128((__m128i *)(end-16), _mm_loadu_si128(
+			(const __m128i *)(pattern + (len-16) % bpp)));
+	}
+}
+#endif /* SDL_SSE2_BLITTERS */
+
+#if SDL_AVX2_BLITTERS
+static SDL_TARGET_AVX2 void SDL_FillRowAVX2(Uint8 *row, int len,
+                                            const Uint8 *pattern,
+                                            int bpp, int stream)
+{
+	Uint8 *end = row + len;
+	Uint8 *p;
+	__m256i v[3];
+	int phase, i;
+
+	_mm256_storeu_si256((__m256i *)row,
+	                    _mm256_loadu_si256((const __m256i *)pattern));
+	p = (Uint8 *)(((uintptr_t)row + 32) & ~(uintptr_t)31);
+	phase = (int)(p - row) % bpp;
+	for ( i = 0; i < 3; ++i ) {
+		v[i] = _mm256_loadu_si256((const __m256i *)(pattern+phase+32*i));
+	}
+	i = 0;
+	if ( stream ) {
+		for ( ; p+32 <= end; p += 32 ) {
+			_mm256_stream_si256((__m256i *)p, v[i]);
+			if ( ++i == 3 ) i = 0;
+		}
+	} else {
+		for ( ; p+32 <= end; p += 32 ) {
+			_mm256_store_si256((__m256i *)p, v[i]);
+			if ( ++i == 3 ) i = 0;
+		}
+	}
+	if ( p < end ) {
+		_mm256_storeu_si256((__m256i *)(end-32), _mm256_loadu_si256(
+			(const __m256i *)(pattern + (len-32) % bpp)));
+	}
+}
+#endif /* SDL_AVX2_BLITTERS */
+
+#if SDL_ARM_NEON_BLITTERS
+/* NEON has no non-temporal stores, the core handles streaming itself */
+static void SDL_FillRowNEON(Uint8 *row, int len, const Uint8 *pattern,
+                            int bpp, int stream)
+{
+	Uint8 *end = row + len;
+	Uint8 *p;
+	uint8x16_t v[3];
+	int phase, i;
+
+	vst1q_u8(row, vld1q_u8(pattern));
+	p = (Uint8 *)(((uintptr_t)row + 16) & ~(uintptr_t)15);
+	phase = (int)(p - row) % bpp;
+	for ( i = 0; i < 3; ++i ) {
+		v[i] = vld1q_u8(pattern+phase+16*i);
+	}
+	for ( i = 0; p+16 <= end; p += 16 ) {
+		vst1q_u8(p, v[i]);
+		if ( ++i == 3 ) i = 0;
+	}
+	if ( p < end ) {
+		vst1q_u8(end-16, vld1q_u8(pattern + (len-16) % bpp));
+	}
+}
+#endif /* SDL_ARM_NEON_BLITTERS */
+
+static int SDL_FillStreamThreshold(void)
+{
+	static int threshold = -1;
+
+	if ( threshold < 0 ) {
+		const char *env = SDL_getenv("SDL_FILL_STREAM_THRESHOLD");
+		threshold = env ? SDL_atoi(env) : SDL_FILL_STREAM_BYTES;
+		if ( threshold < 0 ) {
+			threshold = 0;
+		}
+	}
+	return threshold;
+}
+
+/* Fill with the best SIMD row filler, returns 0 if there isn't one */
+static int SDL_FillRectSIMD(SDL_Surface *dst, SDL_Rect *dstrect,
+                            Uint8 *row, Uint32 color)
+{
+	const int bpp = dst->format->BytesPerPixel;
+	const int len = dstrect->w * bpp;
+	SDL_FillRowFunc fillrow = NULL;
+	int minlen = 16;
+	int stream, y, i;
+	Uint8 pixel[4];
+	Uint8 pattern[SDL_FILL_PATTERN_BYTES];
+
+#if SDL_ARM_NEON_BLITTERS
+	if ( SDL_HasNEON() ) {
+		fillrow = SDL_FillRowNEON;
+	}
+#endif
+#if SDL_SSE2_BLITTERS
+	if ( SDL_HasSSE2() ) {
+		fillrow = SDL_FillRowSSE2;
+	}
+#endif
+#if SDL_AVX2_BLITTERS
+	if ( SDL_HasAVX2() && len >= 64 ) {
+		fillrow = SDL_FillRowAVX2;
+		minlen = 32;
+	}
+#endif
+	if ( !fillrow || len < minlen ) {
+		return(0);
+	}
+
+	/* Lay out the pixel bytes the way they are stored in memory */
+	switch (bpp) {
+	    case 1:
+		pixel[0] = (Uint8)color;
+		break;
+	    case 2: {
+		Uint16 c = (Uint16)color;
+		SDL_memcpy(pixel, &c, 2);
+		}
+		break;
+	    case 3:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+		color <<= 8;
+#endif
+		SDL_memcpy(pixel, &color, 3);
+		break;
+	    default:
+		SDL_memcpy(pixel, &color, 4);
+		break;
+	}
+	for ( i = 0; i < SDL_FILL_PATTERN_BYTES; ++i ) {
+		pattern[i] = pixel[i % bpp];
+	}
+
+	stream = SDL_FillStreamThreshold();
+	stream = (stream && len * dstrect->h >= stream);
+	for ( y = dstrect->h; y; --y ) {
+		fillrow(row, len, pattern, bpp, stream);
+		row += dst->pitch;
+	}
+#if SDL_SSE2_BLITTERS
+	if ( stream ) {
+		/* Order the streaming stores before anything that follows */
+		_mm_sfence();
+	}
+#endif
+	return(1);
+}
+
 static int SDL_FillRect1(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 {
 	/* FIXME: We have to worry about packing order.. *sigh* */
@@ -602,7 +868,9 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 	}
 	row = (Uint8 *)dst->pixels+dstrect->y*dst->pitch+
 			dstrect->x*dst->format->BytesPerPixel;
-	if ( dst->format->palette || (color == 0) ) {
+	if ( SDL_FillRectSIMD(dst, dstrect, row, color) ) {
+		/* Filled with vector stores */
+	} else if ( dst->format->palette || (color == 0) ) {
 		x = dstrect->w*dst->format->BytesPerPixel;
 		if ( !color && !((uintptr_t)row&3) && !(x&3) && !(dst->pitch&3) ) {
 			int n = x >> 2;
@@ -744,7 +1012,12 @@ int SDL_LockSurface (SDL_Surface *surface)
 				return(-1);
 			}
 		}
-		if ( surface->flags & SDL_RLEACCEL ) {
+		if ( surface->map && surface->map->rle_job ) {
+			SDL_RLEFinish(surface, 1);
+		}
+		/* Raw pixels kept with the encoding are changed in place */
+		if ( (surface->flags & SDL_RLEACCEL) &&
+		     !surface->map->rle_kept ) {
 			SDL_UnRLESurface(surface, 1);
 			surface->flags |= SDL_RLEACCEL;	/* save accel'd state */
 		}
@@ -778,9 +1051,17 @@ void SDL_UnlockSurface (SDL_Surface *surface)
 		video->UnlockHWSurface(this, surface);
 	} else {
 		/* Update RLE encoded surface with new data */
-		if ( (surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
+		if ( (surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL &&
+		     !SDL_RLEUnchanged(surface) ) {
 		        surface->flags &= ~SDL_RLEACCEL; /* stop lying */
-			SDL_RLESurface(surface);
+			if ( SDL_RecodeRLE(surface) &&
+			     !(surface->map->prepare_flags & SDL_PREPARE_ASYNC) ) {
+				SDL_RLESurface(surface);
+			} else {
+				/* Remap to keep the raw pixels if they change
+				   often, or to encode them in the background */
+				SDL_InvalidateMap(surface->map);
+			}
 		}
 	}
 }
@@ -917,6 +1198,12 @@ void SDL_FreeSurface (SDL_Surface *surface)
 	if ( (surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
 	        SDL_UnRLESurface(surface, 0);
 	}
+	if ( SDL_PoolRecycle(surface) ) {
+#ifdef CHECK_LEAKS
+		--surfaces_allocated;
+#endif
+		return;
+	}
 	if ( surface->format ) {
 		SDL_FreeFormat(surface->format);
 		surface->format = NULL;
@@ -0,0 +1,299 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Surface recycling for SDL_CreateRGBSurface() and SDL_FreeSurface()
+
+   Particle systems and text renderers create and free lots of small
+   surfaces every frame, and each one costs four allocations: the surface,
+   its pixel format, its blit map and the pixels.  When the pool is turned
+   on and video is initialized, software surfaces of up to POOL_MAX_BYTES of pixels get
+   their pixels rounded up to a power of two size class, and when they are
+   freed the whole surface is kept, format and map included, to be handed
+   out again by the next SDL_CreateRGBSurface() of the same format and
+   size class.
+
+   The pixel format can't be shared between surfaces, because the colorkey
+   and per-surface alpha live in it and applications write them directly,
+   so each pooled surface keeps its own.  Palettized surfaces aren't pooled.
+
+   It's off by default: rounding up can nearly double the pixels a surface
+   takes (a 129x129 surface at 32 bpp gets 128K instead of 65K), and the
+   pool lock and free list scan cost something on every create.  Without
+   it, surfaces get exactly the pixels they need and nothing is locked.
+
+	SDL_VIDEO_SURFACE_POOL    bytes of pixels the pool may hold
+	                          (default 0, the pool is off)
+*/
+
+#include "SDL_video.h"
+#include "SDL_mutex.h"
+#include "SDL_sysvideo.h"
+#include "SDL_blit.h"
+#include "SDL_pixels_c.h"
+#include "SDL_surfacepool_c.h"
+
+#define POOL_MIN_SHIFT		6	/* 64 bytes */
+#define POOL_MAX_SHIFT		18	/* 256K, 256x256 at 32 bpp */
+#define POOL_CLASSES		(POOL_MAX_SHIFT - POOL_MIN_SHIFT + 1)
+#define POOL_MAX_BYTES		((size_t)1 << POOL_MAX_SHIFT)
+#define POOL_CLASS_BYTES(c)	((size_t)1 << ((c) + POOL_MIN_SHIFT))
+#define DEFAULT_POOL_BYTES	0
+
+static SDL_mutex *pool_lock = NULL;
+static size_t pool_budget = 0;
+static SDL_Surface *pool_free[POOL_CLASSES];
+static SDL_SurfacePoolStats stats;
+
+static void LockPool(void)
+{
+	if ( pool_lock ) {
+		SDL_mutexP(pool_lock);
+	}
+}
+
+static void UnlockPool(void)
+{
+	if ( pool_lock ) {
+		SDL_mutexV(pool_lock);
+	}
+}
+
+/* The size class for 'len' bytes of pixels, or -1 if it isn't pooled */
+static int PoolClass(size_t len)
+{
+	int c;
+
+	if ( len == 0 || len > POOL_MAX_BYTES ) {
+		return(-1);
+	}
+	c = 0;
+	while ( POOL_CLASS_BYTES(c) < len ) {
+		++c;
+	}
+	return(c);
+}
+
+static void FreePooledSurface(SDL_Surface *surface)
+{
+	SDL_FreeFormat(surface->format);
+	SDL_FreeBlitMap(surface->map);
+	SDL_free(surface->pixels);
+	SDL_free(surface);
+}
+
+void SDL_SurfacePoolInit(void)
+{
+	const char *env;
+	int budget;
+
+	SDL_memset(&stats, 0, sizeof(stats));
+	SDL_memset(pool_free, 0, sizeof(pool_free));
+
+	env = SDL_getenv("SDL_VIDEO_SURFACE_POOL");
+	budget = env ? SDL_atoi(env) : DEFAULT_POOL_BYTES;
+	if ( budget <= 0 ) {
+		return;
+	}
+	pool_lock = SDL_CreateMutex();
+#if !SDL_THREADS_DISABLED
+	if ( pool_lock == NULL ) {
+		return;
+	}
+#endif
+	pool_budget = (size_t)budget;
+}
+
+void SDL_SurfacePoolQuit(void)
+{
+	int c;
+
+	LockPool();
+	pool_budget = 0;
+	for ( c = 0; c < POOL_CLASSES; ++c ) {
+		while ( pool_free[c] ) {
+			SDL_Surface *surface = pool_free[c];
+			pool_free[c] = surface->map->pool_next;
+			FreePooledSurface(surface);
+		}
+	}
+	stats.surfaces = 0;
+	stats.bytes = 0;
+	UnlockPool();
+
+	if ( pool_lock ) {
+		SDL_DestroyMutex(pool_lock);
+		pool_lock = NULL;
+	}
+}
+
+SDL_Surface *SDL_PoolSurface(Uint32 flags, int width, int height, int depth,
+			Uint32 Rmask, Uint32 Gmask, Uint32 Bmask, Uint32 Amask)
+{
+	SDL_Surface probe, *surface, **prev;
+	SDL_PixelFormat format;
+	SDL_PixelFormat *fmt;
+	SDL_BlitMap *map;
+	struct private_swaccel *sw_data;
+	int c, pool_class;
+	void *pool_pixels;
+
+	/* Formats that SDL_AllocFormat() fills in can't be matched */
+	if ( !pool_budget || depth <= 8 || !(Rmask|Gmask|Bmask) ||
+	     width <= 0 || height <= 0 ) {
+		return(NULL);
+	}
+
+	/* Work out the pitch the new surface would have */
+	SDL_memset(&format, 0, sizeof(format));
+	format.BitsPerPixel = depth;
+	format.BytesPerPixel = (depth+7)/8;
+	probe.flags = (flags & SDL_SIMDALIGNED);
+	probe.w = width;
+	probe.format = &format;
+	probe.pitch = SDL_CalculatePitch(&probe);
+	flags = SDL_SWSURFACE | probe.flags | (Amask ? SDL_SRCALPHA : 0);
+	c = PoolClass((size_t)height * probe.pitch);
+	if ( c < 0 ) {
+		return(NULL);
+	}
+
+	LockPool();
+	for ( prev = &pool_free[c]; *prev; prev = &(*prev)->map->pool_next ) {
+		fmt = (*prev)->format;
+		if ( fmt->BitsPerPixel == depth &&
+		     fmt->Rmask == Rmask && fmt->Gmask == Gmask &&
+		     fmt->Bmask == Bmask && fmt->Amask == Amask &&
+		     ((*prev)->flags & SDL_SIMDALIGNED) == probe.flags ) {
+			break;
+		}
+	}
+	surface = *prev;
+	if ( surface ) {
+		*prev = surface->map->pool_next;
+		++stats.hits;
+		--stats.surfaces;
+		stats.bytes -= (Uint32)POOL_CLASS_BYTES(c);
+	} else {
+		++stats.misses;
+	}
+	UnlockPool();
+	if ( surface == NULL ) {
+		return(NULL);
+	}
+
+	/* Make it look just like a new surface */
+	surface->flags = flags;
+	surface->format->alpha = SDL_ALPHA_OPAQUE;
+	surface->format->colorkey = 0;
+	surface->w = width;
+	surface->h = height;
+	surface->pitch = probe.pitch;
+	surface->offset = 0;
+	surface->locked = 0;
+	surface->unused1 = 0;
+
+	map = surface->map;
+	sw_data = map->sw_data;
+	pool_class = map->pool_class;
+	pool_pixels = map->pool_pixels;
+	SDL_memset(map, 0, sizeof(*map));
+	SDL_memset(sw_data, 0, sizeof(*sw_data));
+	map->sw_data = sw_data;
+	map->pool_class = pool_class;
+	map->pool_pixels = pool_pixels;
+
+	SDL_SetClipRect(surface, NULL);
+	SDL_FormatChanged(surface);
+	SDL_memset(surface->pixels, 0, surface->h*surface->pitch);
+	surface->refcount = 1;
+	return(surface);
+}
+
+void *SDL_PoolAllocPixels(SDL_Surface *surface)
+{
+	size_t len = (size_t)surface->h * surface->pitch;
+	void *pixels;
+	int c;
+
+	c = PoolClass(len);
+	if ( !pool_budget || c < 0 || surface->format->palette ||
+	     (surface->flags & SDL_HWSURFACE) ) {
+		return(SDL_AllocPixels(surface, len));
+	}
+	pixels = SDL_AllocPixels(surface, POOL_CLASS_BYTES(c));
+	if ( pixels ) {
+		surface->map->pool_class = c + 1;
+		surface->map->pool_pixels = pixels;
+	}
+	return(pixels);
+}
+
+int SDL_PoolRecycle(SDL_Surface *surface)
+{
+	SDL_BlitMap *map = surface->map;
+	size_t bytes;
+	int c, kept = 0;
+
+	/* Only the pixels SDL_PoolAllocPixels() made, and nothing the
+	   application or a video driver has swapped in */
+	if ( !pool_budget || !map || !map->pool_class ||
+	     map->pool_pixels != surface->pixels || surface->hwdata ||
+	     (surface->flags & (SDL_HWSURFACE|SDL_PREALLOC|SDL_RLEACCEL)) ||
+	     !surface->format || surface->format->palette ) {
+		return(0);
+	}
+	c = map->pool_class - 1;
+	bytes = POOL_CLASS_BYTES(c);
+
+	/* Drop mappings and any background RLE encoding first */
+	SDL_InvalidateMap(map);
+
+	LockPool();
+	if ( pool_budget && stats.bytes + bytes <= pool_budget ) {
+		map->pool_next = pool_free[c];
+		pool_free[c] = surface;
+		++stats.recycled;
+		++stats.surfaces;
+		stats.bytes += (Uint32)bytes;
+		kept = 1;
+	} else {
+		++stats.dropped;
+	}
+	UnlockPool();
+	return(kept);
+}
+
+void SDL_GetSurfacePoolStats(SDL_SurfacePoolStats *out, int reset)
+{
+	LockPool();
+	if ( out ) {
+		*out = stats;
+	}
+	if ( reset ) {
+		stats.hits = 0;
+		stats.misses = 0;
+		stats.recycled = 0;
+		stats.dropped = 0;
+	}
+	UnlockPool();
+}
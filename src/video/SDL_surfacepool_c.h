@@ -0,0 +1,44 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Surface recycling, in SDL_surfacepool.c */
+
+extern void SDL_SurfacePoolInit(void);
+extern void SDL_SurfacePoolQuit(void);
+
+/* Returns a freed surface reset to look newly created with these
+   parameters, or NULL if there is none and it has to be allocated.
+   'flags' must not ask for a hardware surface.
+ */
+extern SDL_Surface *SDL_PoolSurface(Uint32 flags, int width, int height,
+		int depth, Uint32 Rmask, Uint32 Gmask, Uint32 Bmask, Uint32 Amask);
+
+/* Allocate the pixels of a new surface, sized so the surface can be
+   recycled if it is small enough.  The surface must have its map.
+ */
+extern void *SDL_PoolAllocPixels(SDL_Surface *surface);
+
+/* Keep a surface being freed in the pool.  Returns 0 if it wasn't kept,
+   and it should be freed as usual.
+ */
+extern int SDL_PoolRecycle(SDL_Surface *surface);
@@ -273,6 +273,8 @@ struct SDL_VideoDevice {
 
 	/* Driver information flags */
 	int handles_any_size;	/* Driver handles any size video mode */
+	int present_any_thread;	/* Driver can update the screen from any
+				   thread, see SDL_VIDEO_PRESENT_THREAD */
 
 	/* * * */
 	/* Data used by the GL drivers */
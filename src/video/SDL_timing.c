@@ -0,0 +1,175 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Timing of the screen update path
+
+   When SDL_VIDEO_TIMING is set, SDL_Flip(), SDL_UpdateRects(), the
+   shadow surface conversion, the software cursor, the driver's
+   UpdateRects and FlipHWSurface, and SDL_LowerBlit() are timed.  The
+   last TIMING_SAMPLES times of each are kept, and SDL_GetVideoTiming()
+   sorts a copy of them for the percentiles.
+
+	SDL_VIDEO_TIMING=1      time the calls
+	SDL_VIDEO_TIMING=dump   also print the timings to stderr when
+	                        video is shut down
+
+   The present thread times its conversions and driver calls into the
+   same buffers as the application thread, so a time can be lost when
+   both finish one at the same moment.
+*/
+
+#include "SDL_video.h"
+#include "SDL_timing_c.h"
+
+#define TIMING_SAMPLES	1024	/* a power of two */
+
+typedef struct {
+	Uint32 samples[TIMING_SAMPLES];
+	Uint32 next;
+	Uint32 count;
+	Uint32 max;
+} SDL_TimingRing;
+
+int SDL_timing_enabled = 0;
+static int timing_dump = 0;
+static SDL_TimingRing *rings = NULL;
+
+void SDL_TimingInit(void)
+{
+#ifdef SDL_HAS_64BIT_TYPE
+	const char *env = SDL_getenv("SDL_VIDEO_TIMING");
+
+	if ( !env || (!SDL_atoi(env) && SDL_strcasecmp(env, "dump") != 0) ) {
+		return;
+	}
+	rings = (SDL_TimingRing *)SDL_calloc(SDL_NUM_TIMINGS, sizeof(*rings));
+	if ( rings ) {
+		timing_dump = (SDL_strcasecmp(env, "dump") == 0);
+		SDL_timing_enabled = 1;
+	}
+#endif
+}
+
+void SDL_TimingAdd(SDL_TimingPoint point, Uint32 ns)
+{
+	SDL_TimingRing *ring = &rings[point];
+
+	ring->samples[ring->next++ & (TIMING_SAMPLES-1)] = ns;
+	++ring->count;
+	if ( ns > ring->max ) {
+		ring->max = ns;
+	}
+}
+
+static int SDLCALL CompareTimes(const void *a, const void *b)
+{
+	const Uint32 x = *(const Uint32 *)a;
+	const Uint32 y = *(const Uint32 *)b;
+
+	return (x < y) ? -1 : (x > y);
+}
+
+int SDL_GetVideoTiming(SDL_TimingPoint point, SDL_TimingStats *stats,
+                       int reset)
+{
+	Uint32 sorted[TIMING_SAMPLES];
+	SDL_TimingRing *ring;
+	Uint32 n;
+
+	if ( !SDL_timing_enabled ) {
+		SDL_SetError("Set SDL_VIDEO_TIMING before video initialization");
+		return(-1);
+	}
+	if ( (int)point < 0 || point >= SDL_NUM_TIMINGS ) {
+		SDL_SetError("Unknown timing point");
+		return(-1);
+	}
+	ring = &rings[point];
+
+	if ( stats ) {
+		n = SDL_min(ring->count, TIMING_SAMPLES);
+		SDL_memset(stats, 0, sizeof(*stats));
+		stats->count = ring->count;
+		stats->max = ring->max;
+		if ( n ) {
+			SDL_memcpy(sorted, ring->samples, n * sizeof(Uint32));
+			SDL_qsort(sorted, n, sizeof(Uint32), CompareTimes);
+			stats->p50 = sorted[(n - 1) * 50 / 100];
+			stats->p95 = sorted[(n - 1) * 95 / 100];
+			stats->p99 = sorted[(n - 1) * 99 / 100];
+		}
+	}
+	if ( reset ) {
+		ring->next = 0;
+		ring->count = 0;
+		ring->max = 0;
+	}
+	return(0);
+}
+
+#if HAVE_STDIO_H
+static const char *timing_names[SDL_NUM_TIMINGS] = {
+	"flip",
+	"updaterects",
+	"convert",
+	"cursor",
+	"driver_update",
+	"driver_flip",
+	"blit"
+};
+
+static void DumpTimings(void)
+{
+	SDL_TimingStats stats;
+	int i;
+
+	fprintf(stderr, "SDL video timing, in microseconds over the "
+	                "last %d calls:\n", TIMING_SAMPLES);
+	fprintf(stderr, "%-14s %10s %10s %10s %10s %10s\n",
+	        "", "calls", "p50", "p95", "p99", "max");
+	for ( i = 0; i < SDL_NUM_TIMINGS; ++i ) {
+		SDL_GetVideoTiming((SDL_TimingPoint)i, &stats, 0);
+		if ( stats.count ) {
+			fprintf(stderr, "%-14s %10u %10.1f %10.1f %10.1f %10.1f\n",
+			        timing_names[i], (unsigned int)stats.count,
+			        stats.p50 / 1000.0, stats.p95 / 1000.0,
+			        stats.p99 / 1000.0, stats.max / 1000.0);
+		}
+	}
+}
+#endif
+
+void SDL_TimingQuit(void)
+{
+	if ( !SDL_timing_enabled ) {
+		return;
+	}
+#if HAVE_STDIO_H
+	if ( timing_dump ) {
+		DumpTimings();
+	}
+#endif
+	SDL_timing_enabled = 0;
+	SDL_free(rings);
+	rings = NULL;
+}
@@ -0,0 +1,78 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Timing of the screen update path for SDL_GetVideoTiming(), in
+   SDL_timing.c.  Everything here costs one test of SDL_timing_enabled
+   unless SDL_VIDEO_TIMING is set.
+ */
+
+#include "SDL_video.h"
+#include "../timer/SDL_systimer.h"
+
+extern void SDL_TimingInit(void);
+
+/* Print the timings if SDL_VIDEO_TIMING asks for it, and stop timing */
+extern void SDL_TimingQuit(void);
+
+#ifdef SDL_HAS_64BIT_TYPE
+typedef Uint64 SDL_TimingStamp;
+#else
+typedef Uint32 SDL_TimingStamp;
+#endif
+
+extern int SDL_timing_enabled;
+
+/* Add one timed call of 'ns' nanoseconds to 'point' */
+extern void SDL_TimingAdd(SDL_TimingPoint point, Uint32 ns);
+
+/* The time to pass to SDL_TimingSince() or SDL_TimingEnd() */
+static __inline__ SDL_TimingStamp SDL_TimingStart(void)
+{
+#ifdef SDL_HAS_64BIT_TYPE
+	if ( SDL_timing_enabled ) {
+		return(SDL_SYS_GetTicksNS());
+	}
+#endif
+	return(0);
+}
+
+/* Nanoseconds since SDL_TimingStart() returned 'start' */
+static __inline__ Uint32 SDL_TimingSince(SDL_TimingStamp start)
+{
+#ifdef SDL_HAS_64BIT_TYPE
+	if ( SDL_timing_enabled ) {
+		Uint64 ns = SDL_SYS_GetTicksNS() - start;
+		return((ns > 0xFFFFFFFF) ? 0xFFFFFFFF : (Uint32)ns);
+	}
+#endif
+	return(0);
+}
+
+/* Add the time since SDL_TimingStart() returned 'start' to 'point' */
+static __inline__ void SDL_TimingEnd(SDL_TimingPoint point,
+                                     SDL_TimingStamp start)
+{
+	if ( SDL_timing_enabled ) {
+		SDL_TimingAdd(point, SDL_TimingSince(start));
+	}
+}
@@ -26,10 +26,16 @@
 #include "SDL.h"
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
+#include "SDL_RLEaccel_c.h"
 #include "SDL_pixels_c.h"
 #include "SDL_cursor_c.h"
+#include "SDL_damage_c.h"
+#include "SDL_present_c.h"
+#include "SDL_surfacepool_c.h"
+#include "SDL_timing_c.h"
 #include "../events/SDL_sysevents.h"
 #include "../events/SDL_events_c.h"
+#include "../timer/SDL_timer_c.h"
 
 /* Available video drivers */
 static VideoBootStrap *bootstrap[] = {
@@ -174,6 +180,9 @@ int SDL_VideoInit (const char *driver_name, Uint32 flags)
 		SDL_VideoQuit();
 	}
 
+	/* Surfaces may be mapped from several threads from here on */
+	SDL_MapCacheInit();
+
 	/* Select the proper video driver */
 	index = 0;
 	video = NULL;
@@ -283,6 +292,21 @@ int SDL_VideoInit (const char *driver_name, Uint32 flags)
 	}
 	SDL_CursorInit(flags & SDL_INIT_EVENTTHREAD);
 
+	/* Start the blit worker threads, if they were asked for */
+	SDL_BlitThreadsInit();
+
+	/* Set up screen update rectangle coalescing */
+	SDL_DamageInit();
+
+	/* Start recycling freed surfaces */
+	SDL_SurfacePoolInit();
+
+	/* See if SDL_Flip() should hand frames to a present thread */
+	SDL_PresentInit();
+
+	/* Time the screen updates, if asked to */
+	SDL_TimingInit();
+
 	/* We're ready to go! */
 	return(0);
 }
@@ -532,7 +556,9 @@ static void SDL_CreateShadowSurface(int depth)
 	} else {
 		Rmask = Gmask = Bmask = 0;
 	}
-	SDL_ShadowSurface = SDL_CreateRGBSurface(SDL_SWSURFACE,
+	/* Aligned, so the shadow to screen copies and the app's SIMD blits
+	   onto it never split a cache line */
+	SDL_ShadowSurface = SDL_CreateRGBSurface(SDL_SWSURFACE|SDL_SIMDALIGNED,
 				SDL_VideoSurface->w, SDL_VideoSurface->h,
 						depth, Rmask, Gmask, Bmask, 0);
 	if ( SDL_ShadowSurface == NULL ) {
@@ -650,6 +676,12 @@ SDL_Surface * SDL_SetVideoMode (int width, int height, int bpp, Uint32 flags)
 		flags &= ~(SDL_HWSURFACE|SDL_DOUBLEBUF);
 	}
 
+	/* Show any queued frames and let go of them, they're the wrong size */
+	SDL_PresentQuit();
+
+	/* The new mode starts out with nothing on the screen */
+	SDL_DamageReset();
+
 	/* Reset the keyboard here so event callbacks can run */
 	SDL_ResetKeyboard();
 	SDL_ResetMouse();
@@ -946,6 +978,7 @@ SDL_Surface * SDL_DisplayFormat (SDL_Surface *surface)
 #else
 	flags |= surface->flags & (SDL_SRCCOLORKEY|SDL_SRCALPHA|SDL_RLEACCELOK);
 #endif
+	flags |= surface->flags & SDL_SIMDALIGNED;
 	return(SDL_ConvertSurface(surface, SDL_PublicSurface->format, flags));
 }
 
@@ -1005,7 +1038,7 @@ SDL_Surface *SDL_DisplayFormatAlpha(SDL_Surface *surface)
 	}
 	format = SDL_AllocFormat(32, rmask, gmask, bmask, amask);
 	flags = SDL_PublicSurface->flags & SDL_HWSURFACE;
-	flags |= surface->flags & (SDL_SRCALPHA | SDL_RLEACCELOK);
+	flags |= surface->flags & (SDL_SRCALPHA | SDL_RLEACCELOK | SDL_SIMDALIGNED);
 	converted = SDL_ConvertSurface(surface, format, flags);
 	SDL_FreeFormat(format);
 	return(converted);
@@ -1042,15 +1075,25 @@ void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 	int i;
 	SDL_VideoDevice *video = current_video;
 	SDL_VideoDevice *this = current_video;
+	SDL_TimingStamp start, step;
 
 	if ( (screen->flags & (SDL_OPENGL | SDL_OPENGLBLIT)) == SDL_OPENGL ) {
 		SDL_SetError("OpenGL active, use SDL_GL_SwapBuffers()");
 		return;
 	}
+	start = SDL_TimingStart();
+	/* Keep the update after the frames SDL_Flip() has queued */
+	SDL_PresentWait();
+	if ( screen == SDL_VideoSurface ) {
+		/* Drop unchanged areas and merge rectangles, if asked to */
+		numrects = SDL_DamageRects(screen, numrects, rects, &rects);
+	}
 	if ( screen == SDL_ShadowSurface ) {
 		/* Blit the shadow surface using saved mapping */
 		SDL_Palette *pal = screen->format->palette;
 		SDL_Color *saved_colors = NULL;
+		int drawcursor = SHOULD_DRAWCURSOR(SDL_cursorstate);
+		Uint32 cursor_ns = 0;
 		if ( pal && !(SDL_VideoSurface->flags & SDL_HWPALETTE) ) {
 			/* simulated 8bpp, use correct physical palette */
 			saved_colors = pal->colors;
@@ -1062,19 +1105,27 @@ void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 				pal->colors = video->physpal->colors;
 			}
 		}
-		if ( SHOULD_DRAWCURSOR(SDL_cursorstate) ) {
+		if ( drawcursor ) {
 			SDL_LockCursor();
+			step = SDL_TimingStart();
 			SDL_DrawCursor(SDL_ShadowSurface);
-			for ( i=0; i<numrects; ++i ) {
-				SDL_LowerBlit(SDL_ShadowSurface, &rects[i], 
-						SDL_VideoSurface, &rects[i]);
-			}
+			cursor_ns = SDL_TimingSince(step);
+		}
+		/* The cursor has to be in place when looking for changes */
+		numrects = SDL_DamageRects(screen, numrects, rects, &rects);
+		step = SDL_TimingStart();
+		for ( i=0; i<numrects; ++i ) {
+			SDL_LowerBlit(SDL_ShadowSurface, &rects[i], 
+					SDL_VideoSurface, &rects[i]);
+		}
+		SDL_TimingEnd(SDL_TIMING_CONVERT, step);
+		if ( drawcursor ) {
+			step = SDL_TimingStart();
 			SDL_EraseCursor(SDL_ShadowSurface);
+			cursor_ns += SDL_TimingSince(step);
 			SDL_UnlockCursor();
-		} else {
-			for ( i=0; i<numrects; ++i ) {
-				SDL_LowerBlit(SDL_ShadowSurface, &rects[i], 
-						SDL_VideoSurface, &rects[i]);
+			if ( SDL_timing_enabled ) {
+				SDL_TimingAdd(SDL_TIMING_CURSOR, cursor_ns);
 			}
 		}
 		if ( saved_colors ) {
@@ -1086,6 +1137,7 @@ void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 	}
 	if ( screen == SDL_VideoSurface ) {
 		/* Update the video surface */
+		step = SDL_TimingStart();
 		if ( screen->offset ) {
 			for ( i=0; i<numrects; ++i ) {
 				rects[i].x += video->offset_x;
@@ -1099,7 +1151,9 @@ void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 		} else {
 			video->UpdateRects(this, numrects, rects);
 		}
+		SDL_TimingEnd(SDL_TIMING_DRIVER_UPDATE, step);
 	}
+	SDL_TimingEnd(SDL_TIMING_UPDATERECTS, start);
 }
 
 /*
@@ -1108,6 +1162,19 @@ void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 int SDL_Flip(SDL_Surface *screen)
 {
 	SDL_VideoDevice *video = current_video;
+	SDL_TimingStamp start, step;
+	int retval = 0;
+
+	/* Keep to the frame rate set with SDL_SetFramePeriod() */
+	SDL_WaitFlipFrame();
+	start = SDL_TimingStart();
+
+	/* Let the present thread convert and show it, if there is one */
+	if ( (screen == SDL_ShadowSurface) && (SDL_PresentFrame(screen) == 0) ) {
+		SDL_TimingEnd(SDL_TIMING_FLIP, start);
+		return(0);
+	}
+	SDL_PresentWait();
 	/* Copy the shadow surface to the video surface */
 	if ( screen == SDL_ShadowSurface ) {
 		SDL_Rect rect;
@@ -1130,15 +1197,27 @@ int SDL_Flip(SDL_Surface *screen)
 		rect.w = screen->w;
 		rect.h = screen->h;
 		if ( SHOULD_DRAWCURSOR(SDL_cursorstate) ) {
+			Uint32 cursor_ns;
 			SDL_LockCursor();
+			step = SDL_TimingStart();
 			SDL_DrawCursor(SDL_ShadowSurface);
+			cursor_ns = SDL_TimingSince(step);
+			step = SDL_TimingStart();
 			SDL_LowerBlit(SDL_ShadowSurface, &rect,
 					SDL_VideoSurface, &rect);
+			SDL_TimingEnd(SDL_TIMING_CONVERT, step);
+			step = SDL_TimingStart();
 			SDL_EraseCursor(SDL_ShadowSurface);
+			cursor_ns += SDL_TimingSince(step);
 			SDL_UnlockCursor();
+			if ( SDL_timing_enabled ) {
+				SDL_TimingAdd(SDL_TIMING_CURSOR, cursor_ns);
+			}
 		} else {
+			step = SDL_TimingStart();
 			SDL_LowerBlit(SDL_ShadowSurface, &rect,
 					SDL_VideoSurface, &rect);
+			SDL_TimingEnd(SDL_TIMING_CONVERT, step);
 		}
 		if ( saved_colors ) {
 			pal->colors = saved_colors;
@@ -1149,11 +1228,14 @@ int SDL_Flip(SDL_Surface *screen)
 	}
 	if ( (screen->flags & SDL_DOUBLEBUF) == SDL_DOUBLEBUF ) {
 		SDL_VideoDevice *this  = current_video;
-		return(video->FlipHWSurface(this, SDL_VideoSurface));
+		step = SDL_TimingStart();
+		retval = video->FlipHWSurface(this, SDL_VideoSurface);
+		SDL_TimingEnd(SDL_TIMING_DRIVER_FLIP, step);
 	} else {
 		SDL_UpdateRect(screen, 0, 0, 0, 0);
 	}
-	return(0);
+	SDL_TimingEnd(SDL_TIMING_FLIP, start);
+	return(retval);
 }
 
 static void SetPalette_logical(SDL_Surface *screen, SDL_Color *colors,
@@ -1161,6 +1243,7 @@ static void SetPalette_logical(SDL_Surface *screen, SDL_Color *colors,
 {
 	SDL_Palette *pal = screen->format->palette;
 	SDL_Palette *vidpal;
+	SDL_Color *mapcolors = pal->colors;
 
 	if ( colors != (pal->colors + firstcolor) ) {
 		SDL_memcpy(pal->colors + firstcolor, colors,
@@ -1178,9 +1261,17 @@ static void SetPalette_logical(SDL_Surface *screen, SDL_Color *colors,
 			 */
 			SDL_memcpy(vidpal->colors + firstcolor, colors,
 			       ncolors * sizeof(*colors));
+		} else if ( (screen == SDL_ShadowSurface) &&
+		            (screen->map->dst == SDL_VideoSurface) &&
+		            (current_video->gammacols || current_video->physpal) ) {
+			/*
+			 * The shadow-to-video mapping translates from the
+			 * physical colors, which haven't changed
+			 */
+			mapcolors = NULL;
 		}
 	}
-	SDL_FormatChanged(screen);
+	SDL_PaletteChanged(screen, mapcolors, firstcolor, ncolors);
 }
 
 static int SetPalette_physical(SDL_Surface *screen,
@@ -1189,6 +1280,9 @@ static int SetPalette_physical(SDL_Surface *screen,
 	SDL_VideoDevice *video = current_video;
 	int gotall = 1;
 
+	/* Show the queued frames before the palette changes */
+	SDL_PresentWait();
+
 	if ( video->physpal ) {
 		/* We need to copy the new colors, since we haven't
 		 * already done the copy in the logical set above.
@@ -1207,15 +1301,14 @@ static int SetPalette_physical(SDL_Surface *screen,
 			screen = SDL_VideoSurface;
 		} else {
 			/*
-			 * The video surface is not indexed - invalidate any
+			 * The video surface is not indexed - update any
 			 * active shadow-to-video blit mappings.
 			 */
-			if ( screen->map->dst == SDL_VideoSurface ) {
-				SDL_InvalidateMap(screen->map);
-			}
+			int remap = 0;
 			if ( video->gamma ) {
 				if( ! video->gammacols ) {
 					SDL_Palette *pp = video->physpal;
+					remap = 1;
 					if(!pp)
 						pp = screen->format->palette;
 					video->gammacols = SDL_malloc(pp->ncolors
@@ -1231,6 +1324,21 @@ static int SetPalette_physical(SDL_Surface *screen,
 						       ncolors);
 				}
 			}
+			if ( screen->map->dst == SDL_VideoSurface ) {
+				SDL_Color *mapcolors;
+				if ( video->gammacols ) {
+					mapcolors = video->gammacols;
+				} else if ( video->physpal ) {
+					mapcolors = video->physpal->colors;
+				} else {
+					mapcolors = screen->format->palette->colors;
+				}
+				if ( remap || !SDL_PatchMap(screen, mapcolors,
+				                            firstcolor, ncolors) ) {
+					SDL_InvalidateMap(screen->map);
+				}
+			}
+			SDL_DamageReset();
 			SDL_UpdateRect(screen, 0, 0, 0, 0);
 		}
 	}
@@ -1355,6 +1463,14 @@ void SDL_VideoQuit (void)
 		/* Halt event processing before doing anything else */
 		SDL_StopEventLoop();
 
+		/* Stop the present, blit worker and RLE encoder threads */
+		SDL_PresentQuit();
+		SDL_BlitThreadsQuit();
+		SDL_RLEQuit();
+		SDL_DamageQuit();
+		SDL_SurfacePoolQuit();
+		SDL_TimingQuit();
+
 		/* Clean up allocated window manager items */
 		if ( SDL_PublicSurface ) {
 			SDL_PublicSurface = NULL;
@@ -1379,6 +1495,7 @@ void SDL_VideoQuit (void)
 		SDL_PublicSurface = NULL;
 
 		/* Clean up miscellaneous memory */
+		SDL_MapCacheQuit();
 		if ( video->physpal ) {
 			SDL_free(video->physpal->colors);
 			SDL_free(video->physpal);
@@ -1944,6 +2061,7 @@ int SDL_WM_ToggleFullScreen(SDL_Surface *surface)
 	toggled = 0;
 	if ( SDL_PublicSurface && (surface == SDL_PublicSurface) &&
 	     video->ToggleFullScreen ) {
+		SDL_PresentWait();
 		if ( surface->flags & SDL_FULLSCREEN ) {
 			toggled = video->ToggleFullScreen(this, 0);
 			if ( toggled ) {
@@ -1957,8 +2075,10 @@ int SDL_WM_ToggleFullScreen(SDL_Surface *surface)
 				SDL_PublicSurface->flags |= SDL_FULLSCREEN;
 			}
 		}
-		/* Double-check the grab state inside SDL_WM_GrabInput() */
 		if ( toggled ) {
+			/* The screen may have been recreated */
+			SDL_DamageReset();
+			/* Double-check the grab state inside SDL_WM_GrabInput() */
 			SDL_WM_GrabInput(video->input_grab);
 		}
 	}
@@ -467,6 +467,7 @@ static SDL_VideoDevice *DISPMANX_CreateDevice(int devindex)
 	this->InitOSKeymap = FB_InitOSKeymap;
 	this->PumpEvents = FB_PumpEvents;
 	this->CreateYUVOverlay = NULL;
+	this->present_any_thread = 1;
 
 	this->free = DISPMANX_DeleteDevice;
 
@@ -278,6 +278,7 @@ static SDL_VideoDevice *FB_CreateDevice(int devindex)
 	this->GetWMInfo = NULL;
 	this->InitOSKeymap = FB_InitOSKeymap;
 	this->PumpEvents = FB_PumpEvents;
+	this->present_any_thread = 1;
 
 	this->free = FB_DeleteDevice;
 
@@ -0,0 +1,1340 @@
+/*
+ * Benchmarks every source/destination pixel format pair against each blit
+ *  mode and a set of surface sizes, without needing a display.
+ *
+ *  Based on testblitspeed.c.  Results go to stdout as CSV (the default)
+ *  or JSON, one record per combination, including the name of the blit
+ *  function SDL picked, so runs can be diffed across builds and machines.
+ *  With --aligned, the surfaces are created with SDL_SIMDALIGNED.
+ *
+ *  --bench picks what is timed, each with its own record fields:
+ *    blit - the blit matrix above (the default)
+ *    fill - SDL_FillRect() on each destination format, with the fill
+ *           rate in megapixels and gigabytes per second.  The
+ *           "unaligned" runs fill a rectangle starting one pixel in, to
+ *           exercise the ragged row ends.
+ *    palexpand - 8-bit to 16 and 32-bit palette expansion, the conversion
+ *           behind simulated 8bpp screens.  Each run times
+ *           SDL_BlitSurface() against a plain one lookup per pixel loop,
+ *           the way SDL used to expand palettes, and checks that both give
+ *           the same pixels; the exit status is non-zero if they don't.
+ *           The modes fill the source with noise over the whole palette,
+ *           smooth gradients, or only the first 16 colors, or use an 8
+ *           color palette like an 8-bit BMP with fewer colors would have,
+ *           and each is run with and without a colorkey.
+ *    colorkey - a round sprite on a colorkey background, blitted across a
+ *           640x480 destination.  The modes are:
+ *             plain   - SDL_SRCCOLORKEY only
+ *             rle     - SDL_SRCCOLORKEY|SDL_RLEACCEL, so SDL decides
+ *                       whether RLE is worth it (see
+ *                       SDL_VIDEO_RLE_MIN_PIXELS)
+ *             rlelock - as rle, but the sprite is locked and changed
+ *                       every frame
+ *             rlepeek - as rle, but the sprite is locked and read every
+ *                       frame
+ *             rlekeep - as rlepeek, with SDL_PREPARE_KEEPRAW so the lock
+ *                       doesn't cost an RLE decode and encode
+ *           The RLE counters from SDL_GetBlitCacheStats() are printed to
+ *           stderr at the end.
+ *    stretch - SDL_SoftStretchFilter() from a 37x23 source to each size,
+ *           between surfaces of each destination format.  Each run times
+ *           it against a plain per pixel bilinear filter and checks that
+ *           both give the same pixels; the exit status is non-zero if
+ *           they don't.  The modes are SDL_STRETCH_BILINEAR and
+ *           SDL_STRETCH_SHARP_BILINEAR.
+ *    verify - blits each pair of the blit matrix once and checks that the
+ *           destination is byte for byte what the C blitters produce.
+ *           The C output comes from running this program again with
+ *           --reference and SDL_CPU_FEATURE_MASK=0, which prints a
+ *           checksum per blit instead.  The exit status is non-zero if
+ *           any blit differs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+typedef struct
+{
+    const char *name;
+    int bpp;
+    Uint32 rmask, gmask, bmask, amask;
+} PixelFormat;
+
+static const PixelFormat formats[] =
+{
+    { "INDEX8",   8,  0, 0, 0, 0 },
+    { "RGB555",   15, 0x00007C00, 0x000003E0, 0x0000001F, 0x00000000 },
+    { "RGB565",   16, 0x0000F800, 0x000007E0, 0x0000001F, 0x00000000 },
+    { "BGR565",   16, 0x0000001F, 0x000007E0, 0x0000F800, 0x00000000 },
+    { "RGB888",   24, 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 },
+    { "BGR888",   24, 0x000000FF, 0x0000FF00, 0x00FF0000, 0x00000000 },
+    { "XRGB8888", 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 },
+    { "XBGR8888", 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0x00000000 },
+    { "ARGB8888", 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 },
+    { "ABGR8888", 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000 },
+    { "RGBA8888", 32, 0xFF000000, 0x00FF0000, 0x0000FF00, 0x000000FF },
+    { "BGRA8888", 32, 0x0000FF00, 0x00FF0000, 0xFF000000, 0x000000FF },
+};
+#define NUM_FORMATS (sizeof (formats) / sizeof (formats[0]))
+
+typedef enum
+{
+    MODE_COPY,
+    MODE_COLORKEY,
+    MODE_SURFACE_ALPHA,
+    MODE_PIXEL_ALPHA,
+    MODE_RLE,
+    NUM_MODES
+} BlitMode;
+
+static const char *mode_names[NUM_MODES] =
+{
+    "copy", "colorkey", "surfalpha", "pixelalpha", "rle"
+};
+
+#define MAX_SIZES 16
+static int widths[MAX_SIZES];
+static int heights[MAX_SIZES];
+static int num_sizes = 0;
+
+static int test_ms = 100;
+static int json = 0;
+static Uint32 surface_flags = SDL_SWSURFACE;
+static const char *src_filter = NULL;
+static const char *dst_filter = NULL;
+static const char *mode_filter = NULL;
+static int records = 0;
+static int fields = 0;
+static int failures = 0;
+static int reference = 0;
+static int num_args = 0;
+static char **args = NULL;
+
+
+static int parse_sizes(const char *str)
+{
+    num_sizes = 0;
+    while ((str != NULL) && (*str) && (num_sizes < MAX_SIZES))
+    {
+        int w, h;
+        if (sscanf(str, "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0)
+            return(0);
+        widths[num_sizes] = w;
+        heights[num_sizes] = h;
+        num_sizes++;
+        str = strchr(str, ',');
+        if (str != NULL)
+            str++;
+    }
+    return(num_sizes > 0);
+}
+
+static void fill_surface(SDL_Surface *surface, Uint32 colorkey, int keyed)
+{
+    int x, y;
+    int bpp = surface->format->BytesPerPixel;
+    Uint32 mask = (bpp == 4) ? 0xFFFFFFFF : ((1 << (bpp * 8)) - 1);
+
+    if (SDL_MUSTLOCK(surface))
+        SDL_LockSurface(surface);
+
+    for (y = 0; y < surface->h; y++)
+    {
+        Uint8 *row = (Uint8 *) surface->pixels + y * surface->pitch;
+        for (x = 0; x < surface->w; x++)
+        {
+            Uint8 *p = row + x * bpp;
+            Uint32 pixel;
+            int i;
+
+            /* Runs of transparent pixels, like a typical sprite */
+            if (keyed && (((x / 16) + (y / 16)) % 3) == 0)
+                pixel = colorkey;
+            else
+            {
+                pixel = (Uint32) rand() ^ ((Uint32) rand() << 16);
+                pixel &= mask;
+                if (keyed && (pixel == colorkey))
+                    pixel ^= 1;
+            }
+
+            for (i = 0; i < bpp; i++)
+            {
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+                p[i] = (Uint8) (pixel >> (i * 8));
+#else
+                p[i] = (Uint8) (pixel >> ((bpp - 1 - i) * 8));
+#endif
+            }
+        }
+    }
+
+    if (SDL_MUSTLOCK(surface))
+        SDL_UnlockSurface(surface);
+}
+
+static SDL_Surface *create_surface(const PixelFormat *fmt, int w, int h)
+{
+    SDL_Surface *surface;
+
+    surface = SDL_CreateRGBSurface(surface_flags, w, h, fmt->bpp,
+                                   fmt->rmask, fmt->gmask, fmt->bmask,
+                                   fmt->amask);
+    if ((surface != NULL) && (fmt->bpp == 8))
+    {
+        SDL_Color colors[256];
+        int i;
+        for (i = 0; i < 256; i++)
+        {
+            colors[i].r = (Uint8) ((i >> 5) * 255 / 7);
+            colors[i].g = (Uint8) (((i >> 2) & 7) * 255 / 7);
+            colors[i].b = (Uint8) ((i & 3) * 255 / 3);
+        }
+        SDL_SetColors(surface, colors, 0, 256);
+    }
+    return(surface);
+}
+
+static int setup_mode(SDL_Surface *src, BlitMode mode)
+{
+    Uint32 colorkey = 0;
+    int keyed = ((mode == MODE_COLORKEY) || (mode == MODE_RLE));
+
+    if ((mode == MODE_PIXEL_ALPHA) && (src->format->Amask == 0))
+        return(0);
+    if ((mode == MODE_SURFACE_ALPHA) && (src->format->Amask != 0))
+        return(0);
+
+    if (keyed)
+        colorkey = SDL_MapRGB(src->format, 0xFF, 0x00, 0xFF);
+    fill_surface(src, colorkey, keyed);
+
+    /* Surfaces are created with SDL_SRCALPHA when they have an alpha
+       channel, so start from a plain copy and add what the mode needs. */
+    SDL_SetAlpha(src, 0, SDL_ALPHA_OPAQUE);
+    SDL_SetColorKey(src, 0, 0);
+
+    switch (mode)
+    {
+        case MODE_COPY:
+            break;
+        case MODE_COLORKEY:
+            SDL_SetColorKey(src, SDL_SRCCOLORKEY, colorkey);
+            break;
+        case MODE_SURFACE_ALPHA:
+            SDL_SetAlpha(src, SDL_SRCALPHA, 100);
+            break;
+        case MODE_PIXEL_ALPHA:
+            SDL_SetAlpha(src, SDL_SRCALPHA, SDL_ALPHA_OPAQUE);
+            break;
+        case MODE_RLE:
+            if (src->format->Amask)
+                SDL_SetAlpha(src, SDL_SRCALPHA | SDL_RLEACCEL, SDL_ALPHA_OPAQUE);
+            else
+                SDL_SetColorKey(src, SDL_SRCCOLORKEY | SDL_RLEACCEL, colorkey);
+            break;
+        default:
+            return(0);
+    }
+    return(1);
+}
+
+/* Records are written a field at a time, as a CSV line or a JSON object */
+static void begin_record(void)
+{
+    if (json)
+        printf("%s  { ", records ? ",\n" : "");
+    fields = 0;
+}
+
+static void next_field(const char *key)
+{
+    if (json)
+        printf("%s\"%s\": ", fields ? ", " : "", key);
+    else if (fields)
+        printf(",");
+    fields++;
+}
+
+static void string_field(const char *key, const char *value)
+{
+    next_field(key);
+    printf(json ? "\"%s\"" : "%s", value);
+}
+
+static void number_field(const char *key, int decimals, double value)
+{
+    next_field(key);
+    printf("%.*f", decimals, value);
+}
+
+static void flag_field(const char *key, int value)
+{
+    next_field(key);
+    if (json)
+        printf("%s", value ? "true" : "false");
+    else
+        printf("%s", value ? "yes" : "no");
+}
+
+static void end_record(void)
+{
+    printf(json ? " }" : "\n");
+    fflush(stdout);
+    records++;
+}
+
+static void output_record(const PixelFormat *srcfmt, const PixelFormat *dstfmt,
+                          BlitMode mode, int w, int h, const char *blitter,
+                          Uint32 blits, Uint32 elapsed)
+{
+    begin_record();
+    string_field("src", srcfmt->name);
+    string_field("dst", dstfmt->name);
+    string_field("mode", mode_names[mode]);
+    number_field("width", 0, w);
+    number_field("height", 0, h);
+    string_field("blitter", blitter);
+    number_field("blits", 0, blits);
+    number_field("ns_per_blit", 0, (elapsed * 1000000.0) / blits);
+    number_field("mpixels_per_sec", 2,
+                 ((double) w * h * blits) / (elapsed * 1000.0));
+    end_record();
+}
+
+static void run_test(const PixelFormat *srcfmt, const PixelFormat *dstfmt,
+                     BlitMode mode, int w, int h)
+{
+    SDL_Surface *src = create_surface(srcfmt, w, h);
+    SDL_Surface *dst = create_surface(dstfmt, w, h);
+    const char *blitter;
+    Uint32 blits = 0;
+    Uint32 start, now;
+
+    if ((src == NULL) || (dst == NULL))
+    {
+        fprintf(stderr, "Couldn't create %dx%d surfaces: %s\n",
+                w, h, SDL_GetError());
+        goto done;
+    }
+
+    if (!setup_mode(src, mode))
+        goto done;
+    fill_surface(dst, 0, 0);
+
+    /* The first blit maps the surfaces and picks the blitter */
+    if (SDL_BlitSurface(src, NULL, dst, NULL) < 0)
+        goto done;
+    blitter = SDL_GetBlitterName(src);
+    if (blitter == NULL)
+        blitter = "unknown";
+
+    start = now = SDL_GetTicks();
+    do
+    {
+        int i;
+        for (i = 0; i < 8; i++)
+            SDL_BlitSurface(src, NULL, dst, NULL);
+        blits += 8;
+        now = SDL_GetTicks();
+    } while ((now - start) < (Uint32) test_ms);
+
+    output_record(srcfmt, dstfmt, mode, w, h, blitter, blits, now - start);
+
+done:
+    if (src != NULL)
+        SDL_FreeSurface(src);
+    if (dst != NULL)
+        SDL_FreeSurface(dst);
+}
+
+static int matches(const char *filter, const char *name)
+{
+    size_t len;
+
+    if (filter == NULL)
+        return(1);
+
+    /* comma separated list of names */
+    len = strlen(name);
+    while (*filter)
+    {
+        if ((strncmp(filter, name, len) == 0) &&
+            ((filter[len] == ',') || (filter[len] == '\0')))
+            return(1);
+        filter = strchr(filter, ',');
+        if (filter == NULL)
+            break;
+        filter++;
+    }
+    return(0);
+}
+
+static void run_blits(void)
+{
+    size_t s, d;
+    int m, z;
+
+    srand(0x5D1);
+    for (s = 0; s < NUM_FORMATS; s++)
+    {
+        if (!matches(src_filter, formats[s].name))
+            continue;
+        for (d = 0; d < NUM_FORMATS; d++)
+        {
+            if (!matches(dst_filter, formats[d].name))
+                continue;
+            for (m = 0; m < NUM_MODES; m++)
+            {
+                if (!matches(mode_filter, mode_names[m]))
+                    continue;
+                for (z = 0; z < num_sizes; z++)
+                    run_test(&formats[s], &formats[d], (BlitMode) m,
+                             widths[z], heights[z]);
+            }
+        }
+    }
+}
+
+static void run_fill(const PixelFormat *fmt, int w, int h, int unaligned)
+{
+    SDL_Surface *dst;
+    SDL_Rect rect;
+    Uint32 fills = 0;
+    Uint32 color;
+    Uint32 start, now;
+
+    dst = create_surface(fmt, w + unaligned, h);
+    if (dst == NULL)
+    {
+        fprintf(stderr, "Couldn't create %dx%d surface: %s\n",
+                w, h, SDL_GetError());
+        return;
+    }
+
+    rect.x = unaligned;
+    rect.y = 0;
+    rect.w = w;
+    rect.h = h;
+    color = SDL_MapRGB(dst->format, 0x12, 0x34, 0x56);
+
+    start = now = SDL_GetTicks();
+    do
+    {
+        int i;
+        for (i = 0; i < 8; i++)
+        {
+            SDL_Rect r = rect;
+            SDL_FillRect(dst, &r, color);
+        }
+        fills += 8;
+        now = SDL_GetTicks();
+    } while ((now - start) < (Uint32) test_ms);
+    now -= start;
+
+    begin_record();
+    string_field("format", fmt->name);
+    number_field("width", 0, w);
+    number_field("height", 0, h);
+    string_field("align", unaligned ? "unaligned" : "aligned");
+    number_field("fills", 0, fills);
+    number_field("ns_per_fill", 0, (now * 1000000.0) / fills);
+    number_field("mpixels_per_sec", 2,
+                 ((double) w * h * fills) / (now * 1000.0));
+    number_field("gbytes_per_sec", 2,
+                 ((double) w * h * dst->format->BytesPerPixel * fills) /
+                 (now * 1000000.0));
+    end_record();
+
+    SDL_FreeSurface(dst);
+}
+
+static void run_fills(void)
+{
+    size_t f;
+    int z, a;
+
+    for (f = 0; f < NUM_FORMATS; f++)
+    {
+        if (!matches(dst_filter, formats[f].name))
+            continue;
+        for (z = 0; z < num_sizes; z++)
+            for (a = 0; a <= 1; a++)
+                run_fill(&formats[f], widths[z], heights[z], a);
+    }
+}
+
+static const char *contents[] = { "noise", "gradient", "16colors", "shortpal" };
+#define NUM_CONTENTS (sizeof (contents) / sizeof (contents[0]))
+
+static void fill_indexed(SDL_Surface *src, int content)
+{
+    int x, y;
+
+    srand(1);
+    for (y = 0; y < src->h; y++)
+    {
+        Uint8 *row = (Uint8 *) src->pixels + y * src->pitch;
+        for (x = 0; x < src->w; x++)
+        {
+            switch (content)
+            {
+                case 0: row[x] = (Uint8) rand(); break;
+                case 1: row[x] = (Uint8) (x / 3 + y / 5); break;
+                case 2: row[x] = (Uint8) ((x / 8 + y / 8) & 15); break;
+                default: row[x] = (Uint8) ((x / 8 + y / 8) & 7); break;
+            }
+        }
+    }
+}
+
+/* One table lookup per pixel, like the original Blit1to2 and Blit1to4 */
+static void reference_blit(SDL_Surface *src, SDL_Surface *dst, int colorkey)
+{
+    Uint32 map[256];
+    SDL_Color *colors = src->format->palette->colors;
+    Uint8 key = (Uint8) src->format->colorkey;
+    int x, y, i;
+
+    for (i = 0; i < src->format->palette->ncolors; i++)
+        map[i] = SDL_MapRGB(dst->format, colors[i].r, colors[i].g, colors[i].b);
+
+    for (y = 0; y < src->h; y++)
+    {
+        const Uint8 *s = (const Uint8 *) src->pixels + y * src->pitch;
+        Uint8 *d = (Uint8 *) dst->pixels + y * dst->pitch;
+        if (dst->format->BytesPerPixel == 2)
+        {
+            Uint16 *d16 = (Uint16 *) d;
+            for (x = 0; x < src->w; x++)
+                if (!colorkey || s[x] != key)
+                    d16[x] = (Uint16) map[s[x]];
+        }
+        else
+        {
+            Uint32 *d32 = (Uint32 *) d;
+            for (x = 0; x < src->w; x++)
+                if (!colorkey || s[x] != key)
+                    d32[x] = map[s[x]];
+        }
+    }
+}
+
+static double time_expansion(SDL_Surface *src, SDL_Surface *dst,
+                             int colorkey, int reference)
+{
+    Uint32 blits = 0;
+    Uint32 start, now;
+
+    start = now = SDL_GetTicks();
+    do
+    {
+        int i;
+        for (i = 0; i < 8; i++)
+        {
+            if (reference)
+                reference_blit(src, dst, colorkey);
+            else
+                SDL_BlitSurface(src, NULL, dst, NULL);
+        }
+        blits += 8;
+        now = SDL_GetTicks();
+    } while ((now - start) < (Uint32) test_ms);
+
+    return ((double) (now - start) * 1000.0) / (double) blits;
+}
+
+static int same_pixels(SDL_Surface *a, SDL_Surface *b)
+{
+    int y;
+    int len = a->w * a->format->BytesPerPixel;
+
+    for (y = 0; y < a->h; y++)
+    {
+        if (memcmp((Uint8 *) a->pixels + y * a->pitch,
+                   (Uint8 *) b->pixels + y * b->pitch, len) != 0)
+            return(0);
+    }
+    return(1);
+}
+
+static void run_expansion(const PixelFormat *fmt, int content, int colorkey,
+                          int w, int h)
+{
+    SDL_Surface *src, *dst, *ref;
+    SDL_Color colors[256];
+    double sdl_us, ref_us;
+    int i, match;
+
+    src = create_surface(&formats[0], w, h);
+    dst = create_surface(fmt, w, h);
+    ref = create_surface(fmt, w, h);
+    if (src == NULL || dst == NULL || ref == NULL)
+    {
+        fprintf(stderr, "Couldn't create %dx%d surfaces: %s\n",
+                w, h, SDL_GetError());
+        SDL_FreeSurface(src);
+        SDL_FreeSurface(dst);
+        SDL_FreeSurface(ref);
+        return;
+    }
+
+    for (i = 0; i < 256; i++)
+    {
+        colors[i].r = (Uint8) i;
+        colors[i].g = (Uint8) (i * 3);
+        colors[i].b = (Uint8) (255 - i);
+        colors[i].unused = 0;
+    }
+    if (content == 3)
+        src->format->palette->ncolors = 8;
+    SDL_SetColors(src, colors, 0, 256);
+    fill_indexed(src, content);
+    if (colorkey)
+        SDL_SetColorKey(src, SDL_SRCCOLORKEY, 3);
+
+    sdl_us = time_expansion(src, dst, colorkey, 0);
+    ref_us = time_expansion(src, ref, colorkey, 1);
+
+    SDL_FillRect(dst, NULL, 0);
+    SDL_FillRect(ref, NULL, 0);
+    SDL_BlitSurface(src, NULL, dst, NULL);
+    reference_blit(src, ref, colorkey);
+    match = same_pixels(dst, ref);
+    if (!match)
+        failures++;
+
+    begin_record();
+    string_field("format", fmt->name);
+    string_field("content", contents[content]);
+    number_field("colorkey", 0, colorkey);
+    number_field("width", 0, w);
+    number_field("height", 0, h);
+    number_field("us_per_blit", 1, sdl_us);
+    number_field("reference_us_per_blit", 1, ref_us);
+    number_field("speedup", 2, ref_us / sdl_us);
+    flag_field("match", match);
+    end_record();
+
+    SDL_FreeSurface(src);
+    SDL_FreeSurface(dst);
+    SDL_FreeSurface(ref);
+}
+
+static void run_expansions(void)
+{
+    size_t f, c;
+    int z, k;
+
+    for (f = 0; f < NUM_FORMATS; f++)
+    {
+        if (!matches(dst_filter, formats[f].name))
+            continue;
+        for (c = 0; c < NUM_CONTENTS; c++)
+        {
+            if (!matches(mode_filter, contents[c]))
+                continue;
+            for (k = 0; k <= 1; k++)
+                for (z = 0; z < num_sizes; z++)
+                    run_expansion(&formats[f], (int) c, k,
+                                  widths[z], heights[z]);
+        }
+    }
+}
+
+/* Sprite and destination formats */
+static const char *sprite_pairs[][2] =
+{
+    { "RGB565", "RGB565" },
+    { "XRGB8888", "XRGB8888" },
+    { "XRGB8888", "RGB565" },
+};
+#define NUM_SPRITE_PAIRS (sizeof (sprite_pairs) / sizeof (sprite_pairs[0]))
+
+static const char *sprite_modes[] =
+{
+    "plain", "rle", "rlelock", "rlepeek", "rlekeep"
+};
+#define NUM_SPRITE_MODES (sizeof (sprite_modes) / sizeof (sprite_modes[0]))
+
+static const PixelFormat *find_format(const char *name)
+{
+    size_t i;
+
+    for (i = 0; i < NUM_FORMATS; i++)
+    {
+        if (strcmp(formats[i].name, name) == 0)
+            return(&formats[i]);
+    }
+    return(NULL);
+}
+
+static void put_pixel(SDL_Surface *surface, int x, int y, Uint32 pixel)
+{
+    Uint8 *p = (Uint8 *) surface->pixels + y * surface->pitch +
+               x * surface->format->BytesPerPixel;
+
+    if (surface->format->BytesPerPixel == 2)
+        *(Uint16 *) p = (Uint16) pixel;
+    else
+        *(Uint32 *) p = pixel;
+}
+
+static Uint32 get_pixel(SDL_Surface *surface, int x, int y)
+{
+    Uint8 *p = (Uint8 *) surface->pixels + y * surface->pitch +
+               x * surface->format->BytesPerPixel;
+
+    if (surface->format->BytesPerPixel == 2)
+        return *(Uint16 *) p;
+    else
+        return *(Uint32 *) p;
+}
+
+static SDL_Surface *make_sprite(const PixelFormat *fmt, int w, int h,
+                                Uint32 *key)
+{
+    SDL_Surface *sprite;
+    int x, y;
+
+    sprite = create_surface(fmt, w, h);
+    if (sprite == NULL)
+        return(NULL);
+
+    *key = SDL_MapRGB(sprite->format, 0xFF, 0x00, 0xFF);
+    for (y = 0; y < h; y++)
+    {
+        for (x = 0; x < w; x++)
+        {
+            int dx = (2 * x - w + 1) * h;
+            int dy = (2 * y - h + 1) * w;
+            if (dx * dx + dy * dy < w * w * h * h)
+                put_pixel(sprite, x, y, SDL_MapRGB(sprite->format,
+                          (Uint8) (x * 255 / w), (Uint8) (y * 255 / h), 0x80));
+            else
+                put_pixel(sprite, x, y, *key);
+        }
+    }
+    return(sprite);
+}
+
+static void run_sprite(const PixelFormat *srcfmt, const PixelFormat *dstfmt,
+                       int w, int h, int mode)
+{
+    SDL_Surface *dst;
+    SDL_Surface *sprite;
+    const char *blitter;
+    Uint32 key;
+    Uint32 blits = 0;
+    Uint32 start, now;
+
+    dst = create_surface(dstfmt, 640, 480);
+    sprite = make_sprite(srcfmt, w, h, &key);
+    if (dst == NULL || sprite == NULL)
+    {
+        fprintf(stderr, "Couldn't create %dx%d surfaces: %s\n",
+                w, h, SDL_GetError());
+        SDL_FreeSurface(dst);
+        SDL_FreeSurface(sprite);
+        return;
+    }
+    SDL_SetColorKey(sprite, SDL_SRCCOLORKEY | (mode ? SDL_RLEACCEL : 0), key);
+    if (mode == 4)
+        SDL_PrepareSurface(sprite, dst, SDL_PREPARE_KEEPRAW);
+
+    start = now = SDL_GetTicks();
+    do
+    {
+        int i;
+        for (i = 0; i < 64; i++)
+        {
+            SDL_Rect r;
+            r.x = (Sint16) (((blits + i) * 37) % (640 - w + 1));
+            r.y = (Sint16) (((blits + i) * 23) % (480 - h + 1));
+            if (mode >= 2)
+            {
+                SDL_LockSurface(sprite);
+                if (mode == 2)
+                    /* Animate the sprite, as if it were drawn into */
+                    put_pixel(sprite, w / 2, h / 2, blits + i);
+                else
+                    /* Read it back, as for a collision check */
+                    key ^= get_pixel(sprite, w / 2, h / 2);
+                SDL_UnlockSurface(sprite);
+            }
+            SDL_BlitSurface(sprite, NULL, dst, &r);
+        }
+        blits += 64;
+        now = SDL_GetTicks();
+    } while ((now - start) < (Uint32) test_ms);
+    now -= start;
+
+    blitter = SDL_GetBlitterName(sprite);
+    begin_record();
+    string_field("src", srcfmt->name);
+    string_field("dst", dstfmt->name);
+    number_field("width", 0, w);
+    number_field("height", 0, h);
+    string_field("mode", sprite_modes[mode]);
+    string_field("blitter", blitter ? blitter : "none");
+    number_field("blits", 0, blits);
+    number_field("ns_per_blit", 0, (now * 1000000.0) / blits);
+    number_field("mpixels_per_sec", 2,
+                 ((double) w * h * blits) / (now * 1000.0));
+    end_record();
+
+    SDL_FreeSurface(sprite);
+    SDL_FreeSurface(dst);
+}
+
+static void run_sprites(void)
+{
+    SDL_BlitCacheStats stats;
+    size_t p, m;
+    int z;
+
+    SDL_GetBlitCacheStats(NULL, 1);
+    for (p = 0; p < NUM_SPRITE_PAIRS; p++)
+    {
+        if (!matches(src_filter, sprite_pairs[p][0]) ||
+            !matches(dst_filter, sprite_pairs[p][1]))
+            continue;
+        for (z = 0; z < num_sizes; z++)
+        {
+            /* The sprite has to fit on the destination */
+            if (widths[z] > 640 || heights[z] > 480)
+            {
+                fprintf(stderr, "Skipping %dx%d sprites, larger than "
+                        "640x480\n", widths[z], heights[z]);
+                continue;
+            }
+            for (m = 0; m < NUM_SPRITE_MODES; m++)
+            {
+                if (!matches(mode_filter, sprite_modes[m]))
+                    continue;
+                run_sprite(find_format(sprite_pairs[p][0]),
+                           find_format(sprite_pairs[p][1]),
+                           widths[z], heights[z], (int) m);
+            }
+        }
+    }
+
+    SDL_GetBlitCacheStats(&stats, 0);
+    fprintf(stderr, "RLE encoded %u surfaces, skipped %u, "
+            "kept %u encodings on unlock\n",
+            (unsigned int) stats.rle_encoded,
+            (unsigned int) stats.rle_skipped,
+            (unsigned int) stats.rle_unchanged);
+}
+
+static Uint32 checksum(SDL_Surface *surface)
+{
+    Uint32 sum = 2166136261u;
+    int len = surface->w * surface->format->BytesPerPixel;
+    int x, y;
+
+    for (y = 0; y < surface->h; y++)
+    {
+        const Uint8 *row = (const Uint8 *) surface->pixels + y * surface->pitch;
+        for (x = 0; x < len; x++)
+            sum = (sum ^ row[x]) * 16777619u;
+    }
+    return(sum);
+}
+
+static const char *stretch_modes[] = { "bilinear", "sharp" };
+#define NUM_STRETCH_MODES (sizeof (stretch_modes) / sizeof (stretch_modes[0]))
+#define STRETCH_SRC_W 37
+#define STRETCH_SRC_H 23
+
+/* The source pixels and weight for each destination pixel along an axis,
+   worked out the way SDL_SoftStretchFilter() documents */
+static void stretch_table(int src_len, int dst_len, int sharp,
+                          int *i0, int *i1, int *f)
+{
+    double scale = (double) src_len / dst_len;
+    int factor = 1;
+    int i, j;
+
+    if (sharp && dst_len > src_len)
+        factor = dst_len / src_len;
+    for (i = 0; i < dst_len; i++)
+    {
+        double u = (i + 0.5) * scale * factor - 0.5;
+        if (u < 0.0)
+            u = 0.0;
+        j = (int) u;
+        i0[i] = j / factor;
+        i1[i] = (j + 1) / factor;
+        f[i] = (int) ((u - j) * 256.0);
+        if (i1[i] >= src_len)
+            i1[i] = src_len - 1;
+        if (i0[i] == i1[i])
+            f[i] = 0;
+    }
+}
+
+/* 0xAARRGGBB, with the low bits of narrower channels left clear */
+static Uint32 get_argb(SDL_Surface *surface, int x, int y)
+{
+    SDL_PixelFormat *fmt = surface->format;
+    Uint32 pixel = get_pixel(surface, x, y);
+    Uint32 a = 0xFF;
+
+    if (fmt->Amask)
+        a = ((pixel & fmt->Amask) >> fmt->Ashift) << fmt->Aloss;
+    return (a << 24) |
+           ((((pixel & fmt->Rmask) >> fmt->Rshift) << fmt->Rloss) << 16) |
+           ((((pixel & fmt->Gmask) >> fmt->Gshift) << fmt->Gloss) << 8) |
+           (((pixel & fmt->Bmask) >> fmt->Bshift) << fmt->Bloss);
+}
+
+/* Each channel weighted by f/256, rounded down */
+static Uint32 lerp_argb(Uint32 a, Uint32 b, int f)
+{
+    Uint32 pixel = 0;
+    int shift;
+
+    for (shift = 0; shift < 32; shift += 8)
+    {
+        Uint32 ca = (a >> shift) & 0xFF;
+        Uint32 cb = (b >> shift) & 0xFF;
+        pixel |= ((ca * (256 - f) + cb * f) >> 8) << shift;
+    }
+    return(pixel);
+}
+
+/* Blend down the columns, then across, one pixel at a time */
+static void reference_stretch(SDL_Surface *src, SDL_Surface *dst, int sharp)
+{
+    int *x0 = (int *) malloc(dst->w * 3 * sizeof (int));
+    int *y0 = (int *) malloc(dst->h * 3 * sizeof (int));
+    int *x1, *fx, *y1, *fy;
+    int x, y;
+
+    if (x0 == NULL || y0 == NULL)
+    {
+        free(x0);
+        free(y0);
+        return;
+    }
+    x1 = x0 + dst->w;
+    fx = x1 + dst->w;
+    y1 = y0 + dst->h;
+    fy = y1 + dst->h;
+    stretch_table(src->w, dst->w, sharp, x0, x1, fx);
+    stretch_table(src->h, dst->h, sharp, y0, y1, fy);
+
+    for (y = 0; y < dst->h; y++)
+    {
+        for (x = 0; x < dst->w; x++)
+        {
+            Uint32 a = lerp_argb(get_argb(src, x0[x], y0[y]),
+                                 get_argb(src, x0[x], y1[y]), fy[y]);
+            Uint32 b = lerp_argb(get_argb(src, x1[x], y0[y]),
+                                 get_argb(src, x1[x], y1[y]), fy[y]);
+            Uint32 p = lerp_argb(a, b, fx[x]);
+            put_pixel(dst, x, y, SDL_MapRGBA(dst->format,
+                      (Uint8) (p >> 16), (Uint8) (p >> 8), (Uint8) p,
+                      (Uint8) (p >> 24)));
+        }
+    }
+    free(x0);
+    free(y0);
+}
+
+static double time_stretch(SDL_Surface *src, SDL_Surface *dst,
+                           int sharp, int reference)
+{
+    Uint32 stretches = 0;
+    Uint32 start, now;
+
+    start = now = SDL_GetTicks();
+    do
+    {
+        int i;
+        for (i = 0; i < 8; i++)
+        {
+            if (reference)
+                reference_stretch(src, dst, sharp);
+            else
+                SDL_SoftStretchFilter(src, NULL, dst, NULL, sharp ?
+                    SDL_STRETCH_SHARP_BILINEAR : SDL_STRETCH_BILINEAR);
+        }
+        stretches += 8;
+        now = SDL_GetTicks();
+    } while ((now - start) < (Uint32) test_ms);
+
+    return ((double) (now - start) * 1000.0) / (double) stretches;
+}
+
+static void run_stretch(const PixelFormat *fmt, int sharp, int w, int h)
+{
+    SDL_Surface *src, *dst, *ref;
+    double sdl_us, ref_us;
+    int match;
+
+    /* get_pixel() and put_pixel() only handle 16 and 32-bit pixels */
+    if (fmt->bpp != 15 && fmt->bpp != 16 && fmt->bpp != 32)
+        return;
+
+    src = create_surface(fmt, STRETCH_SRC_W, STRETCH_SRC_H);
+    dst = create_surface(fmt, w, h);
+    ref = create_surface(fmt, w, h);
+    if (src == NULL || dst == NULL || ref == NULL)
+    {
+        fprintf(stderr, "Couldn't create %dx%d surfaces: %s\n",
+                w, h, SDL_GetError());
+        SDL_FreeSurface(src);
+        SDL_FreeSurface(dst);
+        SDL_FreeSurface(ref);
+        return;
+    }
+    srand(0x5D1);
+    fill_surface(src, 0, 0);
+
+    sdl_us = time_stretch(src, dst, sharp, 0);
+    ref_us = time_stretch(src, ref, sharp, 1);
+
+    SDL_FillRect(dst, NULL, 0);
+    SDL_FillRect(ref, NULL, 0);
+    SDL_SoftStretchFilter(src, NULL, dst, NULL, sharp ?
+        SDL_STRETCH_SHARP_BILINEAR : SDL_STRETCH_BILINEAR);
+    reference_stretch(src, ref, sharp);
+    match = same_pixels(dst, ref);
+    if (!match)
+        failures++;
+
+    begin_record();
+    string_field("format", fmt->name);
+    string_field("mode", stretch_modes[sharp]);
+    number_field("width", 0, w);
+    number_field("height", 0, h);
+    number_field("us_per_stretch", 1, sdl_us);
+    number_field("reference_us_per_stretch", 1, ref_us);
+    number_field("speedup", 2, ref_us / sdl_us);
+    flag_field("match", match);
+    end_record();
+
+    SDL_FreeSurface(src);
+    SDL_FreeSurface(dst);
+    SDL_FreeSurface(ref);
+}
+
+static void run_stretches(void)
+{
+    size_t f, m;
+    int z;
+
+    for (f = 0; f < NUM_FORMATS; f++)
+    {
+        if (!matches(dst_filter, formats[f].name))
+            continue;
+        for (m = 0; m < NUM_STRETCH_MODES; m++)
+        {
+            if (!matches(mode_filter, stretch_modes[m]))
+                continue;
+            for (z = 0; z < num_sizes; z++)
+                run_stretch(&formats[f], (int) m, widths[z], heights[z]);
+        }
+    }
+}
+
+/* Runs this program again to print the C blitters' checksums */
+static FILE *open_reference(void)
+{
+    FILE *ref;
+    char *cmd;
+    size_t len = 64;
+    int i;
+
+    for (i = 0; i < num_args; i++)
+        len += strlen(args[i]) + 3;
+    cmd = (char *) malloc(len);
+    if (cmd == NULL)
+        return(NULL);
+    sprintf(cmd, "\"%s\"", args[0]);
+    for (i = 1; i < num_args; i++)
+        sprintf(cmd + strlen(cmd), " \"%s\"", args[i]);
+    strcat(cmd, " --csv --reference");
+
+    /* Our own CPU features are read once, so the mask only reaches the
+       child once they have been */
+    SDL_HasMMX();
+    SDL_putenv("SDL_CPU_FEATURE_MASK=0");
+    fflush(stdout);
+    ref = popen(cmd, "r");
+    free(cmd);
+    return(ref);
+}
+
+static void verify_blit(const PixelFormat *srcfmt, const PixelFormat *dstfmt,
+                        BlitMode mode, int w, int h, FILE *ref)
+{
+    SDL_Surface *src = create_surface(srcfmt, w, h);
+    SDL_Surface *dst = create_surface(dstfmt, w, h);
+    const char *blitter;
+    char line[256], c_blitter[128];
+    unsigned int c_sum = 0;
+    Uint32 sum;
+    int match;
+
+    if ((src == NULL) || (dst == NULL))
+    {
+        fprintf(stderr, "Couldn't create %dx%d surfaces: %s\n",
+                w, h, SDL_GetError());
+        failures++;
+        goto done;
+    }
+
+    /* The same pixels in this run and the reference one */
+    srand(0x5D1);
+    if (!setup_mode(src, mode))
+        goto done;
+    fill_surface(dst, 0, 0);
+
+    if (SDL_BlitSurface(src, NULL, dst, NULL) < 0)
+        goto done;
+    blitter = SDL_GetBlitterName(src);
+    if (blitter == NULL)
+        blitter = "unknown";
+    sum = checksum(dst);
+
+    if (reference)
+    {
+        char hex[9];
+        sprintf(hex, "%08x", (unsigned int) sum);
+        begin_record();
+        string_field("blitter", blitter);
+        string_field("checksum", hex);
+        end_record();
+        goto done;
+    }
+
+    strcpy(c_blitter, "none");
+    if ((ref == NULL) || (fgets(line, sizeof (line), ref) == NULL) ||
+        (sscanf(line, "%127[^,],%x", c_blitter, &c_sum) != 2))
+        match = 0;
+    else
+        match = (sum == c_sum);
+    if (!match)
+        failures++;
+
+    begin_record();
+    string_field("src", srcfmt->name);
+    string_field("dst", dstfmt->name);
+    string_field("mode", mode_names[mode]);
+    number_field("width", 0, w);
+    number_field("height", 0, h);
+    string_field("blitter", blitter);
+    string_field("c_blitter", c_blitter);
+    flag_field("match", match);
+    end_record();
+
+done:
+    if (src != NULL)
+        SDL_FreeSurface(src);
+    if (dst != NULL)
+        SDL_FreeSurface(dst);
+}
+
+static void run_verify(void)
+{
+    FILE *ref = NULL;
+    size_t s, d;
+    int m, z;
+
+    if (!reference)
+    {
+        char line[256];
+        ref = open_reference();
+        /* Skip the reference's header line */
+        if ((ref == NULL) || (fgets(line, sizeof (line), ref) == NULL))
+            fprintf(stderr, "Couldn't run the reference blits\n");
+    }
+
+    for (s = 0; s < NUM_FORMATS; s++)
+    {
+        if (!matches(src_filter, formats[s].name))
+            continue;
+        for (d = 0; d < NUM_FORMATS; d++)
+        {
+            if (!matches(dst_filter, formats[d].name))
+                continue;
+            for (m = 0; m < NUM_MODES; m++)
+            {
+                if (!matches(mode_filter, mode_names[m]))
+                    continue;
+                for (z = 0; z < num_sizes; z++)
+                    verify_blit(&formats[s], &formats[d], (BlitMode) m,
+                                widths[z], heights[z], ref);
+            }
+        }
+    }
+
+    if (ref != NULL)
+        pclose(ref);
+}
+
+typedef struct
+{
+    const char *name;
+    void (*run)(void);
+    const char *columns;        /* the CSV header line */
+    const char *sizes;          /* used without --sizes */
+    const char *dst;            /* used without --dst */
+    const char *modes;          /* what --mode picks from */
+} Benchmark;
+
+static const Benchmark benchmarks[] =
+{
+    { "blit", run_blits,
+      "src,dst,mode,width,height,blitter,blits,ns_per_blit,mpixels_per_sec",
+      "64x64,320x240,640x480,1280x720", NULL,
+      "copy, colorkey, surfalpha, pixelalpha, rle" },
+    { "fill", run_fills,
+      "format,width,height,align,fills,ns_per_fill,mpixels_per_sec,gbytes_per_sec",
+      "64x64,320x240,640x480,1280x720,1920x1080",
+      "INDEX8,RGB565,RGB888,XRGB8888", NULL },
+    { "palexpand", run_expansions,
+      "format,content,colorkey,width,height,us_per_blit,reference_us_per_blit,speedup,match",
+      "320x240,640x480", "RGB565,XRGB8888",
+      "noise, gradient, 16colors, shortpal" },
+    { "colorkey", run_sprites,
+      "src,dst,width,height,mode,blitter,blits,ns_per_blit,mpixels_per_sec",
+      "16x16,32x32,64x64,128x128,256x256", NULL,
+      "plain, rle, rlelock, rlepeek, rlekeep" },
+    { "stretch", run_stretches,
+      "format,mode,width,height,us_per_stretch,reference_us_per_stretch,speedup,match",
+      "17x11,100x61,320x240", "RGB565,XRGB8888,ARGB8888",
+      "bilinear, sharp" },
+    { "verify", run_verify,
+      "src,dst,mode,width,height,blitter,c_blitter,match",
+      "61x17,128x32", NULL,
+      "copy, colorkey, surfalpha, pixelalpha, rle" },
+};
+#define NUM_BENCHMARKS (sizeof (benchmarks) / sizeof (benchmarks[0]))
+
+static void usage(const char *argv0)
+{
+    size_t i;
+
+    fprintf(stderr,
+        "USAGE: %s [--bench NAME] [--csv | --json] [--ms milliseconds]\n"
+        "       [--sizes WxH[,WxH...]] [--src FORMAT[,...]] [--dst FORMAT[,...]]\n"
+        "       [--mode MODE[,...]] [--aligned] [--reference]\n\n"
+        "Benchmarks and their modes:\n", argv0);
+    for (i = 0; i < NUM_BENCHMARKS; i++)
+    {
+        if (benchmarks[i].modes)
+            fprintf(stderr, "  %-10s %s\n", benchmarks[i].name,
+                    benchmarks[i].modes);
+        else
+            fprintf(stderr, "  %s\n", benchmarks[i].name);
+    }
+    fprintf(stderr, "Formats:");
+    for (i = 0; i < NUM_FORMATS; i++)
+        fprintf(stderr, " %s", formats[i].name);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+    const Benchmark *bench = &benchmarks[0];
+    size_t b;
+    int i;
+
+    num_args = argc;
+    args = argv;
+    for (i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+
+        if ((strcmp(arg, "--bench") == 0) && (i+1 < argc))
+        {
+            i++;
+            for (b = 0; b < NUM_BENCHMARKS; b++)
+            {
+                if (strcmp(argv[i], benchmarks[b].name) == 0)
+                    break;
+            }
+            if (b == NUM_BENCHMARKS)
+            {
+                usage(argv[0]);
+                return(1);
+            }
+            bench = &benchmarks[b];
+        }
+        else if (strcmp(arg, "--csv") == 0)
+            json = 0;
+        else if (strcmp(arg, "--json") == 0)
+            json = 1;
+        else if ((strcmp(arg, "--ms") == 0) && (i+1 < argc))
+            test_ms = atoi(argv[++i]);
+        else if ((strcmp(arg, "--sizes") == 0) && (i+1 < argc))
+        {
+            if (!parse_sizes(argv[++i]))
+            {
+                fprintf(stderr, "Bad size list: %s\n", argv[i]);
+                return(1);
+            }
+        }
+        else if (strcmp(arg, "--aligned") == 0)
+            surface_flags |= SDL_SIMDALIGNED;
+        else if (strcmp(arg, "--reference") == 0)
+            reference = 1;
+        else if ((strcmp(arg, "--src") == 0) && (i+1 < argc))
+            src_filter = argv[++i];
+        else if ((strcmp(arg, "--dst") == 0) && (i+1 < argc))
+            dst_filter = argv[++i];
+        else if ((strcmp(arg, "--mode") == 0) && (i+1 < argc))
+            mode_filter = argv[++i];
+        else
+        {
+            usage(argv[0]);
+            return(1);
+        }
+    }
+    if (test_ms <= 0)
+        test_ms = 1;
+    if (num_sizes == 0)
+        parse_sizes(bench->sizes);
+    if (dst_filter == NULL)
+        dst_filter = bench->dst;
+
+    /* Run headless unless the caller asked for a specific driver */
+    if (getenv("SDL_VIDEODRIVER") == NULL)
+        SDL_putenv("SDL_VIDEODRIVER=dummy");
+
+    if (SDL_Init(SDL_INIT_VIDEO) == -1)
+    {
+        fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
+        return(1);
+    }
+
+    if (json)
+        printf("[\n");
+    else if (reference)
+        printf("blitter,checksum\n");
+    else
+        printf("%s\n", bench->columns);
+
+    bench->run();
+
+    if (json)
+        printf("\n]\n");
+
+    SDL_Quit();
+    return(failures ? 1 : 0);
+}
+
+/* end of testblitmatrix.c ... */
+
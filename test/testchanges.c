@@ -0,0 +1,381 @@
+/* Checks that changed pixels are never mistaken for unchanged ones by
+   SDL_VIDEO_FRAME_DIFF, which drops screen updates of tiles it thinks
+   haven't changed, including across video mode changes, or by
+   SDL_PREPARE_KEEPRAW, which only encodes a surface again after a lock
+   if its pixels changed.  Also checks how many rectangles
+   SDL_VIDEO_COALESCE_RECTS merges a few known updates into, alone and
+   after SDL_VIDEO_FRAME_DIFF.  Runs headless and returns non-zero on
+   failure.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SDL.h"
+
+static int verbose = 0;
+
+static void SetPixel16(SDL_Surface *surface, int x, int y, Uint16 pixel)
+{
+	*(Uint16 *)((Uint8 *)surface->pixels + y*surface->pitch + x*2) = pixel;
+}
+
+static Uint16 GetPixel16(SDL_Surface *surface, int x, int y)
+{
+	return *(Uint16 *)((Uint8 *)surface->pixels + y*surface->pitch + x*2);
+}
+
+/* Update the whole screen, returning how many rectangles reached the driver */
+static Uint32 UpdateScreen(SDL_Surface *screen)
+{
+	SDL_UpdateStats stats;
+
+	SDL_GetUpdateStats(NULL, 1);
+	SDL_UpdateRect(screen, 0, 0, 0, 0);
+	SDL_GetUpdateStats(&stats, 0);
+	return stats.rects_out;
+}
+
+int TestFrameDiff(void)
+{
+	SDL_Surface *screen;
+	int error = 0;
+	int i, a, b;
+
+	screen = SDL_SetVideoMode(64, 64, 16, SDL_SWSURFACE);
+	if ( screen == NULL ) {
+		printf("Couldn't set 64x64x16 video mode: %s\n", SDL_GetError());
+		return 1;
+	}
+	SDL_FillRect(screen, NULL, 0);
+	if ( UpdateScreen(screen) == 0 ) {
+		printf("Frame diff: the first frame wasn't sent\n");
+		++error;
+	}
+	if ( UpdateScreen(screen) != 0 ) {
+		printf("Frame diff: an unchanged frame was sent\n");
+		++error;
+	}
+
+	/* The top bit of two pixels flipped, two rows apart in one tile */
+	SetPixel16(screen, 1, 0, 0x8000);
+	SetPixel16(screen, 1, 2, 0x8000);
+	if ( UpdateScreen(screen) == 0 ) {
+		printf("Frame diff: pixels (1,0) and (1,2) changed, "
+		       "but nothing was sent\n");
+		++error;
+	}
+
+	/* Pairs of changes with opposite signs in the first tile */
+	srand(1);
+	for ( i = 0; i < 1000; ++i ) {
+		Uint16 *pixels = (Uint16 *)screen->pixels;
+		int pitch = screen->pitch / 2;
+		Uint16 delta = (Uint16)(1 << (rand() % 16));
+
+		a = rand() % (32*32);
+		do {
+			b = rand() % (32*32);
+		} while ( b == a );
+		pixels[(a / 32) * pitch + (a % 32)] += delta;
+		pixels[(b / 32) * pitch + (b % 32)] -= delta;
+		if ( UpdateScreen(screen) == 0 ) {
+			printf("Frame diff: change %d at (%d,%d) and (%d,%d) "
+			       "was dropped\n", i, a % 32, a / 32, b % 32, b / 32);
+			++error;
+			break;
+		}
+	}
+	if ( verbose && !error ) {
+		printf("Frame diff sent every changed frame.\n");
+	}
+	return error ? 1 : 0;
+}
+
+int TestModeReset(void)
+{
+	SDL_Surface *screen;
+	int error = 0;
+
+	/* The same size windowed mode again keeps the same screen surface */
+	screen = SDL_SetVideoMode(64, 64, 16, SDL_SWSURFACE);
+	if ( screen == NULL ) {
+		printf("Couldn't set 64x64x16 video mode: %s\n", SDL_GetError());
+		return 1;
+	}
+	SDL_FillRect(screen, NULL, 0x1234);
+	UpdateScreen(screen);
+	screen = SDL_SetVideoMode(64, 64, 16, SDL_SWSURFACE);
+	if ( screen == NULL ) {
+		printf("Couldn't set 64x64x16 video mode: %s\n", SDL_GetError());
+		return 1;
+	}
+	SDL_FillRect(screen, NULL, 0x1234);
+	if ( UpdateScreen(screen) == 0 ) {
+		printf("Frame diff: the first frame after a mode change "
+		       "wasn't sent\n");
+		++error;
+	}
+	if ( verbose && !error ) {
+		printf("Frame diff sent the first frame of a new mode.\n");
+	}
+	return error ? 1 : 0;
+}
+
+/* Blit the sprite and check that every opaque pixel arrived */
+static int BlitMatches(SDL_Surface *sprite, SDL_Surface *dst)
+{
+	int x, y;
+
+	SDL_FillRect(dst, NULL, 0);
+	SDL_BlitSurface(sprite, NULL, dst, NULL);
+	for ( y = 0; y < sprite->h; ++y ) {
+		for ( x = 0; x < sprite->w; ++x ) {
+			Uint16 pixel = GetPixel16(sprite, x, y);
+			if ( pixel != 0 && GetPixel16(dst, x, y) != pixel ) {
+				printf("KEEPRAW: blitted 0x%.4x at (%d,%d), "
+				       "the sprite has 0x%.4x\n",
+				       GetPixel16(dst, x, y), x, y, pixel);
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+int TestKeepRaw(void)
+{
+	SDL_Surface *sprite, *dst;
+	int error = 0;
+	int i, a, b, x, y;
+
+	sprite = SDL_CreateRGBSurface(SDL_SWSURFACE, 256, 256, 16,
+	                              0xF800, 0x07E0, 0x001F, 0);
+	dst = SDL_CreateRGBSurface(SDL_SWSURFACE, 256, 256, 16,
+	                           0xF800, 0x07E0, 0x001F, 0);
+	if ( sprite == NULL || dst == NULL ) {
+		printf("Couldn't create surfaces: %s\n", SDL_GetError());
+		return 1;
+	}
+	/* Opaque 0x1234 with a transparent border, for runs to encode */
+	SDL_FillRect(sprite, NULL, 0);
+	for ( y = 0; y < 256; ++y ) {
+		for ( x = 1; x < 255; ++x ) {
+			SetPixel16(sprite, x, y, 0x1234);
+		}
+	}
+	SDL_SetColorKey(sprite, SDL_SRCCOLORKEY|SDL_RLEACCEL, 0);
+	SDL_PrepareSurface(sprite, dst, SDL_PREPARE_KEEPRAW);
+	if ( !BlitMatches(sprite, dst) ) {
+		++error;
+	}
+
+	/* The top bit of two opaque pixels flipped, two rows apart */
+	SDL_LockSurface(sprite);
+	SetPixel16(sprite, 1, 0, GetPixel16(sprite, 1, 0) ^ 0x8000);
+	SetPixel16(sprite, 1, 2, GetPixel16(sprite, 1, 2) ^ 0x8000);
+	SDL_UnlockSurface(sprite);
+	if ( !BlitMatches(sprite, dst) ) {
+		++error;
+	}
+
+	/* Pairs of changes with opposite signs */
+	srand(2);
+	for ( i = 0; i < 200 && !error; ++i ) {
+		Uint16 delta = (Uint16)(1 << (rand() % 15));
+
+		a = rand() % (256*254);
+		do {
+			b = rand() % (256*254);
+		} while ( b == a );
+		SDL_LockSurface(sprite);
+		x = 1 + a % 254;
+		y = a / 254;
+		SetPixel16(sprite, x, y, (GetPixel16(sprite, x, y) + delta) | 1);
+		x = 1 + b % 254;
+		y = b / 254;
+		SetPixel16(sprite, x, y, (GetPixel16(sprite, x, y) - delta) | 1);
+		SDL_UnlockSurface(sprite);
+		if ( !BlitMatches(sprite, dst) ) {
+			printf("KEEPRAW: change %d was lost\n", i);
+			++error;
+		}
+	}
+	if ( verbose && !error ) {
+		printf("KEEPRAW surfaces were encoded again after every change.\n");
+	}
+	SDL_FreeSurface(sprite);
+	SDL_FreeSurface(dst);
+	return error ? 1 : 0;
+}
+
+/* Update the rectangles, returning the stats for just this update */
+static SDL_UpdateStats UpdateRects(SDL_Surface *screen,
+                                   int numrects, SDL_Rect *rects)
+{
+	SDL_UpdateStats stats;
+
+	SDL_GetUpdateStats(NULL, 1);
+	SDL_UpdateRects(screen, numrects, rects);
+	SDL_GetUpdateStats(&stats, 0);
+	return stats;
+}
+
+static int CheckUpdate(const char *what, const SDL_UpdateStats *stats,
+                       Uint32 rects_out, Uint32 pixels_out)
+{
+	if ( stats->rects_out != rects_out || stats->pixels_out != pixels_out ) {
+		printf("Coalesce: %s sent %u rects of %u pixels, "
+		       "expected %u rects of %u pixels\n", what,
+		       (unsigned int)stats->rects_out,
+		       (unsigned int)stats->pixels_out,
+		       (unsigned int)rects_out, (unsigned int)pixels_out);
+		return 1;
+	}
+	return 0;
+}
+
+static void SetRect(SDL_Rect *rect, int x, int y, int w, int h)
+{
+	rect->x = x;
+	rect->y = y;
+	rect->w = w;
+	rect->h = h;
+}
+
+/* Run with the default 16 pixel tiles and a rectangle cost of 2048
+   pixels, or 8 tiles */
+int TestCoalesce(void)
+{
+	SDL_Surface *screen;
+	SDL_UpdateStats stats;
+	SDL_Rect rects[100];
+	int error = 0;
+	int i;
+
+	screen = SDL_SetVideoMode(256, 256, 16, SDL_SWSURFACE);
+	if ( screen == NULL ) {
+		printf("Couldn't set 256x256x16 video mode: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	/* Overlapping sprites inside one tile become their bounding box */
+	for ( i = 0; i < 100; ++i ) {
+		SetRect(&rects[i], 2 + i % 8, 3 + i / 20, 4, 4);
+	}
+	stats = UpdateRects(screen, 100, rects);
+	error += CheckUpdate("100 rects in one tile", &stats, 1, 11 * 8);
+
+	/* Tiles one tile apart are joined across the gap */
+	SetRect(&rects[0], 0, 0, 16, 16);
+	SetRect(&rects[1], 32, 0, 16, 16);
+	stats = UpdateRects(screen, 2, rects);
+	error += CheckUpdate("2 rects one tile apart", &stats, 1, 48 * 16);
+
+	/* Opposite corners would cost more joined, so are left alone */
+	SetRect(&rects[0], 0, 0, 16, 16);
+	SetRect(&rects[1], 240, 240, 16, 16);
+	stats = UpdateRects(screen, 2, rects);
+	error += CheckUpdate("2 rects in opposite corners", &stats,
+	                     2, 2 * 16 * 16);
+
+	/* A column of rows in adjacent tiles becomes one rectangle */
+	for ( i = 0; i < 16; ++i ) {
+		SetRect(&rects[i], 64, 64 + i * 4, 64, 4);
+	}
+	stats = UpdateRects(screen, 16, rects);
+	error += CheckUpdate("16 stacked rects", &stats, 1, 64 * 64);
+
+	if ( verbose && !error ) {
+		printf("Coalescing merged updates as expected.\n");
+	}
+	return error ? 1 : 0;
+}
+
+/* Run with SDL_VIDEO_FRAME_DIFF and its default 32 pixel tiles too */
+int TestDiffCoalesce(void)
+{
+	SDL_Surface *screen;
+	SDL_UpdateStats stats;
+	SDL_Rect rect;
+	int error = 0;
+
+	screen = SDL_SetVideoMode(256, 256, 16, SDL_SWSURFACE);
+	if ( screen == NULL ) {
+		printf("Couldn't set 256x256x16 video mode: %s\n", SDL_GetError());
+		return 1;
+	}
+	SDL_FillRect(screen, NULL, 0);
+	SetRect(&rect, 0, 0, 256, 256);
+	UpdateRects(screen, 1, &rect);
+
+	/* Two changed tiles out of 64 are kept, then joined across the gap */
+	SetPixel16(screen, 5, 5, 0x1234);
+	SetPixel16(screen, 70, 5, 0x1234);
+	stats = UpdateRects(screen, 1, &rect);
+	if ( stats.tiles_checked != 64 || stats.tiles_changed != 2 ) {
+		printf("Coalesce: frame diff found %u changed tiles of %u, "
+		       "expected 2 of 64\n", (unsigned int)stats.tiles_changed,
+		       (unsigned int)stats.tiles_checked);
+		++error;
+	}
+	error += CheckUpdate("2 changed tiles", &stats, 1, 96 * 32);
+
+	/* Nothing changed, so nothing is left to merge */
+	stats = UpdateRects(screen, 1, &rect);
+	error += CheckUpdate("an unchanged frame", &stats, 0, 0);
+
+	if ( verbose && !error ) {
+		printf("Coalescing merged the changed tiles as expected.\n");
+	}
+	return error ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int status = 0;
+
+	if ( argv[1] && (SDL_strcmp(argv[1], "-v") == 0) ) {
+		verbose = 1;
+	}
+
+	/* Run headless unless the caller asked for a specific driver */
+	if ( getenv("SDL_VIDEODRIVER") == NULL ) {
+		SDL_putenv("SDL_VIDEODRIVER=dummy");
+	}
+	SDL_putenv("SDL_VIDEO_FRAME_DIFF=1");
+	if ( SDL_Init(SDL_INIT_VIDEO) < 0 ) {
+		fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	status += TestFrameDiff();
+	status += TestModeReset();
+	status += TestKeepRaw();
+
+	/* The damage settings are read when the video subsystem starts */
+	SDL_QuitSubSystem(SDL_INIT_VIDEO);
+	SDL_putenv("SDL_VIDEO_FRAME_DIFF=0");
+	SDL_putenv("SDL_VIDEO_COALESCE_RECTS=1");
+	if ( SDL_InitSubSystem(SDL_INIT_VIDEO) < 0 ) {
+		fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+		return 1;
+	}
+	status += TestCoalesce();
+
+	SDL_QuitSubSystem(SDL_INIT_VIDEO);
+	SDL_putenv("SDL_VIDEO_FRAME_DIFF=1");
+	if ( SDL_InitSubSystem(SDL_INIT_VIDEO) < 0 ) {
+		fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+		return 1;
+	}
+	status += TestDiffCoalesce();
+
+	SDL_Quit();
+	if ( status ) {
+		printf("%d test(s) failed\n", status);
+	} else {
+		printf("All change detection tests passed.\n");
+	}
+	return status;
+}
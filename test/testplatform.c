@@ -137,7 +137,12 @@ int TestCPUInfo(SDL_bool verbose)
 		printf("3DNow Ext %s\n", SDL_Has3DNowExt() ? "detected" : "not detected");
 		printf("SSE %s\n", SDL_HasSSE() ? "detected" : "not detected");
 		printf("SSE2 %s\n", SDL_HasSSE2() ? "detected" : "not detected");
+		printf("AVX2 %s\n", SDL_HasAVX2() ? "detected" : "not detected");
 		printf("AltiVec %s\n", SDL_HasAltiVec() ? "detected" : "not detected");
+		printf("ARM SIMD %s\n", SDL_HasARMSIMD() ? "detected" : "not detected");
+		printf("VFPv3 %s\n", SDL_HasVFPv3() ? "detected" : "not detected");
+		printf("VFPv4 %s\n", SDL_HasVFPv4() ? "detected" : "not detected");
+		printf("NEON %s\n", SDL_HasNEON() ? "detected" : "not detected");
 	}
 	return(0);
 }